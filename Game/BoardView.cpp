@@ -0,0 +1,440 @@
+#include "BoardView.hpp"
+
+
+BoardView::BoardView(Vector2f center, float cellSize):
+    cellSize(cellSize),
+    center(center),
+    graphicsDirty(true),
+    cachedGameId(0),
+    cachedRevision(0),
+    gridVertices(PrimitiveType::Lines),
+    xVertices(PrimitiveType::Lines),
+    oVertices(PrimitiveType::Lines),
+    highlightVertices(PrimitiveType::TriangleStrip),
+    profiler(nullptr) {}
+
+Vector2f BoardView::toPixel(const Position &pos) const {
+    return Vector2f(center.x + (pos.x + 0.5f) * cellSize, center.y + (pos.y + 0.5f) * cellSize);
+}
+
+Vector2f BoardView::toCorner(const Position &pos) const {
+    return Vector2f(center.x + pos.x * cellSize, center.y + pos.y * cellSize);
+}
+
+Position BoardView::toCell(const Vector2f &worldPos) const {
+    int gridX = static_cast<int>(floor((worldPos.x - center.x) / cellSize));
+    int gridY = static_cast<int>(floor((worldPos.y - center.y) / cellSize));
+    return Position(gridX, gridY);
+}
+
+void BoardView::updateGraphics(const GameSnapshot &game) const {
+    FrameProfiler::ScopedTimer timer(profiler, FrameProfiler::Stage::GRAPHICS);
+    if (!graphicsDirty && cachedGameId == game.gameId && cachedRevision == game.revision) return;
+    TraceScope trace("updateGraphics", "render");
+
+    const GameBoard &board = *game.board;
+    const vector<Position> &winLine = game.winLine;
+    GameMode mode = game.mode;
+    
+    gridVertices.clear();
+    xVertices.clear();
+    oVertices.clear();
+    highlightVertices.clear();
+    
+    int minX, maxX, minY, maxY;
+    board.getBounds(minX, maxX, minY, maxY);
+    
+    int visibleMargin = 1;
+    int visibleMinX = minX - visibleMargin;
+    int visibleMaxX = maxX + visibleMargin;
+    int visibleMinY = minY - visibleMargin;
+    int visibleMaxY = maxY + visibleMargin;
+    
+    const float halfCell = cellSize * 0.5f;
+    const float offset = cellSize * 0.35f;
+    
+    Color gridColor(100, 100, 100, 100);
+    
+    for (int x = visibleMinX; x <= visibleMaxX + 1; x++) {
+        float pixelX = center.x + x * cellSize;
+        Vertex v1, v2;
+        v1.position = Vector2f(pixelX, center.y + visibleMinY * cellSize);
+        v1.color = gridColor;
+        v2.position = Vector2f(pixelX, center.y + (visibleMaxY + 1) * cellSize);
+        v2.color = gridColor;
+        gridVertices.append(v1);
+        gridVertices.append(v2);
+    }
+    
+    for (int y = visibleMinY; y <= visibleMaxY + 1; y++) {
+        float pixelY = center.y + y * cellSize;
+        Vertex v1, v2;
+        v1.position = Vector2f(center.x + visibleMinX * cellSize, pixelY);
+        v1.color = gridColor;
+        v2.position = Vector2f(center.x + (visibleMaxX + 1) * cellSize, pixelY);
+        v2.color = gridColor;
+        gridVertices.append(v1);
+        gridVertices.append(v2);
+    }
+    
+    for (int x = visibleMinX; x <= visibleMaxX; x++) {
+        for (int y = visibleMinY; y <= visibleMaxY; y++) {
+            Position pos(x, y);
+            Cell cell = board.get(pos);
+            
+            if (cell == Cell::EMPTY) continue;
+            
+            Vector2f pixelPos = toPixel(pos);
+            
+            if (cell == Cell::X) {
+                Color xColor = Color::Red;
+                
+                Vertex v1, v2;
+                v1.position = Vector2f(pixelPos.x - offset, pixelPos.y - offset);
+                v1.color = xColor;
+                v2.position = Vector2f(pixelPos.x + offset, pixelPos.y + offset);
+                v2.color = xColor;
+                xVertices.append(v1);
+                xVertices.append(v2);
+                
+                Vertex v3, v4;
+                v3.position = Vector2f(pixelPos.x + offset, pixelPos.y - offset);
+                v3.color = xColor;
+                v4.position = Vector2f(pixelPos.x - offset, pixelPos.y + offset);
+                v4.color = xColor;
+                xVertices.append(v3);
+                xVertices.append(v4);
+            } 
+            else if (cell == Cell::O) {
+                Color oColor = Color::Blue;
+                const int segments = 24;
+                float radius = cellSize * 0.25f;
+                
+                for (int i = 0; i < segments; i++) {
+                    float angle1 = 2 * 3.14159f * i / segments;
+                    float angle2 = 2 * 3.14159f * (i + 1) / segments;
+                    
+                    Vertex v1, v2;
+                    v1.position = Vector2f(
+                        pixelPos.x + cos(angle1) * radius, 
+                        pixelPos.y + sin(angle1) * radius
+                    );
+                    v1.color = oColor;
+                    v2.position = Vector2f(
+                        pixelPos.x + cos(angle2) * radius, 
+                        pixelPos.y + sin(angle2) * radius
+                    );
+                    v2.color = oColor;
+                    oVertices.append(v1);
+                    oVertices.append(v2);
+                }
+            }
+        }
+    }
+    
+    if (!winLine.empty() && (mode == GameMode::CLASSIC || mode == GameMode::TIMED)) {
+        Color highlightColor(255, 255, 0, 100);
+        for (const auto &pos : winLine) {
+            Vector2f pixelPos = toPixel(pos);
+            Vertex v1, v2, v3, v4;
+            v1.position = Vector2f(pixelPos.x - halfCell + 2, pixelPos.y - halfCell + 2);
+            v1.color = highlightColor;
+            v2.position = Vector2f(pixelPos.x + halfCell - 2, pixelPos.y - halfCell + 2);
+            v2.color = highlightColor;
+            v3.position = Vector2f(pixelPos.x - halfCell + 2, pixelPos.y + halfCell - 2);
+            v3.color = highlightColor;
+            v4.position = Vector2f(pixelPos.x + halfCell - 2, pixelPos.y + halfCell - 2);
+            v4.color = highlightColor;
+            
+            highlightVertices.append(v1);
+            highlightVertices.append(v2);
+            highlightVertices.append(v3);
+            highlightVertices.append(v4);
+        }
+    }
+    
+    graphicsDirty = false;
+    cachedGameId = game.gameId;
+    cachedRevision = game.revision;
+    if (profiler) profiler->getLatency().mark(LatencyTracker::Mark::GRAPHICS);
+}
+
+void BoardView::draw(RenderWindow &window, const GameSnapshot &game) const {
+    updateGraphics(game);
+    
+    VertexArray axes(PrimitiveType::Lines, 4);
+    axes[0].position = Vector2f(0, center.y);
+    axes[0].color = Color(150, 150, 150, 150);
+    axes[1].position = Vector2f(window.getSize().x, center.y);
+    axes[1].color = Color(150, 150, 150, 150);
+    axes[2].position = Vector2f(center.x, 0);
+    axes[2].color = Color(150, 150, 150, 150);
+    axes[3].position = Vector2f(center.x, window.getSize().y);
+    axes[3].color = Color(150, 150, 150, 150);
+    window.draw(axes);
+    
+    if (gridVertices.getVertexCount() > 0) window.draw(gridVertices);
+    if (highlightVertices.getVertexCount() > 0) window.draw(highlightVertices);
+    if (xVertices.getVertexCount() > 0) window.draw(xVertices);
+    if (oVertices.getVertexCount() > 0) window.draw(oVertices);
+    
+    CircleShape centerPoint(5);
+    centerPoint.setFillColor(Color::Green);
+    centerPoint.setPosition(Vector2f(center.x - 2.5f, center.y - 2.5f));
+    window.draw(centerPoint);
+}
+
+void BoardView::drawUI(RenderWindow &window, const Font &font, const GameSnapshot &game) const {
+    GameMode mode = game.mode;
+    Cell currentPlayer = game.currentPlayer;
+    Cell winner = game.winner;
+    int winningLength = game.winningLength;
+    int targetScore = game.targetScore;
+    auto [playerXScore, playerOScore] = game.score;
+
+    RectangleShape infoPanel;
+    infoPanel.setSize(Vector2f(280, 210));
+    infoPanel.setFillColor(Color(40, 40, 40, 220));
+    infoPanel.setPosition(Vector2f(10, 10));
+    window.draw(infoPanel);
+    
+    Text currentPlayerText(font, L"Текущий: " + String(currentPlayer == Cell::X ? L"X" : L"O"), 20);
+    currentPlayerText.setFillColor(currentPlayer == Cell::X ? Color::Red : Color::Blue);
+    currentPlayerText.setPosition(Vector2f(20, 20));
+    window.draw(currentPlayerText);
+    
+    String modeStr;
+    switch (mode) {
+        case GameMode::CLASSIC: modeStr = L"Классический"; break;
+        case GameMode::TIMED: modeStr = L"С таймером"; break;
+        case GameMode::SCORING: modeStr = L"Система очков"; break;
+        case GameMode::RANDOM_EVENTS: modeStr = L"Случайные события"; break;
+    }
+    
+    Text modeText(font, L"Режим: " + modeStr, 16);
+    modeText.setFillColor(Color::White);
+    modeText.setPosition(Vector2f(20, 50));
+    window.draw(modeText);
+    
+    if (mode == GameMode::CLASSIC || mode == GameMode::TIMED) {
+        Text lengthText(font, L"Линия: " + to_wstring(winningLength), 16);
+        lengthText.setFillColor(Color::White);
+        lengthText.setPosition(Vector2f(20, 75));
+        window.draw(lengthText);
+    }
+
+    if (mode == GameMode::CLASSIC) {
+        String opponentStr;
+        if (game.opponentType == OpponentType::PLAYER_VS_PLAYER) {
+            opponentStr = L"Игрок";
+        } else {
+            opponentStr = L"Бот";
+            String difficultyStr;
+            switch (game.botDifficulty) {
+                case BotDifficulty::EASY: difficultyStr = L" (лёгкий)"; break;
+                case BotDifficulty::MEDIUM: difficultyStr = L" (средний)"; break;
+                case BotDifficulty::HARD: difficultyStr = L" (сложный)"; break;
+                case BotDifficulty::EXPERT: difficultyStr = L" (эксперт)"; break;
+            }
+            opponentStr += difficultyStr;
+        }
+        
+        Text opponentText(font, L"Противник: " + opponentStr, 14);
+        opponentText.setFillColor(Color::Green);
+        opponentText.setPosition(Vector2f(20, 100));
+        window.draw(opponentText);
+    }
+    
+    if (mode == GameMode::SCORING || mode == GameMode::RANDOM_EVENTS) {
+        Text scoreText(font, L"Счет: X=" + to_wstring(playerXScore) + L" O=" + to_wstring(playerOScore), 16);
+        scoreText.setFillColor(Color::White);
+        scoreText.setPosition(Vector2f(20, 75));
+        window.draw(scoreText);
+        
+        if (mode == GameMode::RANDOM_EVENTS) {
+            auto [playerXBaseScore, playerOBaseScore] = game.baseScore;
+            auto [playerXBonusScore, playerOBonusScore] = game.bonusScore;
+
+            Text baseText(font, L"Базовые: X=" + to_wstring(playerXBaseScore) + L" O=" + to_wstring(playerOBaseScore), 14);
+            baseText.setFillColor(Color::Green);
+            baseText.setPosition(Vector2f(20, 100));
+            window.draw(baseText);
+            
+            Text bonusText(font, L"Бонусы: X=" + to_wstring(playerXBonusScore) + L" O=" + to_wstring(playerOBonusScore), 14);
+            bonusText.setFillColor(Color::Cyan);
+            bonusText.setPosition(Vector2f(20, 125));
+            window.draw(bonusText);
+            
+            Text targetText(font, L"Цель: " + to_wstring(targetScore), 16);
+            targetText.setFillColor(Color::Yellow);
+            targetText.setPosition(Vector2f(20, 150));
+            window.draw(targetText);
+        } else {
+            Text targetText(font, L"Цель: " + to_wstring(targetScore), 16);
+            targetText.setFillColor(Color::Yellow);
+            targetText.setPosition(Vector2f(20, 100));
+            window.draw(targetText);
+        }
+    }
+    
+    if (mode == GameMode::TIMED) { 
+
+    auto [playerXTimeLeft, playerOTimeLeft] = game.timeLeft;
+
+    float xSeconds = playerXTimeLeft.count() / 1000.0f;
+    float oSeconds = playerOTimeLeft.count() / 1000.0f;
+
+    wstringstream xStream, oStream;
+    xStream << fixed << setprecision(1) << xSeconds;
+    oStream << fixed << setprecision(1) << oSeconds;
+    
+    Color xColor = (currentPlayer == Cell::X) ? Color::Yellow : Color(200, 200, 200);
+    Color oColor = (currentPlayer == Cell::O) ? Color::Yellow : Color(200, 200, 200);
+
+    if (playerXTimeLeft.count() < 10000) xColor = Color::Red;
+    if (playerOTimeLeft.count() < 10000) oColor = Color::Red;
+
+    Text xTimerText(font, L"X: " + xStream.str() + L"с", 18);
+    xTimerText.setFillColor(xColor);
+    xTimerText.setPosition(Vector2f(20, 100));
+    window.draw(xTimerText);
+
+    Text oTimerText(font, L"O: " + oStream.str() + L"с", 18);
+    oTimerText.setFillColor(oColor);
+    oTimerText.setPosition(Vector2f(20, 125));
+    window.draw(oTimerText);
+
+}
+    
+    if (mode == GameMode::RANDOM_EVENTS) {
+        String eventStr;
+        switch (game.nextEvent) {
+            case RandomEvent::NOTHING: eventStr = L"Обычный ход"; break;
+            case RandomEvent::SCORE_PLUS_10: eventStr = L"+10 очков"; break;
+            case RandomEvent::SCORE_MINUS_10: eventStr = L"-10 очков"; break;
+            case RandomEvent::SCORE_PLUS_25: eventStr = L"+25 очков"; break;
+            case RandomEvent::SCORE_MINUS_25: eventStr = L"-25 очков"; break;
+            case RandomEvent::BONUS_MOVE: eventStr = L"Бонусный ход!"; break;
+            case RandomEvent::SWAP_PLAYERS: eventStr = L"Смена элементов!"; break;
+            case RandomEvent::CLEAR_AREA: eventStr = L"Очистка области!"; break;
+        }
+        
+        Text eventText(font, L"Cобытие этого хода: " + eventStr, 14);
+
+        eventText.setFillColor(Color::Cyan);
+        eventText.setPosition(Vector2f(20, 175));
+        window.draw(eventText);
+    }
+    
+    if (game.gameWon) {
+        RectangleShape winPanel;
+        winPanel.setSize(Vector2f(420, 160));
+        winPanel.setFillColor(Color(0, 0, 0, 220));
+        winPanel.setPosition(Vector2f(
+            window.getSize().x / 2.0f - 210, 
+            window.getSize().y / 2.0f - 80
+        ));
+        window.draw(winPanel);
+        
+        String winMessage;
+        if (game.gameEndedByScore) {
+            winMessage = L"Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
+                        L" достиг цели в " + to_wstring(targetScore) + L" очков!\n" +
+                        L"Финальный счет: X=" + to_wstring(playerXScore) + 
+                        L" O=" + to_wstring(playerOScore);
+        } 
+        else if (mode == GameMode::TIMED  && game.winLine.empty()) {
+
+            winMessage = L" Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
+                        L" выиграл по времени!\n" +
+                        L"У противника закончилось время.";
+        }
+        else {
+            winMessage = L"Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
+                        L" собрал линию из " + to_wstring(winningLength) + L" элементов!";
+        }
+        
+        Text winText(font, winMessage, 22);
+        winText.setFillColor(winner == Cell::X ? Color::Red : Color::Blue);
+        winText.setLineSpacing(1.2f);
+        
+        FloatRect textBounds = winText.getLocalBounds();
+        winText.setPosition(Vector2f(
+            window.getSize().x / 2.0f - textBounds.size.x / 2, 
+            window.getSize().y / 2.0f - 50
+        ));
+        window.draw(winText);
+        
+        Text restartText(font, L"Нажмите Enter для новой игры\nили ESC для выхода в меню", 18);
+        restartText.setFillColor(Color::White);
+        textBounds = restartText.getLocalBounds();
+        restartText.setPosition(Vector2f(
+            window.getSize().x / 2.0f - textBounds.size.x / 2, 
+            window.getSize().y / 2.0f + 20
+        ));
+        window.draw(restartText);
+    }
+}
+
+void BoardView::drawSearchStats(RenderWindow &window, const Font &font, const SearchStats &stats) const {
+    const float panelHeight = 250;
+    const float top = window.getSize().y - panelHeight - 10;
+    
+    RectangleShape panel;
+    panel.setSize(Vector2f(300, panelHeight));
+    panel.setFillColor(Color(40, 40, 40, 220));
+    panel.setPosition(Vector2f(10, top));
+    window.draw(panel);
+    
+    wstring sourceStr;
+    switch (stats.source) {
+        case MoveSource::NONE: sourceStr = L"нет"; break;
+        case MoveSource::IMMEDIATE: sourceStr = L"победа/блок"; break;
+        case MoveSource::BOOK: sourceStr = L"дебютная книга"; break;
+        case MoveSource::RANDOM: sourceStr = L"случайный"; break;
+        case MoveSource::SEARCH: sourceStr = L"поиск"; break;
+    }
+    
+    wstringstream info;
+    info << fixed << setprecision(1);
+    info << L"Ход бота: " << sourceStr << L"\n";
+    info << L"Глубина: " << stats.depthReached << L"   оценка: " << stats.score << L"\n";
+    info << L"Узлы: " << stats.nodes << L" (" << (uint64_t)stats.nodesPerSecond() << L"/с)\n";
+    info << L"Оценок листьев: " << stats.leafEvaluations << L"\n";
+    info << L"Отсечения: " << stats.betaCutoffRate() * 100 << L"%, первым ходом " << stats.firstMoveCutoffRate() * 100 << L"%\n";
+    info << L"TT: " << stats.ttHits << L"/" << stats.ttProbes << L" (" << stats.ttHitRate() * 100 << L"%)\n";
+    info << L"Время, мс: " << stats.totalMs << L" (поиск " << stats.searchMs << L", книга " << stats.bookMs << L")\n";
+    
+    info << L"Итерации, мс:";
+    for (double ms : stats.iterationMs) info << L" " << ms;
+    info << L"\n";
+    
+    info << L"ГВ:";
+    for (size_t i = 0; i < stats.principalVariation.size() && i < 6; i++) {
+        info << L" (" << stats.principalVariation[i].x << L"," << stats.principalVariation[i].y << L")";
+    }
+    
+    Text statsText(font, info.str(), 14);
+    statsText.setFillColor(Color(200, 200, 200));
+    statsText.setLineSpacing(1.2f);
+    statsText.setPosition(Vector2f(20, top + 10));
+    window.draw(statsText);
+}
+
+void BoardView::setProfiler(FrameProfiler *newProfiler) {
+    profiler = newProfiler;
+}
+
+void BoardView::invalidate() {
+    graphicsDirty = true;
+}
+
+void BoardView::setCellSize(float size) {
+    cellSize = size;
+    graphicsDirty = true;
+}
+
+void BoardView::setCenter(const Vector2f &newCenter) {
+    center = newCenter;
+    graphicsDirty = true;
+}
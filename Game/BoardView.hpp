@@ -0,0 +1,50 @@
+#pragma once
+
+#include "GameBoard/GameSnapshot.hpp"
+#include "FrameProfiler.hpp"
+#include "GameBoard/Core/Trace.hpp"
+#include <SFML/Graphics.hpp>
+#include <cmath>
+#include <sstream>
+#include <iomanip>
+
+using namespace std;
+using namespace sf;
+
+
+// Отрисовка снимка партии средствами SFML; сама партия о графике ничего не знает
+class BoardView {
+    private:
+        float cellSize;
+        Vector2f center;
+        
+        // Графический кэш, перестраивается при смене партии, ее ревизии или вида
+        mutable bool graphicsDirty;
+        mutable uint64_t cachedGameId;
+        mutable uint64_t cachedRevision;
+        mutable VertexArray gridVertices;
+        mutable VertexArray xVertices;
+        mutable VertexArray oVertices;
+        mutable VertexArray highlightVertices;
+        
+        FrameProfiler *profiler;
+        
+        void updateGraphics(const GameSnapshot &game) const;
+
+    public:
+        BoardView(Vector2f center = Vector2f(400, 300), float cellSize = 40.0f);
+        
+        void draw(RenderWindow &window, const GameSnapshot &game) const;
+        void drawUI(RenderWindow &window, const Font &font, const GameSnapshot &game) const;
+        void drawSearchStats(RenderWindow &window, const Font &font, const SearchStats &stats) const;
+        
+        // Перевод между клетками поля и мировыми координатами
+        Vector2f toPixel(const Position &pos) const;
+        Vector2f toCorner(const Position &pos) const;
+        Position toCell(const Vector2f &worldPos) const;
+        
+        void setProfiler(FrameProfiler *newProfiler);
+        void invalidate();
+        void setCellSize(float size);
+        void setCenter(const Vector2f &newCenter);
+};
@@ -0,0 +1,105 @@
+#include "FrameProfiler.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+FrameProfiler::ScopedTimer::ScopedTimer(FrameProfiler *profiler, Stage stage):
+    profiler(profiler), stage(stage), start(chrono::steady_clock::now()) {}
+
+FrameProfiler::ScopedTimer::~ScopedTimer() {
+    if (!profiler) return;
+    float ms = chrono::duration<float, milli>(chrono::steady_clock::now() - start).count();
+    profiler->addStageTime(stage, ms);
+}
+
+FrameProfiler::FrameProfiler(): head(0), count(0), current{}, frameStart(chrono::steady_clock::now()), visible(false) {}
+
+void FrameProfiler::beginFrame() {
+    current = FrameSample{};
+    frameStart = chrono::steady_clock::now();
+}
+
+void FrameProfiler::endFrame() {
+    current.totalMs = chrono::duration<float, milli>(chrono::steady_clock::now() - frameStart).count();
+    history[head] = current;
+    head = (head + 1) % HISTORY;
+    count = min(count + 1, HISTORY);
+}
+
+void FrameProfiler::addStageTime(Stage stage, float ms) {
+    current.stageMs[static_cast<size_t>(stage)] += ms;
+}
+
+LatencyTracker& FrameProfiler::getLatency() { return latency; }
+
+void FrameProfiler::toggle() { visible = !visible; }
+bool FrameProfiler::isVisible() const { return visible; }
+
+void FrameProfiler::draw(RenderWindow &window, const Font &font) const {
+    if (!visible || count == 0) return;
+
+    const float graphWidth = 240;
+    const float graphHeight = 100;
+    const float msScale = graphHeight / 50.0f;
+    const float left = window.getSize().x - graphWidth - 20;
+    const float top = 10;
+
+    RectangleShape panel;
+    panel.setSize(Vector2f(graphWidth + 10, graphHeight + 130));
+    panel.setFillColor(Color(20, 20, 20, 220));
+    panel.setPosition(Vector2f(left - 5, top));
+    window.draw(panel);
+
+    // График времени кадра: старые кадры слева, линии отмечают 16.7 и 33.3 мс
+    VertexArray graph(PrimitiveType::Lines);
+    float barWidth = graphWidth / HISTORY;
+    float baseY = top + graphHeight + 5;
+    vector<float> totals;
+    totals.reserve(count);
+    array<float, STAGE_COUNT> stageSums{};
+
+    for (size_t i = 0; i < count; i++) {
+        const FrameSample &sample = history[(head + HISTORY - count + i) % HISTORY];
+        totals.push_back(sample.totalMs);
+        for (size_t s = 0; s < STAGE_COUNT; s++) stageSums[s] += sample.stageMs[s];
+
+        float x = left + (HISTORY - count + i) * barWidth;
+        float height = min(sample.totalMs * msScale, graphHeight);
+        Color color = sample.totalMs > 33.4f ? Color::Red : (sample.totalMs > 16.7f ? Color::Yellow : Color::Green);
+        graph.append(Vertex{Vector2f(x, baseY), color});
+        graph.append(Vertex{Vector2f(x, baseY - height), color});
+    }
+
+    for (float budget : {16.7f, 33.3f}) {
+        Color lineColor(150, 150, 150, 150);
+        graph.append(Vertex{Vector2f(left, baseY - budget * msScale), lineColor});
+        graph.append(Vertex{Vector2f(left + graphWidth, baseY - budget * msScale), lineColor});
+    }
+    window.draw(graph);
+
+    float maxMs = *max_element(totals.begin(), totals.end());
+    float p99 = percentileOf(totals, 0.99f);
+    float p50 = percentileOf(totals, 0.50f);
+
+    static const wchar_t *stageNames[STAGE_COUNT] = {L"события", L"снимок", L"графика", L"интерфейс", L"display"};
+
+    wstringstream info;
+    info << fixed << setprecision(2);
+    info << L"Кадр, мс: p50 " << p50 << L"  p99 " << p99 << L"  max " << maxMs << L"\n";
+    for (size_t s = 0; s < STAGE_COUNT; s++) {
+        info << stageNames[s] << L": " << stageSums[s] / count << (s % 2 || s + 1 == STAGE_COUNT ? L"\n" : L"   ");
+    }
+
+    // Клик -> экран: перцентили и разбивка последнего клика по отметкам
+    LatencyTracker::Summary clicks = latency.summarize();
+    LatencyTracker::Sample last = latency.lastSample();
+    info << L"Клик, мс: p50 " << clicks.p50 << L"  p95 " << clicks.p95 << L"  p99 " << clicks.p99 << L"\n";
+    info << L"посл.: " << last[0] << L" / " << last[1] << L" / " << last[2] << L" / " << last[3]
+         << L"  отброшено " << latency.getDroppedClicks() << L"\n";
+
+    Text statsText(font, info.str(), 13);
+    statsText.setFillColor(Color(220, 220, 220));
+    statsText.setPosition(Vector2f(left, baseY + 8));
+    window.draw(statsText);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "LatencyTracker.hpp"
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <chrono>
+#include <vector>
+
+using namespace std;
+using namespace sf;
+
+
+// Профилировщик кадров: время по стадиям за последние HISTORY кадров
+class FrameProfiler {
+    public:
+        enum class Stage { EVENTS, SNAPSHOT, GRAPHICS, DRAW_UI, DISPLAY, COUNT };
+        static constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::COUNT);
+        static constexpr size_t HISTORY = 240;
+
+        // Замер на время жизни объекта; profiler может быть nullptr
+        class ScopedTimer {
+            private:
+                FrameProfiler *profiler;
+                Stage stage;
+                chrono::steady_clock::time_point start;
+
+            public:
+                ScopedTimer(FrameProfiler *profiler, Stage stage);
+                ~ScopedTimer();
+                ScopedTimer(const ScopedTimer &) = delete;
+                ScopedTimer& operator=(const ScopedTimer &) = delete;
+        };
+
+    private:
+        struct FrameSample {
+            float totalMs;
+            array<float, STAGE_COUNT> stageMs;
+        };
+
+        // Кольцевой буфер последних кадров
+        array<FrameSample, HISTORY> history;
+        size_t head;
+        size_t count;
+
+        FrameSample current;
+        chrono::steady_clock::time_point frameStart;
+        bool visible;
+        LatencyTracker latency;
+
+    public:
+        FrameProfiler();
+
+        void beginFrame();
+        void endFrame();
+        void addStageTime(Stage stage, float ms);
+        LatencyTracker& getLatency();
+
+        void toggle();
+        bool isVisible() const;
+        void draw(RenderWindow &window, const Font &font) const;
+};
@@ -5,7 +5,8 @@ Game::Game(): window(VideoMode({800, 600}), L"Крестики-Нолики", St
               viewCenter(400, 300), zoomLevel(1.0f), selectedLength(5), selectedScoreTarget(100),
               selectedTimeLimit(chrono::seconds(10)), selectedOpponent(OpponentType::PLAYER_VS_PLAYER),
               selectedDifficulty(BotDifficulty::MEDIUM), windowSize(800, 600),
-              inputCooldown(0.1f), targetFPS(60.0f), frameTime(1.0f / targetFPS), playerJustMoved(false) {
+              inputCooldown(0.1f), targetFPS(60.0f), currentGameId(0), commandSequence(0), awaitedCommand(0),
+              replayIndex(0), replayRevision(0), replayScrubbing(false), redrawRequested(true), showSearchStats(false) {
 
     window.setFramerateLimit(static_cast<unsigned int>(targetFPS));
     if (!font.openFromFile("C:/Windows/Fonts/bahnschrift.ttf")) {
@@ -13,6 +14,7 @@ Game::Game(): window(VideoMode({800, 600}), L"Крестики-Нолики", St
             cerr << L"Не удалось загрузить шрифт!" << endl;
         }
     }
+    OpeningBook::shared().load("opening_book.bin");
     
     uiView = View(Vector2f(windowSize.x / 2.0f, windowSize.y / 2.0f), Vector2f(windowSize));
     gameView = View(viewCenter, Vector2f(windowSize));
@@ -23,63 +25,155 @@ Game::Game(): window(VideoMode({800, 600}), L"Крестики-Нолики", St
     setupTimeSelection();
     setupOpponentSelection();
     setupDifficultySelection();
+    boardView.setProfiler(&profiler);
+    simulation.setRecordDirectory("records");
+    simulation.setAutosaveDirectory("autosave");
+    simulation.start();
+    resumeSavedGame();
 }
 
 void Game::run() {
     while (window.isOpen()) {
+        waitForWork();
+        
+        TraceScope trace("frame", "frame");
+        profiler.beginFrame();
         processEvents();
+        
+        GameState previousState = currentState;
         update();
-        render();
+        if (currentState != previousState) redrawRequested = true;
+        
+        if (redrawRequested || needsContinuousRedraw()) {
+            redrawRequested = false;
+            render();
+            profiler.endFrame();
+        }
     }
 }
 
+bool Game::openLatencyLog(const string &path) {
+    return profiler.getLatency().openLog(path);
+}
+
+bool Game::openReplay(const string &path) {
+    if (!replay.open(path)) return false;
+    
+    boardView.setCenter(viewCenter);
+    gameView.setCenter(viewCenter);
+    gameView.setSize(Vector2f(window.getSize()));
+    zoomLevel = 1.0f;
+    
+    currentState = GameState::REPLAY;
+    seekReplay(replay.getMoveCount());
+    return true;
+}
+
+// Снимок с отдельным gameId, чтобы кэш отрисовки не спутал запись с живой партией
+void Game::seekReplay(size_t index) {
+    replayIndex = min(index, replay.getMoveCount());
+    if (!replay.seek(replayIndex, replayState)) return;
+    
+    const RecordSettings &settings = replay.getSettings();
+    auto view = make_shared<GameSnapshot>();
+    view->gameId = UINT64_MAX;
+    view->revision = ++replayRevision;
+    view->board = make_shared<const GameBoard>(replayState.board);
+    view->mode = settings.mode;
+    view->opponentType = settings.opponent;
+    view->botDifficulty = settings.difficulty;
+    view->winningLength = settings.winningLength;
+    view->targetScore = settings.targetScore;
+    view->currentPlayer = replayState.lastPlayer == Cell::X ? Cell::O : Cell::X;
+    view->bonusScore = replayState.bonusScore;
+    view->timeLeft = replayState.timeLeft;
+    replaySnapshot = move(view);
+    redrawRequested = true;
+}
+
+FloatRect Game::replayBarBounds() const {
+    return FloatRect(Vector2f(20, windowSize.y - 40.0f), Vector2f(windowSize.x - 40.0f, 16));
+}
+
+// Пока ничего не меняется, поток спит в ОС до ближайшего события.
+// Пока думает бот или ожидается снимок после хода, сон короче шага симуляции.
+void Game::waitForWork() {
+    if (redrawRequested || needsContinuousRedraw()) return;
+    Time timeout = isWaitingForSimulation() ? milliseconds(5) : seconds(1.0f);
+    if (auto event = window.waitEvent(timeout)) handleEvent(*event);
+}
+
+// Кадры подряд нужны только для идущих часов TIMED и открытого профилировщика
+bool Game::needsContinuousRedraw() const {
+    if (profiler.isVisible()) return true;
+    return currentState == GameState::PLAYING && snapshot && snapshot->mode == GameMode::TIMED && !snapshot->gameWon;
+}
+
+bool Game::isWaitingForSimulation() const {
+    if (awaitedCommand) return true;
+    if (currentState != GameState::PLAYING) return false;
+    if (!snapshot || snapshot->gameId != currentGameId) return true;
+    return snapshot->botTurn && !snapshot->gameWon;
+}
+
+// Снимок прошлой партии может дорисовываться, пока не пришел новый, но не завершает игру
+bool Game::isCurrentGameWon() const {
+    return snapshot && snapshot->gameId == currentGameId && snapshot->gameWon;
+}
+
 void Game::processEvents() {
+    FrameProfiler::ScopedTimer timer(&profiler, FrameProfiler::Stage::EVENTS);
+    
     optional<Event> event;
-    while ((event = window.pollEvent())) {
-        if (event->is<Event::Closed>()) {
-            window.close();
-        }
-        else if (auto resized = event->getIf<Event::Resized>()) {
-            Vector2u newSize(resized->size.x, resized->size.y);
-            window.setView(View(Vector2f(newSize.x / 2.0f, newSize.y / 2.0f), Vector2f(newSize)));
-            updateButtonsForWindowSize();
-        }
-        else {
-            switch (currentState) {
-                case GameState::MENU: handleMenuInput(*event); break;
-                case GameState::PLAYING: handleGameInput(*event); break;
-                case GameState::PAUSED: handlePauseInput(*event); break;
-                case GameState::GAME_OVER: handleGameOverInput(*event); break;
-                case GameState::SCORE_SELECTION: handleScoreSelectionInput(*event); break;
-                case GameState::TIME_SELECTION: handleTimeSelectionInput(*event); break;
-                case GameState::OPPONENT_SELECTION: handleOpponentSelectionInput(*event); break;
-                case GameState::DIFFICULTY_SELECTION: handleDifficultySelectionInput(*event); break;
-            }
+    while ((event = window.pollEvent())) handleEvent(*event);
+}
+
+void Game::handleEvent(const Event &event) {
+    redrawRequested = true;
+    if (event.is<Event::MouseButtonPressed>()) lastInputTime = chrono::steady_clock::now();
+    
+    if (event.is<Event::Closed>()) {
+        window.close();
+    }
+    else if (auto keyPress = event.getIf<Event::KeyPressed>(); keyPress && keyPress->code == Keyboard::Key::F2) {
+        profiler.toggle();
+    }
+    else if (auto resized = event.getIf<Event::Resized>()) {
+        Vector2u newSize(resized->size.x, resized->size.y);
+        window.setView(View(Vector2f(newSize.x / 2.0f, newSize.y / 2.0f), Vector2f(newSize)));
+        updateButtonsForWindowSize();
+    }
+    else {
+        switch (currentState) {
+            case GameState::MENU: handleMenuInput(event); break;
+            case GameState::PLAYING: handleGameInput(event); break;
+            case GameState::PAUSED: handlePauseInput(event); break;
+            case GameState::GAME_OVER: handleGameOverInput(event); break;
+            case GameState::SCORE_SELECTION: handleScoreSelectionInput(event); break;
+            case GameState::TIME_SELECTION: handleTimeSelectionInput(event); break;
+            case GameState::OPPONENT_SELECTION: handleOpponentSelectionInput(event); break;
+            case GameState::DIFFICULTY_SELECTION: handleDifficultySelectionInput(event); break;
+            case GameState::REPLAY: handleReplayInput(event); break;
         }
     }
 }
 
 void Game::update() {
-    float elapsed = frameClock.restart().asSeconds();
-    if (elapsed < frameTime) sleep(seconds(frameTime - elapsed));
-    if (currentState == GameState::PLAYING && game) {
-        if (game->getGameMode() == GameMode::TIMED && game->isTimeUp()) {
-            currentState = GameState::GAME_OVER;
-            return;
-        }
-        if (game->isGameWon()) {
-            currentState = GameState::GAME_OVER;
-            return;
-        }
-        if (playerJustMoved) {
-            playerJustMoved = false;
-            return;
-        }
-        if (game->isBotCurrentTurn() && !game->isGameWon()) {
-            game->makeBotMove();
-            if (game->isGameWon()) currentState = GameState::GAME_OVER;
+    FrameProfiler::ScopedTimer timer(&profiler, FrameProfiler::Stage::SNAPSHOT);
+    
+    if (auto latest = simulation.takeLatestSnapshot(); latest && latest->gameId == currentGameId) {
+        snapshot = move(latest);
+        redrawRequested = true;
+        if (awaitedCommand && snapshot->lastCommand >= awaitedCommand) {
+            awaitedCommand = 0;
+            profiler.getLatency().mark(LatencyTracker::Mark::SNAPSHOT);
         }
     }
+    
+    // Пока не пришел ответ на отмену хода, старый снимок с победой не завершает игру
+    if (currentState == GameState::PLAYING && isCurrentGameWon() && !awaitedCommand) {
+        currentState = GameState::GAME_OVER;
+    }
 }
 
 void Game::render() {
@@ -94,9 +188,19 @@ void Game::render() {
         case GameState::TIME_SELECTION: drawTimeSelection(); break;
         case GameState::OPPONENT_SELECTION: drawOpponentSelection(); break;
         case GameState::DIFFICULTY_SELECTION: drawDifficultySelection(); break;
+        case GameState::REPLAY: drawReplay(); break;
     }
     
-    window.display();
+    if (profiler.isVisible()) {
+        window.setView(uiView);
+        profiler.draw(window, font);
+    }
+    
+    {
+        FrameProfiler::ScopedTimer timer(&profiler, FrameProfiler::Stage::DISPLAY);
+        window.display();
+    }
+    profiler.getLatency().mark(LatencyTracker::Mark::DISPLAYED);
 }
 
 void Game::setupMenu() {
@@ -175,7 +279,7 @@ void Game::setupOpponentSelection() {
 
 void Game::setupDifficultySelection() {
     difficultyButtons.clear();
-    difficultyButtons.reserve(4);
+    difficultyButtons.reserve(5);
     
     const float buttonWidth = 240;
     const float buttonHeight = 50;
@@ -185,7 +289,8 @@ void Game::setupDifficultySelection() {
     difficultyButtons.emplace_back(Vector2f(280, startY), Vector2f(buttonWidth, buttonHeight), font, L"Легкий", 22);
     difficultyButtons.emplace_back(Vector2f(280, startY + spacing), Vector2f(buttonWidth, buttonHeight), font, L"Средний", 22);
     difficultyButtons.emplace_back(Vector2f(280, startY + spacing * 2), Vector2f(buttonWidth, buttonHeight), font, L"Сложный", 22);
-    difficultyButtons.emplace_back(Vector2f(280, startY + spacing * 3), Vector2f(buttonWidth, buttonHeight), font, L"Назад", 22);
+    difficultyButtons.emplace_back(Vector2f(280, startY + spacing * 3), Vector2f(buttonWidth, buttonHeight), font, L"Эксперт", 22);
+    difficultyButtons.emplace_back(Vector2f(280, startY + spacing * 4), Vector2f(buttonWidth, buttonHeight), font, L"Назад", 22);
 }
 
 void Game::updateButtonsForWindowSize() {
@@ -252,11 +357,10 @@ void Game::updateButtonsForWindowSize() {
         difficultyButtons[1].setPosition(Vector2f(centerX - 120, 260));
         difficultyButtons[2].setPosition(Vector2f(centerX - 120, 320));
         difficultyButtons[3].setPosition(Vector2f(centerX - 120, 380));
+        difficultyButtons[4].setPosition(Vector2f(centerX - 120, 440));
     }
     
-    if (game) {
-        game->setCenter(viewCenter);
-    }
+    boardView.setCenter(viewCenter);
 }
 
 void Game::startGame(GameMode mode, int length, int scoreTarget, chrono::seconds timeLimit,
@@ -268,7 +372,14 @@ void Game::startGame(GameMode mode, int length, int scoreTarget, chrono::seconds
     selectedOpponent = opponent;
     selectedDifficulty = difficulty;
     
-    game = make_unique<InfiniteTicTacToe>(mode, length, scoreTarget, timeLimit, viewCenter, opponent, difficulty);
+    SimulationCommand command;
+    command.type = SimulationCommand::Type::START;
+    command.gameId = ++currentGameId;
+    command.settings = currentSettings();
+    awaitedCommand = postCommand(command);
+    snapshot.reset();
+    
+    boardView.setCenter(viewCenter);
     currentState = GameState::PLAYING;
     
     gameView.setCenter(viewCenter);
@@ -276,6 +387,78 @@ void Game::startGame(GameMode mode, int length, int scoreTarget, chrono::seconds
     zoomLevel = 1.0f;
 }
 
+// Незаконченная партия прошлого запуска открывается на паузе: продолжить, начать заново или выйти в меню
+void Game::resumeSavedGame() {
+    RecordSettings saved;
+    if (!GameJournal::readSettings("autosave", saved)) return;
+    
+    selectedMode = saved.mode;
+    selectedLength = saved.winningLength;
+    selectedScoreTarget = saved.targetScore;
+    selectedTimeLimit = chrono::duration_cast<chrono::seconds>(saved.timeLimit);
+    selectedOpponent = saved.opponent;
+    selectedDifficulty = saved.difficulty;
+    
+    SimulationCommand command;
+    command.type = SimulationCommand::Type::RESTORE;
+    command.gameId = ++currentGameId;
+    command.settings = currentSettings();
+    awaitedCommand = postCommand(command);
+    snapshot.reset();
+    
+    boardView.setCenter(viewCenter);
+    gameView.setCenter(viewCenter);
+    gameView.setSize(Vector2f(window.getSize()));
+    zoomLevel = 1.0f;
+    currentState = GameState::PAUSED;
+}
+
+GameSettings Game::currentSettings() const {
+    GameSettings settings;
+    settings.mode = selectedMode;
+    settings.winningLength = selectedLength;
+    settings.targetScore = selectedScoreTarget;
+    settings.timeLimit = selectedTimeLimit;
+    settings.opponent = selectedOpponent;
+    settings.difficulty = selectedDifficulty;
+    return settings;
+}
+
+// Старый снимок остается на экране, пока симуляция не пришлет поле новой партии
+void Game::resetGame() {
+    SimulationCommand command;
+    command.type = SimulationCommand::Type::RESET;
+    command.gameId = ++currentGameId;
+    command.settings = currentSettings();
+    awaitedCommand = postCommand(command);
+}
+
+void Game::closeGame() {
+    SimulationCommand command;
+    command.type = SimulationCommand::Type::CLOSE;
+    command.gameId = ++currentGameId;
+    postCommand(command);
+    snapshot.reset();
+    awaitedCommand = 0;
+}
+
+// Отмена и повтор - только между ходами: не во время хода бота и не до ответа на прошлую команду
+bool Game::postHistoryCommand(SimulationCommand::Type type) {
+    if (!snapshot || snapshot->gameId != currentGameId || snapshot->botTurn || awaitedCommand) return false;
+    
+    SimulationCommand command;
+    command.type = type;
+    command.gameId = currentGameId;
+    awaitedCommand = postCommand(command);
+    return awaitedCommand != 0;
+}
+
+// Возвращает порядковый номер команды или 0, если очередь переполнена
+uint64_t Game::postCommand(SimulationCommand command) {
+    command.sequence = ++commandSequence;
+    return simulation.post(command) ? command.sequence : 0;
+}
+
 bool Game::checkInputCooldown() {
     if (inputClock.getElapsedTime().asSeconds() >= inputCooldown) {
         inputClock.restart();
@@ -322,17 +505,56 @@ void Game::handleMenuInput(const Event& event) {
 
 void Game::handleGameInput(const Event& event) {
     Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window), gameView);
-    float oldZoom = zoomLevel;
     
     if (auto mousePress = event.getIf<Event::MouseButtonPressed>()) {
-        if (mousePress->button == Mouse::Button::Left && checkInputCooldown()) {
-            if (game && !game->isGameWon()) {
-                bool gameEnded = game->handleClick(mousePos);
-                playerJustMoved = true;
-                if (gameEnded) currentState = GameState::GAME_OVER;
+        if (mousePress->button == Mouse::Button::Left) {
+            bool accepted = false;
+            if (checkInputCooldown() && snapshot && snapshot->gameId == currentGameId &&
+                !snapshot->gameWon && !snapshot->botTurn && !awaitedCommand) {
+                SimulationCommand command;
+                command.type = SimulationCommand::Type::MOVE;
+                command.gameId = currentGameId;
+                command.move = boardView.toCell(mousePos);
+                awaitedCommand = postCommand(command);
+                accepted = awaitedCommand != 0;
             }
+            if (accepted) profiler.getLatency().beginClick(lastInputTime);
+            else profiler.getLatency().dropClick();
+        }
+    }
+    
+    handleCameraInput(event);
+    
+    if (auto keyPress = event.getIf<Event::KeyPressed>()) {
+        if (!checkInputCooldown()) return;
+        
+        switch (keyPress->code) {
+            case Keyboard::Key::Escape:
+                currentState = GameState::PAUSED;
+                postCommand({SimulationCommand::Type::PAUSE, currentGameId});
+                break;
+            case Keyboard::Key::R:
+                resetGame();
+                break;
+            case Keyboard::Key::Z:
+                if (keyPress->control) postHistoryCommand(keyPress->shift ? SimulationCommand::Type::REDO : SimulationCommand::Type::UNDO);
+                break;
+            case Keyboard::Key::Y:
+                if (keyPress->control) postHistoryCommand(SimulationCommand::Type::REDO);
+                break;
+            case Keyboard::Key::F3:
+                showSearchStats = !showSearchStats;
+                break;
+            default: break;
         }
+
     }
+}
+
+// Масштаб колесом и +/-, перетаскивание правой кнопкой; общее для игры и просмотра записи
+void Game::handleCameraInput(const Event& event) {
+    Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window), gameView);
+    float oldZoom = zoomLevel;
     
     if (auto mouseWheel = event.getIf<Event::MouseWheelScrolled>()) {
         if (mouseWheel->delta > 0) zoomLevel *= 1.1f;
@@ -365,26 +587,13 @@ void Game::handleGameInput(const Event& event) {
     }
     
     if (auto keyPress = event.getIf<Event::KeyPressed>()) {
-        if (!checkInputCooldown()) return;
-        
-        switch (keyPress->code) {
-            case Keyboard::Key::Escape:
-                currentState = GameState::PAUSED;
-                break;
-            case Keyboard::Key::R:
-                if (game) game->reset(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
-                break;
-            case Keyboard::Key::Add:
-                zoomLevel *= 0.9f;
-                gameView.zoom(0.9f);
-                break;
-            case Keyboard::Key::Subtract:
-                zoomLevel *= 1.1f;
-                gameView.zoom(1.1f);
-                break;
-            default: break;
+        if (keyPress->code == Keyboard::Key::Add) {
+            zoomLevel *= 0.9f;
+            gameView.zoom(0.9f);
+        } else if (keyPress->code == Keyboard::Key::Subtract) {
+            zoomLevel *= 1.1f;
+            gameView.zoom(1.1f);
         }
-
     }
 
     if (zoomLevel > 5.0f) zoomLevel = 5.0f;
@@ -395,6 +604,55 @@ void Game::handleGameInput(const Event& event) {
     }
 }
 
+// Стрелки: ход и 10 ходов, PgUp/PgDn: 100, Home/End: края; ЛКМ по полосе внизу - перемотка
+void Game::handleReplayInput(const Event& event) {
+    handleCameraInput(event);
+    
+    auto scrubTo = [this](Vector2i pixel) {
+        FloatRect bar = replayBarBounds();
+        float ratio = (pixel.x - bar.position.x) / bar.size.x;
+        ratio = min(max(ratio, 0.0f), 1.0f);
+        seekReplay((size_t)lround(ratio * replay.getMoveCount()));
+    };
+    
+    if (auto mousePress = event.getIf<Event::MouseButtonPressed>()) {
+        FloatRect bar = replayBarBounds();
+        bar.position.y -= 8;
+        bar.size.y += 16;
+        if (mousePress->button == Mouse::Button::Left && bar.contains(Vector2f(mousePress->position))) {
+            replayScrubbing = true;
+            scrubTo(mousePress->position);
+        }
+    }
+    if (auto mouseRelease = event.getIf<Event::MouseButtonReleased>()) {
+        if (mouseRelease->button == Mouse::Button::Left) replayScrubbing = false;
+    }
+    if (auto mouseMove = event.getIf<Event::MouseMoved>()) {
+        if (replayScrubbing) scrubTo(mouseMove->position);
+    }
+    
+    if (auto keyPress = event.getIf<Event::KeyPressed>()) {
+        long long step = 0;
+        switch (keyPress->code) {
+            case Keyboard::Key::Right: step = 1; break;
+            case Keyboard::Key::Left: step = -1; break;
+            case Keyboard::Key::Up: step = 10; break;
+            case Keyboard::Key::Down: step = -10; break;
+            case Keyboard::Key::PageUp: step = 100; break;
+            case Keyboard::Key::PageDown: step = -100; break;
+            case Keyboard::Key::Home: seekReplay(0); break;
+            case Keyboard::Key::End: seekReplay(replay.getMoveCount()); break;
+            case Keyboard::Key::Escape:
+                currentState = GameState::MENU;
+                replay.close();
+                replaySnapshot.reset();
+                break;
+            default: break;
+        }
+        if (step) seekReplay((size_t)max(0LL, (long long)replayIndex + step));
+    }
+}
+
 void Game::handlePauseInput(const Event& event) {
     Vector2f mousePos = window.mapPixelToCoords(Mouse::getPosition(window), uiView);
     bool mousePressed = false;
@@ -409,17 +667,21 @@ void Game::handlePauseInput(const Event& event) {
             size_t index = &button - &pauseButtons[0];
             if (index == 0) {
                 currentState = GameState::PLAYING;
+                postCommand({SimulationCommand::Type::RESUME, currentGameId});
             } else if (index == 1) {
                 startGame(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
             } else if (index == 2) {
                 currentState = GameState::MENU;
-                game.reset();
+                closeGame();
             }
         }
     }
     
     if (auto keyPress = event.getIf<Event::KeyPressed>()) {
-        if (keyPress->code == Keyboard::Key::Escape) currentState = GameState::PLAYING;
+        if (keyPress->code == Keyboard::Key::Escape) {
+            currentState = GameState::PLAYING;
+            postCommand({SimulationCommand::Type::RESUME, currentGameId});
+        }
     }
 }
 
@@ -427,18 +689,21 @@ void Game::handleGameOverInput(const Event& event) {
     if (auto keyPress = event.getIf<Event::KeyPressed>()) {
         if (!checkInputCooldown()) return;
         
-        if (keyPress->code == Keyboard::Key::Enter) {
-            if (game) game->reset(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
+        if (keyPress->code == Keyboard::Key::Z && keyPress->control) {
+            // Отмена последнего хода возвращает в партию
+            if (postHistoryCommand(SimulationCommand::Type::UNDO)) currentState = GameState::PLAYING;
+        } else if (keyPress->code == Keyboard::Key::Enter) {
+            resetGame();
             currentState = GameState::PLAYING;
         } else if (keyPress->code == Keyboard::Key::Escape) {
             currentState = GameState::MENU;
-            game.reset();
+            closeGame();
         }
     }
     
     if (auto mousePress = event.getIf<Event::MouseButtonPressed>()) {
         if (checkInputCooldown()) {
-            if (game) game->reset(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
+            resetGame();
             currentState = GameState::PLAYING;
         }
     }
@@ -452,19 +717,22 @@ void Game::handleScoreSelectionInput(const Event& event) {
         if (mousePress->button == Mouse::Button::Left) mousePressed = true;
     }
     
+    // После цели выбирается соперник: у режимов со счетом свой бот
+    auto selectTarget = [this](int target) {
+        selectedScoreTarget = target;
+        currentState = GameState::OPPONENT_SELECTION;
+    };
+    
     for (auto &button : scoreButtons) {
         button.update(mousePos);
         if (button.isClicked(mousePos, mousePressed)) {
             size_t index = &button - &scoreButtons[0];
             if (index == 0) {
-                selectedScoreTarget = 50;
-                startGame(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
+                selectTarget(50);
             } else if (index == 1) {
-                selectedScoreTarget = 100;
-                startGame(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
+                selectTarget(100);
             } else if (index == 2) {
-                selectedScoreTarget = 300;
-                startGame(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit);
+                selectTarget(300);
             } else if (index == 3) {
                 currentState = GameState::MENU;
             }
@@ -548,10 +816,10 @@ void Game::handleDifficultySelectionInput(const Event& event) {
         button.update(mousePos);
         if (button.isClicked(mousePos, mousePressed)) {
             size_t index = &button - &difficultyButtons[0];
-            if (index < 3) {
+            if (index < 4) {
                 selectedDifficulty = static_cast<BotDifficulty>(index);
                 startGame(selectedMode, selectedLength, selectedScoreTarget, selectedTimeLimit, OpponentType::PLAYER_VS_BOT, selectedDifficulty);
-            } else if (index == 3) {
+            } else if (index == 4) {
                 currentState = GameState::OPPONENT_SELECTION;
             }
         }
@@ -599,27 +867,35 @@ void Game::drawMenu() {
                      L"ПКМ - двигать камеру\n" \
                      L"ESC - пауза/меню\n" \
                      L"R - перезапуск\n" \
+                     L"Ctrl+Z/Y - отмена/повтор\n" \
                      L"+/- - масштабирование\n", 16);
     hints.setFillColor(Color(150, 150, 150));
-    hints.setPosition(Vector2f(windowSize.x - 180, windowSize.y - 120));
+    hints.setPosition(Vector2f(windowSize.x - 200, windowSize.y - 140));
     window.draw(hints);
 }
 
 void Game::drawGame() {
     window.setView(gameView);
-    if (game) game->draw(window);
+    if (snapshot) boardView.draw(window, *snapshot);
     
     window.setView(uiView);
-    if (game) game->drawUI(window, font);
+    if (snapshot) {
+        FrameProfiler::ScopedTimer timer(&profiler, FrameProfiler::Stage::DRAW_UI);
+        boardView.drawUI(window, font, *snapshot);
+    }
+    if (snapshot && showSearchStats && snapshot->botStats) boardView.drawSearchStats(window, font, *snapshot->botStats);
     
     Text instructions(font, L"Управление в игре:\n" \
                             L"ЛКМ - сделать ход\n" \
                             L"ПКМ - двигать камеру\n" \
                             L"ESC - пауза/меню\n" \
                             L"R - перезапуск\n" \
-                            L"+/- - масштабирование\n", 16);
+                            L"Ctrl+Z/Ctrl+Y - отмена/повтор\n" \
+                            L"+/- - масштабирование\n" \
+                            L"F2 - профилировщик кадров\n" \
+                            L"F3 - статистика бота\n", 16);
     instructions.setFillColor(Color(150, 150, 150));
-    instructions.setPosition(Vector2f(windowSize.x - 180, windowSize.y - 120));
+    instructions.setPosition(Vector2f(windowSize.x - 240, windowSize.y - 180));
     window.draw(instructions);
 }
 
@@ -796,10 +1072,89 @@ void Game::drawDifficultySelection() {
     
     Text hints(font, L"Легкий: случайные ходы и простые решения\n" \
                      L"Средний: базовая стратегия\n" \
-                     L"Сложный: продвинутая стратегия с просчетом ходов", 16);
+                     L"Сложный: продвинутая стратегия с просчетом ходов\n" \
+                     L"Эксперт: поиск по дереву Монте-Карло", 16);
     hints.setFillColor(Color::Yellow);
     hints.setLineSpacing(1.2f);
     FloatRect hintsBounds = hints.getLocalBounds();
-    hints.setPosition(Vector2f(windowSize.x / 2.0f - hintsBounds.size.x / 2, 450));
+    hints.setPosition(Vector2f(windowSize.x / 2.0f - hintsBounds.size.x / 2, 500));
     window.draw(hints);
 }
+
+void Game::drawReplay() {
+    if (!replaySnapshot) return;
+    
+    window.setView(gameView);
+    boardView.draw(window, *replaySnapshot);
+    window.setView(uiView);
+    
+    const RecordSettings &settings = replay.getSettings();
+    RectangleShape infoPanel;
+    infoPanel.setSize(Vector2f(280, 150));
+    infoPanel.setFillColor(Color(40, 40, 40, 220));
+    infoPanel.setPosition(Vector2f(10, 10));
+    window.draw(infoPanel);
+    
+    String modeStr;
+    switch (settings.mode) {
+        case GameMode::CLASSIC: modeStr = L"Классический"; break;
+        case GameMode::TIMED: modeStr = L"С таймером"; break;
+        case GameMode::SCORING: modeStr = L"Система очков"; break;
+        case GameMode::RANDOM_EVENTS: modeStr = L"Случайные события"; break;
+    }
+    
+    wstringstream info;
+    info << L"Запись: ход " << replayIndex << L" / " << replay.getMoveCount() << L"\n";
+    info << L"Режим: " << modeStr.toWideString() << L", линия " << settings.winningLength << L"\n";
+    if (settings.mode == GameMode::RANDOM_EVENTS) {
+        info << L"Бонусы: X=" << replayState.bonusScore.first << L" O=" << replayState.bonusScore.second << L"\n";
+        const wchar_t *eventStr = L"нет";
+        switch (replayState.lastEvent) {
+            case RandomEvent::NOTHING: break;
+            case RandomEvent::SCORE_PLUS_10: eventStr = L"+10 очков"; break;
+            case RandomEvent::SCORE_MINUS_10: eventStr = L"-10 очков"; break;
+            case RandomEvent::SCORE_PLUS_25: eventStr = L"+25 очков"; break;
+            case RandomEvent::SCORE_MINUS_25: eventStr = L"-25 очков"; break;
+            case RandomEvent::BONUS_MOVE: eventStr = L"бонусный ход"; break;
+            case RandomEvent::SWAP_PLAYERS: eventStr = L"смена элементов"; break;
+            case RandomEvent::CLEAR_AREA: eventStr = L"очистка области"; break;
+        }
+        info << L"Последнее событие: " << eventStr << L"\n";
+    }
+    if (settings.mode == GameMode::TIMED) {
+        info << fixed << setprecision(1) << L"Часы: X " << replayState.timeLeft.first.count() / 1000.0f
+             << L"с, O " << replayState.timeLeft.second.count() / 1000.0f << L"с\n";
+    }
+    if (replayState.finished) {
+        info << L"Итог: победил " << (replayState.winner == Cell::X ? L"X" : L"O")
+             << (replayState.endedByScore ? L" по очкам" : L"") << L"\n";
+    }
+    
+    Text infoText(font, info.str(), 16);
+    infoText.setFillColor(Color::White);
+    infoText.setLineSpacing(1.2f);
+    infoText.setPosition(Vector2f(20, 20));
+    window.draw(infoText);
+    
+    // Полоса перемотки
+    FloatRect bar = replayBarBounds();
+    RectangleShape track(bar.size);
+    track.setPosition(bar.position);
+    track.setFillColor(Color(60, 60, 60));
+    window.draw(track);
+    
+    float ratio = replay.getMoveCount() ? (float)replayIndex / replay.getMoveCount() : 1.0f;
+    RectangleShape filled(Vector2f(bar.size.x * ratio, bar.size.y));
+    filled.setPosition(bar.position);
+    filled.setFillColor(Color(90, 140, 220));
+    window.draw(filled);
+    
+    Text instructions(font, L"←/→ - ход, ↑/↓ - 10 ходов\n" \
+                            L"PgUp/PgDn - 100 ходов\n" \
+                            L"Home/End - начало/конец\n" \
+                            L"ЛКМ по полосе - перемотка\n" \
+                            L"ESC - в меню\n", 16);
+    instructions.setFillColor(Color(150, 150, 150));
+    instructions.setPosition(Vector2f(windowSize.x - 220, windowSize.y - 160));
+    window.draw(instructions);
+}
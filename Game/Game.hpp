@@ -2,7 +2,11 @@
 
 #include "GameStates.hpp"
 #include "GameUI.hpp"
-#include "GameBoard/InfiniteTicTacToe.hpp"
+#include "BoardView.hpp"
+#include "FrameProfiler.hpp"
+#include "GameBoard/GameSimulation.hpp"
+#include "GameBoard/GameRecord.hpp"
+#include "GameBoard/AI/OpeningBook.hpp"
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <memory>
@@ -19,7 +23,26 @@ class Game {
         GameState currentState;
         GameState opponentSelectionState;
         GameState difficultySelectionState;
-        unique_ptr<InfiniteTicTacToe> game;
+        
+        // Партией владеет поток симуляции, интерфейс рисует ее последний снимок
+        GameSimulation simulation;
+        shared_ptr<const GameSnapshot> snapshot;
+        uint64_t currentGameId;
+        uint64_t commandSequence;
+        // Команда, результат которой еще не пришел в снимке (0 - нет)
+        uint64_t awaitedCommand;
+        // Момент извлечения последнего нажатия мыши из очереди окна
+        chrono::steady_clock::time_point lastInputTime;
+        
+        // Просмотр записи партии; снимки строятся прямо из файла, без симуляции
+        GameRecordReader replay;
+        ReplayState replayState;
+        size_t replayIndex;
+        uint64_t replayRevision;
+        shared_ptr<const GameSnapshot> replaySnapshot;
+        bool replayScrubbing;
+        
+        BoardView boardView;
         Font font;
         
         // UI элементы
@@ -47,20 +70,31 @@ class Game {
         // Оптимизация
         Clock inputClock;
         float inputCooldown;
-        Clock frameClock;
         float targetFPS;
-        float frameTime;
         Vector2u windowSize;
-        bool playerJustMoved;
+        
+        // Перерисовка по требованию: кадр рисуется только после изменений
+        bool redrawRequested;
+        
+        // Отладочные оверлеи
+        bool showSearchStats;
+        FrameProfiler profiler;
 
     public:
         Game();
         void run();
+        bool openLatencyLog(const string &path);
+        bool openReplay(const string &path);
 
     private:
+        void waitForWork();
         void processEvents();
+        void handleEvent(const Event &event);
         void update();
         void render();
+        bool needsContinuousRedraw() const;
+        bool isWaitingForSimulation() const;
+        bool isCurrentGameWon() const;
         
         // Методы настройки интерфейса
         void setupMenu();
@@ -74,12 +108,22 @@ class Game {
         // Запуск игры
         void startGame(GameMode mode, int length, int scoreTarget = 300, chrono::seconds timeLimit = chrono::seconds(10),
                        OpponentType opponent = OpponentType::PLAYER_VS_PLAYER, BotDifficulty difficulty = BotDifficulty::MEDIUM);
+        void resumeSavedGame();
+        GameSettings currentSettings() const;
+        uint64_t postCommand(SimulationCommand command);
+        bool postHistoryCommand(SimulationCommand::Type type);
+        void resetGame();
+        void closeGame();
         
         bool checkInputCooldown();
+        void seekReplay(size_t index);
+        FloatRect replayBarBounds() const;
         
         // Обработчики ввода для разных состояний
         void handleMenuInput(const Event &event);
+        void handleCameraInput(const Event &event);
         void handleGameInput(const Event &event);
+        void handleReplayInput(const Event &event);
         void handlePauseInput(const Event &event);
         void handleGameOverInput(const Event &event);
         void handleScoreSelectionInput(const Event &event);
@@ -95,4 +139,5 @@ class Game {
         void drawTimeSelection();
         void drawOpponentSelection();
         void drawDifficultySelection();
+        void drawReplay();
 };
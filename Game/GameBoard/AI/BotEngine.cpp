@@ -0,0 +1,11 @@
+#include "BotEngine.hpp"
+#include "TicTacToeBot.hpp"
+#include "MCTSBot.hpp"
+#include "ExpectimaxBot.hpp"
+
+
+unique_ptr<BotEngine> createBot(BotDifficulty diff, Cell symbol, GameMode mode) {
+    if (mode == GameMode::SCORING || mode == GameMode::RANDOM_EVENTS) return make_unique<ExpectimaxBot>(diff, symbol);
+    if (diff == BotDifficulty::EXPERT) return make_unique<MCTSBot>(diff, symbol);
+    return make_unique<TicTacToeBot>(diff, symbol);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../GameBoard.hpp"
+#include "../Scoring.hpp"
+#include "../../GameStates.hpp"
+#include "SearchStats.hpp"
+#include "../Core/Trace.hpp"
+#include <memory>
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+
+// Что бот знает о партии сверх поля. Поиску по линиям хватает поля, движкам режимов
+// со счетом нужны цель, бонусы сторон и событие, которое сработает после хода бота
+struct BotContext {
+    GameMode mode = GameMode::CLASSIC;
+    int targetScore = 100;
+    RandomEvent pendingEvent = RandomEvent::NOTHING;
+    int bonusX = 0;
+    int bonusO = 0;
+    array<int, 8> eventWeights = DEFAULT_EVENT_WEIGHTS;
+    // Бот, общий для нескольких партий, не переносит между ними дерево поиска; 0 - партия у бота одна
+    uint64_t gameId = 0;
+};
+
+// Общий интерфейс движков бота
+class BotEngine {
+    protected:
+        SearchStats stats;
+
+    public:
+        virtual ~BotEngine() = default;
+
+        virtual Position getBestMove(const GameBoard &board, int lineLength) = 0;
+        virtual void setDifficulty(BotDifficulty diff) = 0;
+        virtual void setSymbol(Cell symbol) = 0;
+        virtual BotDifficulty getDifficulty() const = 0;
+        // Вызывается перед каждым getBestMove; классическим движкам контекст не нужен
+        virtual void setContext(const BotContext &) {}
+        
+        // Статистика последнего поиска
+        const SearchStats& getSearchStats() const { return stats; }
+};
+
+// Режимы со счетом - expectimax по событиям и счету; иначе EXPERT - MCTS, остальные уровни - минимакс
+unique_ptr<BotEngine> createBot(BotDifficulty diff, Cell symbol, GameMode mode = GameMode::CLASSIC);
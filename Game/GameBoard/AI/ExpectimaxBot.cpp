@@ -0,0 +1,494 @@
+#include "ExpectimaxBot.hpp"
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+
+static int sideIndex(Cell side) { return side == Cell::X ? 0 : 1; }
+static Cell otherSide(Cell side) { return side == Cell::X ? Cell::O : Cell::X; }
+
+// Деление с округлением вниз и вверх для отрицательных границ окна
+static int64_t floorDiv(int64_t a, int64_t b) { return a / b - ((a % b != 0) && ((a < 0) != (b < 0))); }
+static int64_t ceilDiv(int64_t a, int64_t b) { return -floorDiv(-a, b); }
+
+static int clampValue(int64_t value, int low, int high) {
+    return (int)max<int64_t>(low, min<int64_t>(high, value));
+}
+
+int ExpectimaxBot::totalOf(const State &state, int side, int extraBonus) const {
+    int base = state.lines[side].getScore();
+    if (context.mode != GameMode::RANDOM_EVENTS) return base;
+    return totalScore(base, state.bonus[side] + extraBonus);
+}
+
+// Как в партии: при достижении цели обоими побеждают крестики
+Cell ExpectimaxBot::scoreWinner(const State &state) const {
+    if (totalOf(state, 0) >= context.targetScore) return Cell::X;
+    if (totalOf(state, 1) >= context.targetScore) return Cell::O;
+    return Cell::EMPTY;
+}
+
+// Камень, проверка цели, затем событие и повторная проверка - тот же порядок, что в applyMove партии
+Cell ExpectimaxBot::applyMove(State &state, const Position &move, Cell player, RandomEvent event, Undo &undo) const {
+    int side = sideIndex(player);
+    undo.bonus = state.bonus;
+
+    state.lines[side].place(state.board, move, undo.placed);
+    state.board.set(move, player);
+    Cell winner = scoreWinner(state);
+    if (winner != Cell::EMPTY) return winner;
+
+    switch (event) {
+        case RandomEvent::SCORE_PLUS_10:
+        case RandomEvent::SCORE_MINUS_10:
+        case RandomEvent::SCORE_PLUS_25:
+        case RandomEvent::SCORE_MINUS_25:
+            state.bonus[side] += eventBonus(event);
+            break;
+        case RandomEvent::SWAP_PLAYERS:
+            // Разметка симметрична: после смены разметки сторон просто меняются местами
+            for (const Position &pos : state.board.getOccupiedPositions()) {
+                state.board.set(pos, otherSide(state.board.get(pos)));
+            }
+            state.lines[0].swapStones(state.lines[1]);
+            undo.swapped = true;
+            break;
+        case RandomEvent::CLEAR_AREA:
+            undo.linesBeforeClear.assign(state.lines.begin(), state.lines.end());
+            for (int dx = -1; dx <= 1; dx++) {
+                for (int dy = -1; dy <= 1; dy++) {
+                    Position pos(move.x + dx, move.y + dy);
+                    Cell cell = state.board.get(pos);
+                    if (cell == Cell::EMPTY) continue;
+                    undo.erased.emplace_back(pos, cell);
+                    state.board.erase(pos);
+                }
+            }
+            state.lines[0].rebuild(state.board);
+            state.lines[1].rebuild(state.board);
+            break;
+        default:
+            return Cell::EMPTY;
+    }
+    return scoreWinner(state);
+}
+
+void ExpectimaxBot::undoMove(State &state, Cell player, const Position &move, const Undo &undo) const {
+    if (undo.swapped) {
+        for (const Position &pos : state.board.getOccupiedPositions()) {
+            state.board.set(pos, otherSide(state.board.get(pos)));
+        }
+        state.lines[0].swapStones(state.lines[1]);
+    }
+    if (!undo.linesBeforeClear.empty()) {
+        for (const auto &cell : undo.erased) state.board.set(cell.first, cell.second);
+        state.lines[0] = undo.linesBeforeClear[0];
+        state.lines[1] = undo.linesBeforeClear[1];
+    }
+    state.board.erase(move);
+    state.lines[sideIndex(player)].undo(undo.placed);
+    state.bonus = undo.bonus;
+}
+
+// Лучшая прибавка одним ходом, по линиям с хотя бы одним свободным концом:
+// линия длины L, ставшая L + 1, дает (L + 1)^2 - L^2 = 2L + 1
+int ExpectimaxBot::extensionGain(const GameBoard &board, Cell player) const {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+    int best = 1;
+    for (const Position &start : board.getOccupiedPositions(player)) {
+        for (const auto &dir : directions) {
+            Position before(start.x - dir.first, start.y - dir.second);
+            Cell previous = board.get(before);
+            if (previous == player) continue;
+
+            int length = 1;
+            Position end(start.x + dir.first, start.y + dir.second);
+            while (board.get(end) == player) {
+                length++;
+                end = Position(end.x + dir.first, end.y + dir.second);
+            }
+            if (previous == Cell::EMPTY || board.get(end) == Cell::EMPTY) best = max(best, 2 * length + 1);
+        }
+    }
+    return best;
+}
+
+// Линия длины L за m ходов дорастает до L + m и дает (L + m)^2 - L^2 очков
+int ExpectimaxBot::movesToTarget(int total, int gain) const {
+    int remaining = context.targetScore - total;
+    if (remaining <= 0) return 0;
+    int length = (gain - 1) / 2;
+    int moves = (int)ceil(sqrt((double)length * length + remaining)) - length;
+    while (moves > 1 && (length + moves - 1) * (length + moves - 1) - length * length >= remaining) moves--;
+    return max(1, moves);
+}
+
+int ExpectimaxBot::scoreValue(const State &state, Cell side, int extraBonus, int ownGain, int opponentGain) const {
+    int own = sideIndex(side);
+    // Цель проверяется до события: если ход дотягивает до нее, партия выиграна при любом событии
+    if (totalOf(state, own) + ownGain >= context.targetScore) return evalBound;
+
+    // Гонка к цели: сколько ходов каждой стороне нужно, если растить лучшую открытую линию
+    int ownTotal = totalOf(state, own, extraBonus), opponentTotal = totalOf(state, 1 - own);
+    int race = movesToTarget(opponentTotal, opponentGain) - movesToTarget(ownTotal, ownGain);
+    int value = RACE_WEIGHT * race + (ownTotal - opponentTotal) / 2;
+    return clampValue(value, -evalBound, evalBound);
+}
+
+int ExpectimaxBot::evaluate(const State &state, Cell side, RandomEvent pending) const {
+    return scoreValue(state, side, eventBonus(pending), extensionGain(state.board, side),
+                      extensionGain(state.board, otherSide(side)));
+}
+
+// Горизонт в узле случая: среднее по бонусам событий, прибавки линий считаются один раз
+int ExpectimaxBot::evaluateExpected(const State &state, Cell side) const {
+    int ownGain = extensionGain(state.board, side);
+    int opponentGain = extensionGain(state.board, otherSide(side));
+    int64_t sum = 0;
+    for (const auto &outcome : outcomes) {
+        sum += (int64_t)outcome.second * scoreValue(state, side, eventBonus(outcome.first), ownGain, opponentGain);
+    }
+    return (int)floorDiv(sum, outcomeWeightSum);
+}
+
+// Соседи камней по убыванию пользы; польза зависит от события, которое сработает после хода
+vector<Position> ExpectimaxBot::getOrderedMoves(const State &state, Cell side, RandomEvent pending, int ply) const {
+    const GameBoard &board = state.board;
+    Cell opponent = otherSide(side);
+    int own = sideIndex(side);
+
+    vector<pair<int, Position>> scored;
+    unordered_set<pair<int, int>, PositionHash> seen;
+    for (const Position &stone : board.getOccupiedPositions()) {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Position cell(stone.x + dx, stone.y + dy);
+                if (board.get(cell) != Cell::EMPTY || !seen.insert(cell.toPair()).second) continue;
+
+                int value;
+                if (pending == RandomEvent::CLEAR_AREA) {
+                    // Свой камень сотрется вместе с квадратом: выгодно стирать чужие камни
+                    value = 0;
+                    for (int ax = -1; ax <= 1; ax++) {
+                        for (int ay = -1; ay <= 1; ay++) {
+                            Cell near = board.get(Position(cell.x + ax, cell.y + ay));
+                            if (near == opponent) value += 64;
+                            else if (near == side) value -= 64;
+                        }
+                    }
+                } else {
+                    // Точный прирост своего счета и счета, который клетка дала бы сопернику
+                    int gain = state.lines[own].placeDelta(board, cell);
+                    int blocked = state.lines[1 - own].placeDelta(board, cell);
+                    value = 2 * gain + blocked;
+                    // После смены камень достанется сопернику вместе со всеми своими
+                    if (pending == RandomEvent::SWAP_PLAYERS) value = -value;
+                    // Цель проверяется до события, так что такой ход выигрывает сразу
+                    else if (totalOf(state, own) + gain >= context.targetScore) value = INT_MAX - 1;
+                }
+                if (ply == 0 && cell == rootBestMove) value = INT_MAX;
+                scored.emplace_back(value, cell);
+            }
+        }
+    }
+
+    stable_sort(scored.begin(), scored.end(), [](const pair<int, Position> &a, const pair<int, Position> &b) {
+        return a.first > b.first;
+    });
+    if ((int)scored.size() > maxMovesToConsider) scored.resize(maxMovesToConsider);
+
+    vector<Position> moves;
+    moves.reserve(scored.size());
+    for (const auto &entry : scored) moves.push_back(entry.second);
+    return moves;
+}
+
+// Негамакс по ходам; pending - событие после хода side. firstValue - точное значение первого
+// хода, уже найденное пробой узла случая: второй раз он не ищется. presetMoves - порядок ходов,
+// посчитанный узлом случая один раз на все исходы
+int ExpectimaxBot::searchMoves(State &state, Cell side, RandomEvent pending, int depth, int alpha, int beta, int ply,
+                               bool probeOnly, int firstValue, const vector<Position> *presetMoves) {
+    stats.nodes++;
+    if (checkDeadline()) return 0;
+    if (depth == 0 || ply >= MAX_PLY) {
+        stats.leafEvaluations++;
+        return evaluate(state, side, pending);
+    }
+
+    vector<Position> ownMoves;
+    if (!presetMoves) ownMoves = getOrderedMoves(state, side, pending, ply);
+    const vector<Position> &moves = presetMoves ? *presetMoves : ownMoves;
+    if (moves.empty()) {
+        stats.leafEvaluations++;
+        return evaluate(state, side, pending);
+    }
+    stats.interiorNodes++;
+
+    int best = -winValue - 1;
+    size_t first = 0;
+    if (firstValue != NO_VALUE) {
+        best = firstValue;
+        first = 1;
+        if (best > alpha) alpha = best;
+        if (alpha >= beta) return best;
+    }
+
+    for (size_t i = first; i < moves.size(); i++) {
+        Undo undo;
+        Cell winner = applyMove(state, moves[i], side, pending, undo);
+        int score;
+        if (winner != Cell::EMPTY) {
+            score = winner == side ? winValue - ply - 1 : -(winValue - ply - 1);
+        } else if (pending == RandomEvent::BONUS_MOVE) {
+            // Бонусный ход: тот же игрок ходит снова, события после него нет
+            score = searchMoves(state, side, RandomEvent::NOTHING, depth - 1, alpha, beta, ply + 1, false, NO_VALUE);
+        } else {
+            score = -chance(state, otherSide(side), depth - 1, -beta, -alpha, ply + 1);
+        }
+        undoMove(state, side, moves[i], undo);
+        if (searchAborted) return 0;
+
+        if (score > best) {
+            best = score;
+            if (ply == 0) rootBestMove = moves[i];
+        }
+        if (score > alpha) alpha = score;
+        if (alpha >= beta) {
+            stats.betaCutoffs++;
+            if (i == first) stats.firstMoveCutoffs++;
+            break;
+        }
+        if (probeOnly) break;
+    }
+    return best;
+}
+
+// Узел случая: side еще не сходил, событие после его хода бросается с весами outcomes.
+// Значение - взвешенная сумма исходов, все суммы ведутся в весах, чтобы границы оставались целыми.
+// Star2: сначала проба первого хода каждого исхода дает нижние границы, и если даже они
+// доказывают beta, узел отсекается. Star1: окна полного поиска исходов сужаются так, что выход
+// за окно сразу доказывает выход всего узла за [alpha, beta]
+int ExpectimaxBot::chance(State &state, Cell side, int depth, int alpha, int beta, int ply) {
+    if (outcomes.size() == 1) return searchMoves(state, side, outcomes[0].first, depth, alpha, beta, ply, false, NO_VALUE);
+
+    stats.nodes++;
+    if (checkDeadline()) return 0;
+    if (depth == 0) {
+        stats.leafEvaluations++;
+        return evaluateExpected(state, side);
+    }
+    stats.chanceNodes++;
+
+    const int low = -winValue, high = winValue;
+    const int64_t total = outcomeWeightSum;
+    array<int, 8> lower, firstValue;
+    lower.fill(low);
+    firstValue.fill(NO_VALUE);
+
+    // Поле у всех исходов одно: порядок ходов зависит лишь от того, стирает ли событие квадрат
+    // или меняет камни, и считается один раз на узел, а не для каждой пробы и поиска
+    array<vector<Position>, 3> orderings;
+    array<bool, 3> ordered = {};
+    auto movesFor = [&](RandomEvent event) {
+        int kind = event == RandomEvent::CLEAR_AREA ? 1 : (event == RandomEvent::SWAP_PLAYERS ? 2 : 0);
+        if (!ordered[kind]) {
+            orderings[kind] = getOrderedMoves(state, side, event, ply);
+            ordered[kind] = true;
+        }
+        return &orderings[kind];
+    };
+
+    // Star2: пробы
+    int64_t lowerSum = (int64_t)low * total;
+    for (size_t i = 0; i < outcomes.size(); i++) {
+        int64_t weight = outcomes[i].second;
+        int64_t others = lowerSum - weight * low;
+        int probeBeta = clampValue(ceilDiv((int64_t)beta * total - others, weight), low + 1, high + 1);
+
+        stats.chanceProbes++;
+        int value = searchMoves(state, side, outcomes[i].first, depth, low - 1, probeBeta, ply, true, NO_VALUE,
+                                movesFor(outcomes[i].first));
+        if (searchAborted) return 0;
+
+        if (value < probeBeta) firstValue[i] = value;
+        if (value > low) {
+            lowerSum += weight * (value - low);
+            lower[i] = value;
+        }
+        if (lowerSum >= (int64_t)beta * total) {
+            stats.chanceCutoffs++;
+            return (int)floorDiv(lowerSum, total);
+        }
+    }
+
+    // Star1: полный поиск исходов с суженными окнами
+    int64_t sum = 0;
+    int64_t restLower = lowerSum, restUpper = (int64_t)high * total;
+    for (size_t i = 0; i < outcomes.size(); i++) {
+        int64_t weight = outcomes[i].second;
+        restLower -= weight * lower[i];
+        restUpper -= weight * high;
+        int childAlpha = clampValue(floorDiv((int64_t)alpha * total - sum - restUpper, weight), low - 1, high);
+        int childBeta = clampValue(ceilDiv((int64_t)beta * total - sum - restLower, weight), low, high + 1);
+
+        stats.chanceSearches++;
+        int value = searchMoves(state, side, outcomes[i].first, depth, childAlpha, childBeta, ply, false, firstValue[i],
+                                movesFor(outcomes[i].first));
+        if (searchAborted) return 0;
+
+        sum += weight * value;
+        if (sum + restUpper <= (int64_t)alpha * total) {
+            stats.chanceCutoffs++;
+            return (int)floorDiv(sum + restUpper, total);
+        }
+        if (sum + restLower >= (int64_t)beta * total) {
+            stats.chanceCutoffs++;
+            return (int)ceilDiv(sum + restLower, total);
+        }
+    }
+    return (int)floorDiv(sum, total);
+}
+
+void ExpectimaxBot::prepareOutcomes() {
+    outcomes.clear();
+    outcomeWeightSum = 0;
+    if (context.mode == GameMode::RANDOM_EVENTS) {
+        for (int event = 0; event < (int)context.eventWeights.size(); event++) {
+            if (context.eventWeights[event] <= 0) continue;
+            outcomes.emplace_back((RandomEvent)event, context.eventWeights[event]);
+            outcomeWeightSum += context.eventWeights[event];
+        }
+    }
+    if (outcomes.empty()) {
+        outcomes.emplace_back(RandomEvent::NOTHING, 1);
+        outcomeWeightSum = 1;
+    }
+}
+
+void ExpectimaxBot::applyDifficultySettings() {
+    switch (difficulty) {
+        case BotDifficulty::EASY:
+            searchDepth = 1;
+            maxMovesToConsider = 6;
+            timeBudget = chrono::milliseconds(0);
+            break;
+        case BotDifficulty::MEDIUM:
+            searchDepth = 3;
+            maxMovesToConsider = 6;
+            timeBudget = chrono::milliseconds(1000);
+            break;
+        case BotDifficulty::HARD:
+            searchDepth = 3;
+            maxMovesToConsider = 10;
+            timeBudget = chrono::milliseconds(1500);
+            break;
+        case BotDifficulty::EXPERT:
+            searchDepth = 4;
+            maxMovesToConsider = 12;
+            timeBudget = chrono::milliseconds(3000);
+            break;
+    }
+}
+
+ExpectimaxBot::ExpectimaxBot(BotDifficulty diff, Cell symbol): difficulty(diff), botSymbol(symbol),
+    rng(static_cast<unsigned>(chrono::system_clock::now().time_since_epoch().count())),
+    evalBound(0), winValue(0), outcomeWeightSum(1), timeBudget(0), searchAborted(false), rootBestMove(0, 0) {
+    applyDifficultySettings();
+}
+
+// Линии в счетных режимах не выигрывают, поэтому длина линии не нужна
+Position ExpectimaxBot::getBestMove(const GameBoard &board, int) {
+    using Clock = chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from) {
+        return chrono::duration<double, milli>(Clock::now() - from).count();
+    };
+
+    TraceScope trace("ExpectimaxBot::getBestMove", "bot");
+    stats = SearchStats();
+    auto start = Clock::now();
+
+    if (board.size() == 0) {
+        stats.source = MoveSource::IMMEDIATE;
+        stats.principalVariation = {Position(0, 0)};
+        return Position(0, 0);
+    }
+
+    prepareOutcomes();
+    evalBound = max(1, context.targetScore) + 64;
+    winValue = evalBound + MAX_PLY + 1;
+
+    State state{board, {LineScoreTracker(Cell::X), LineScoreTracker(Cell::O)}, {context.bonusX, context.bonusO}};
+    state.lines[0].rebuild(board);
+    state.lines[1].rebuild(board);
+    vector<Position> rootMoves = getOrderedMoves(state, botSymbol, context.pendingEvent, 1);
+    if (rootMoves.empty()) return Position(0, 0);
+
+    if (difficulty == BotDifficulty::EASY && uniform_int_distribution<int>(0, 100)(rng) < 40) {
+        Position move = rootMoves[uniform_int_distribution<int>(0, rootMoves.size() - 1)(rng)];
+        stats.source = MoveSource::RANDOM;
+        stats.principalVariation = {move};
+        stats.totalMs = elapsedMs(start);
+        return move;
+    }
+
+    // Итеративное углубление; первая итерация доводится до конца при любом бюджете
+    auto searchStart = Clock::now();
+    stats.source = MoveSource::SEARCH;
+    rootBestMove = rootMoves[0];
+    deadline = start + timeBudget;
+    searchAborted = false;
+    int score = 0;
+    for (int depth = 1; depth <= searchDepth; depth++) {
+        TraceScope iterationTrace("iteration", "bot", "depth", depth);
+        auto iterationStart = Clock::now();
+        Position previousBest = rootBestMove;
+        int iterationScore = searchMoves(state, botSymbol, context.pendingEvent, depth, -winValue - 1, winValue + 1, 0,
+                                         false, NO_VALUE);
+        if (searchAborted) {
+            rootBestMove = previousBest;
+            break;
+        }
+        score = iterationScore;
+        stats.iterationMs.push_back(elapsedMs(iterationStart));
+        stats.depthReached = depth;
+        if (abs(score) > evalBound) break;
+    }
+
+    stats.score = score;
+    stats.searchMs = elapsedMs(searchStart);
+    stats.principalVariation = {rootBestMove};
+    stats.totalMs = elapsedMs(start);
+    return rootBestMove;
+}
+
+// Узел стоит десятки микросекунд, поэтому часы опрашиваются раз в 16 узлов
+bool ExpectimaxBot::checkDeadline() {
+    if (searchAborted) return true;
+    if (timeBudget.count() > 0 && stats.depthReached > 0 && (stats.nodes & 15) == 0 && chrono::steady_clock::now() >= deadline) {
+        searchAborted = true;
+    }
+    return searchAborted;
+}
+
+void ExpectimaxBot::setSearchDepth(int depth) {
+    searchDepth = max(1, depth);
+}
+
+void ExpectimaxBot::setTimeBudget(chrono::milliseconds budget) {
+    timeBudget = budget;
+}
+
+void ExpectimaxBot::setDifficulty(BotDifficulty diff) {
+    difficulty = diff;
+    applyDifficultySettings();
+}
+
+void ExpectimaxBot::setSymbol(Cell symbol) {
+    botSymbol = symbol;
+}
+
+void ExpectimaxBot::setContext(const BotContext &newContext) {
+    context = newContext;
+}
+
+BotDifficulty ExpectimaxBot::getDifficulty() const { return difficulty; }
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "BotEngine.hpp"
+#include <array>
+#include <chrono>
+#include <climits>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+
+// Бот режимов со счетом: expectimax с узлами случая по известным весам событий.
+// Событие после хода бота известно заранее, после хода соперника - только распределение;
+// в SCORING событий нет, и поиск сводится к негамаксу за первое достижение цели.
+// Узлы случая отсекаются по Star1/Star2: значения лежат в [-winValue, winValue], проба первого
+// хода каждого исхода дает нижнюю границу, и узел часто отсекается без полного перебора событий
+class ExpectimaxBot : public BotEngine {
+    private:
+        // Позиция поиска: поле, разметка линий и бонусный счет сторон (индекс 0 - крестики).
+        // Разметка обновляется по ходу, базовый счет после хода не пересчитывается по всему полю
+        struct State {
+            GameBoard board;
+            array<LineScoreTracker, 2> lines;
+            array<int, 2> bonus;
+        };
+
+        // Все, что нужно для отката хода вместе с событием; стирание квадрата - редкое событие,
+        // после него разметка строится заново, а для отката сохраняется целиком
+        struct Undo {
+            LineScoreTracker::UndoLog placed;
+            array<int, 2> bonus;
+            vector<pair<Position, Cell>> erased;
+            vector<LineScoreTracker> linesBeforeClear;
+            bool swapped = false;
+        };
+
+        BotDifficulty difficulty;
+        Cell botSymbol;
+        BotContext context;
+        int searchDepth;
+        int maxMovesToConsider;
+        mt19937 rng;
+
+        // Оценка - разность счета в пределах evalBound, победа дороже любой оценки;
+        // обе границы следуют за целью партии, чтобы Star1 получал узкий диапазон
+        static constexpr int NO_VALUE = INT_MIN;
+        static constexpr int MAX_PLY = 64;
+        static constexpr int RACE_WEIGHT = 12;
+        int evalBound;
+        int winValue;
+
+        // Исходы узла случая: события с ненулевым весом и сумма весов
+        vector<pair<RandomEvent, int>> outcomes;
+        int outcomeWeightSum;
+
+        // Ограничение времени: незавершенная итерация отбрасывается
+        chrono::milliseconds timeBudget;
+        chrono::steady_clock::time_point deadline;
+        bool searchAborted;
+        Position rootBestMove;
+
+        // Правила: ход с событием и его откат, победитель по счету
+        int totalOf(const State &state, int side, int extraBonus = 0) const;
+        Cell scoreWinner(const State &state) const;
+        Cell applyMove(State &state, const Position &move, Cell player, RandomEvent event, Undo &undo) const;
+        void undoMove(State &state, Cell player, const Position &move, const Undo &undo) const;
+
+        // Оценка с точки зрения side
+        int extensionGain(const GameBoard &board, Cell player) const;
+        int movesToTarget(int total, int gain) const;
+        int scoreValue(const State &state, Cell side, int extraBonus, int ownGain, int opponentGain) const;
+        int evaluate(const State &state, Cell side, RandomEvent pending) const;
+        int evaluateExpected(const State &state, Cell side) const;
+
+        // Поиск: узел хода (probeOnly - только первый ход, проба Star2) и узел случая
+        vector<Position> getOrderedMoves(const State &state, Cell side, RandomEvent pending, int ply) const;
+        int searchMoves(State &state, Cell side, RandomEvent pending, int depth, int alpha, int beta, int ply,
+                        bool probeOnly, int firstValue, const vector<Position> *presetMoves = nullptr);
+        int chance(State &state, Cell side, int depth, int alpha, int beta, int ply);
+
+        void applyDifficultySettings();
+        void prepareOutcomes();
+        bool checkDeadline();
+
+    public:
+        ExpectimaxBot(BotDifficulty diff = BotDifficulty::MEDIUM, Cell symbol = Cell::O);
+
+        Position getBestMove(const GameBoard &board, int lineLength) override;
+        void setDifficulty(BotDifficulty diff) override;
+        void setSymbol(Cell symbol) override;
+        BotDifficulty getDifficulty() const override;
+        void setContext(const BotContext &context) override;
+
+        // Переопределяют настройки уровня; 0 - без ограничения времени
+        void setSearchDepth(int depth);
+        void setTimeBudget(chrono::milliseconds budget);
+};
@@ -0,0 +1,438 @@
+#include "MCTSBot.hpp"
+#include <algorithm>
+#include <cmath>
+
+
+MCTSBot::Node::Node(const Position &move, Cell player, Node *parent):
+    move(move), player(player), parent(parent), expanded(false), terminal(false),
+    visits(0), wins(0), amafVisits(0), amafWins(0), virtualLoss(0) {}
+
+bool MCTSBot::isWinningMove(const GameBoard &board, const Position &pos, Cell player, int lineLength) const {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+    for (const auto &dir : directions) {
+        int count = 1;
+        for (int i = 1; i < lineLength && board.get(Position(pos.x + dir.first * i, pos.y + dir.second * i)) == player; i++) count++;
+        for (int i = 1; i < lineLength && board.get(Position(pos.x - dir.first * i, pos.y - dir.second * i)) == player; i++) count++;
+        if (count >= lineLength) return true;
+    }
+
+    return false;
+}
+
+optional<Position> MCTSBot::findLineCompletion(const GameBoard &board, Cell player, int lineLength) const {
+    for (const auto &pos : board.getOccupiedPositions(player)) {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Position candidate(pos.x + dx, pos.y + dy);
+                if (board.get(candidate) != Cell::EMPTY || !isInsidePlayingArea(candidate)) continue;
+                if (isWinningMove(board, candidate, player, lineLength)) return candidate;
+            }
+        }
+    }
+
+    return nullopt;
+}
+
+vector<Position> MCTSBot::getCandidateMoves(const GameBoard &board) const {
+    const int searchRadius = 2;
+    vector<pair<int, Position>> scored;
+    unordered_set<pair<int, int>, PositionHash> seen;
+
+    for (const auto &pos : board.getOccupiedPositions()) {
+        for (int dx = -searchRadius; dx <= searchRadius; dx++) {
+            for (int dy = -searchRadius; dy <= searchRadius; dy++) {
+                Position candidate(pos.x + dx, pos.y + dy);
+                if (board.get(candidate) != Cell::EMPTY || !isInsidePlayingArea(candidate)) continue;
+                if (!seen.insert(candidate.toPair()).second) continue;
+
+                int neighbours = 0;
+                for (int nx = -1; nx <= 1; nx++) {
+                    for (int ny = -1; ny <= 1; ny++) {
+                        if (board.get(Position(candidate.x + nx, candidate.y + ny)) != Cell::EMPTY) neighbours++;
+                    }
+                }
+                scored.emplace_back(neighbours, candidate);
+            }
+        }
+    }
+
+    // Лучшие ходы в конце: раскрываются первыми через pop_back
+    sort(scored.begin(), scored.end(), [](const pair<int, Position> &a, const pair<int, Position> &b) {
+        if (a.first != b.first) return a.first < b.first;
+        return b.second < a.second;
+    });
+
+    vector<Position> moves;
+    moves.reserve(scored.size());
+    for (const auto &entry : scored) moves.push_back(entry.second);
+    return moves;
+}
+
+void MCTSBot::reuseOrResetRoot(const GameBoard &board) {
+    if (root && hasLastBotMove && board.size() == rootStoneCount + 2 && board.get(lastBotMove) == botSymbol) {
+        for (auto &ours : root->children) {
+            if (!(ours->move == lastBotMove)) continue;
+
+            for (auto &reply : ours->children) {
+                if (board.get(reply->move) != opponentSymbol) continue;
+
+                unique_ptr<Node> next = move(reply);
+                next->parent = nullptr;
+                root = move(next);
+                rootStoneCount = board.size();
+                hasLastBotMove = false;
+                return;
+            }
+        }
+    }
+
+    root = make_unique<Node>(Position(0, 0), opponentSymbol, nullptr);
+    rootStoneCount = board.size();
+    hasLastBotMove = false;
+}
+
+void MCTSBot::expandNode(Node *node, const GameBoard &board, int lineLength) const {
+    Cell toMove = (node->player == Cell::X) ? Cell::O : Cell::X;
+    vector<Position> moves = getCandidateMoves(board);
+
+    // Вынужденные ходы: своя победа, иначе блок победы соперника
+    vector<Position> forced;
+    for (const auto &move : moves) {
+        if (isWinningMove(board, move, toMove, lineLength)) {
+            forced.assign(1, move);
+            break;
+        }
+        if (isWinningMove(board, move, node->player, lineLength)) forced.push_back(move);
+    }
+
+    node->untriedMoves = forced.empty() ? move(moves) : move(forced);
+    node->children.reserve(node->untriedMoves.size());
+    node->expanded = true;
+}
+
+float MCTSBot::childValue(const Node *child, float logParentVisits) const {
+    int n = child->visits.load() + child->virtualLoss.load();
+    if (n == 0) return 1e9f;
+
+    // Виртуальные потери считаются проигрышами, чтобы потоки расходились по разным ветвям
+    float q = child->wins.load() / (2.0f * n);
+
+    if (useRave) {
+        int amafN = child->amafVisits.load();
+        if (amafN > 0) {
+            float amafQ = child->amafWins.load() / (2.0f * amafN);
+            float beta = sqrt(raveEquivalence / (3.0f * n + raveEquivalence));
+            q = (1.0f - beta) * q + beta * amafQ;
+        }
+    }
+
+    return q + explorationConstant * sqrt(logParentVisits / n);
+}
+
+MCTSBot::Node* MCTSBot::selectChild(Node *node) const {
+    float logParentVisits = log((float)max(1, node->visits.load() + node->virtualLoss.load()));
+
+    Node *best = nullptr;
+    float bestValue = -1e18f;
+    for (auto &child : node->children) {
+        float value = childValue(child.get(), logParentVisits);
+        if (value > bestValue) {
+            bestValue = value;
+            best = child.get();
+        }
+    }
+
+    return best;
+}
+
+Cell MCTSBot::playout(Worker &worker, Cell toMove, int lineLength) {
+    worker.frontier.clear();
+    for (const auto &pos : worker.board.getOccupiedPositions()) {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Position candidate(pos.x + dx, pos.y + dy);
+                if (worker.board.get(candidate) == Cell::EMPTY && isInsidePlayingArea(candidate)) worker.frontier.push_back(candidate);
+            }
+        }
+    }
+
+    int movesMade = 0;
+    while (movesMade < maxPlayoutMoves && !worker.frontier.empty()) {
+        size_t index = worker.rng() % worker.frontier.size();
+        Position pos = worker.frontier[index];
+        worker.frontier[index] = worker.frontier.back();
+        worker.frontier.pop_back();
+
+        if (worker.board.get(pos) != Cell::EMPTY) continue;
+
+        worker.board.set(pos, toMove);
+        worker.placed.push_back(pos);
+        if (useRave) worker.amafMoves.emplace(pos.toPair(), toMove);
+
+        if (isWinningMove(worker.board, pos, toMove, lineLength)) return toMove;
+
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Position candidate(pos.x + dx, pos.y + dy);
+                if (worker.board.get(candidate) == Cell::EMPTY && isInsidePlayingArea(candidate)) worker.frontier.push_back(candidate);
+            }
+        }
+
+        toMove = (toMove == Cell::X) ? Cell::O : Cell::X;
+        movesMade++;
+    }
+
+    return Cell::EMPTY;
+}
+
+void MCTSBot::backpropagate(Worker &worker, Node *leaf, Cell winner) {
+    for (Node *node = leaf; node; node = node->parent) {
+        if (node != root.get()) node->virtualLoss--;
+        node->visits++;
+        if (winner == node->player) node->wins += 2;
+        else if (winner == Cell::EMPTY) node->wins += 1;
+
+        if (!useRave) continue;
+
+        // AMAF: ходы, сыгранные тем же игроком позже в симуляции, обновляют соответствующих детей
+        {
+            lock_guard<mutex> guard(node->lock);
+            for (auto &child : node->children) {
+                auto it = worker.amafMoves.find(child->move.toPair());
+                if (it == worker.amafMoves.end() || it->second != child->player) continue;
+
+                child->amafVisits++;
+                if (winner == child->player) child->amafWins += 2;
+                else if (winner == Cell::EMPTY) child->amafWins += 1;
+            }
+        }
+        if (node->parent) worker.amafMoves[node->move.toPair()] = node->player;
+    }
+}
+
+void MCTSBot::runIteration(Worker &worker, int lineLength) {
+    Node *node = root.get();
+    Cell winner = Cell::EMPTY;
+    bool finished = false;
+
+    worker.placed.clear();
+    worker.amafMoves.clear();
+
+    while (true) {
+        unique_lock<mutex> guard(node->lock);
+
+        if (node->terminal) {
+            winner = node->player;
+            finished = true;
+            break;
+        }
+
+        if (!node->expanded) expandNode(node, worker.board, lineLength);
+
+        Cell toMove = (node->player == Cell::X) ? Cell::O : Cell::X;
+
+        if (!node->untriedMoves.empty()) {
+            Position move = node->untriedMoves.back();
+            node->untriedMoves.pop_back();
+
+            worker.board.set(move, toMove);
+            worker.placed.push_back(move);
+
+            auto child = make_unique<Node>(move, toMove, node);
+            child->terminal = isWinningMove(worker.board, move, toMove, lineLength);
+            child->virtualLoss++;
+            Node *added = child.get();
+            node->children.push_back(std::move(child));
+            guard.unlock();
+
+            node = added;
+            if (node->terminal) {
+                winner = toMove;
+                finished = true;
+            }
+            break;
+        }
+
+        if (node->children.empty()) {
+            finished = true;
+            break;
+        }
+
+        Node *next = selectChild(node);
+        next->virtualLoss++;
+        guard.unlock();
+
+        worker.board.set(next->move, next->player);
+        worker.placed.push_back(next->move);
+        node = next;
+    }
+
+    if (!finished) {
+        Cell toMove = (node->player == Cell::X) ? Cell::O : Cell::X;
+        winner = playout(worker, toMove, lineLength);
+    }
+
+    backpropagate(worker, node, winner);
+
+    for (const auto &pos : worker.placed) worker.board.erase(pos);
+}
+
+void MCTSBot::runWorker(Worker &worker, const GameBoard &board, int lineLength, chrono::steady_clock::time_point deadline) {
+    TraceScope trace("MCTSBot::runWorker", "bot");
+    worker.board = board;
+
+    while (chrono::steady_clock::now() < deadline && iterationsDone.load() < maxIterations) {
+        runIteration(worker, lineLength);
+        iterationsDone++;
+    }
+}
+
+// Бюджет поиска по уровню; setTimeBudget переопределяет время до следующей смены уровня
+void MCTSBot::applyDifficultySettings() {
+    switch (difficulty) {
+        case BotDifficulty::EASY:
+            timeBudget = chrono::milliseconds(150);
+            maxIterations = 5000;
+            break;
+        case BotDifficulty::MEDIUM:
+            timeBudget = chrono::milliseconds(400);
+            maxIterations = 30000;
+            break;
+        case BotDifficulty::HARD:
+            timeBudget = chrono::milliseconds(800);
+            maxIterations = 120000;
+            break;
+        case BotDifficulty::EXPERT:
+            timeBudget = chrono::milliseconds(1500);
+            maxIterations = 400000;
+            break;
+    }
+}
+
+MCTSBot::MCTSBot(BotDifficulty diff, Cell symbol):
+    difficulty(diff), botSymbol(symbol), timeBudget(1500), maxIterations(400000),
+    threadCount(max(1u, thread::hardware_concurrency())), maxPlayoutMoves(80),
+    explorationConstant(0.7f), useRave(true), raveEquivalence(1000.0f),
+    hasPlayingArea(false), areaMinX(0), areaMinY(0), areaMaxX(0), areaMaxY(0),
+    rootStoneCount(0), lastBotMove(0, 0), hasLastBotMove(false), gameId(0), iterationsDone(0) {
+    opponentSymbol = (botSymbol == Cell::X) ? Cell::O : Cell::X;
+    applyDifficultySettings();
+}
+
+Position MCTSBot::getBestMove(const GameBoard &board, int lineLength) {
+    auto start = chrono::steady_clock::now();
+    auto elapsedMs = [](chrono::steady_clock::time_point from) {
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - from).count();
+    };
+
+    TraceScope trace("MCTSBot::getBestMove", "bot");
+    stats = SearchStats();
+    if (board.size() == 0) {
+        Position center(0, 0);
+        return isInsidePlayingArea(center) ? center : Position((areaMinX + areaMaxX) / 2, (areaMinY + areaMaxY) / 2);
+    }
+
+    auto immediate = findLineCompletion(board, botSymbol, lineLength);
+    if (!immediate.has_value()) immediate = findLineCompletion(board, opponentSymbol, lineLength);
+    stats.immediateMs = elapsedMs(start);
+    if (immediate.has_value()) {
+        root.reset();
+        hasLastBotMove = false;
+        stats.source = MoveSource::IMMEDIATE;
+        stats.principalVariation = {immediate.value()};
+        stats.totalMs = elapsedMs(start);
+        return immediate.value();
+    }
+
+    reuseOrResetRoot(board);
+
+    auto deadline = chrono::steady_clock::now() + timeBudget;
+    iterationsDone = 0;
+
+    random_device seedSource;
+    vector<Worker> workers(threadCount);
+    for (auto &worker : workers) worker.rng.seed(seedSource());
+
+    vector<thread> threads;
+    for (int i = 1; i < threadCount; i++) {
+        threads.emplace_back(&MCTSBot::runWorker, this, ref(workers[i]), cref(board), lineLength, deadline);
+    }
+    runWorker(workers[0], board, lineLength, deadline);
+    for (auto &t : threads) t.join();
+
+    // Итерации MCTS считаются узлами; главный вариант - цепочка самых посещаемых детей
+    stats.source = MoveSource::SEARCH;
+    stats.nodes = iterationsDone.load();
+    stats.searchMs = elapsedMs(start) - stats.immediateMs;
+    for (Node *node = root.get(); node && !node->children.empty();) {
+        Node *next = nullptr;
+        for (auto &child : node->children) {
+            if (!next || child->visits.load() > next->visits.load()) next = child.get();
+        }
+        if (next->visits.load() == 0) break;
+        stats.principalVariation.push_back(next->move);
+        node = next;
+    }
+    stats.depthReached = (int)stats.principalVariation.size();
+    stats.totalMs = elapsedMs(start);
+
+    Node *best = nullptr;
+    for (auto &child : root->children) {
+        if (!best || child->visits.load() > best->visits.load()) best = child.get();
+    }
+
+    if (!best) {
+        root.reset();
+        hasLastBotMove = false;
+        auto moves = getCandidateMoves(board);
+        return moves.empty() ? Position(0, 0) : moves.back();
+    }
+
+    // Оценка - доля побед лучшего хода в промилле
+    stats.score = best->wins.load() * 500 / max(1, best->visits.load());
+    lastBotMove = best->move;
+    hasLastBotMove = true;
+    return best->move;
+}
+
+void MCTSBot::setDifficulty(BotDifficulty diff) {
+    difficulty = diff;
+    applyDifficultySettings();
+}
+
+void MCTSBot::setSymbol(Cell symbol) {
+    botSymbol = symbol;
+    opponentSymbol = (botSymbol == Cell::X) ? Cell::O : Cell::X;
+    root.reset();
+    hasLastBotMove = false;
+}
+
+BotDifficulty MCTSBot::getDifficulty() const { return difficulty; }
+
+void MCTSBot::setContext(const BotContext &context) {
+    if (context.gameId == gameId) return;
+    gameId = context.gameId;
+    root.reset();
+    hasLastBotMove = false;
+}
+
+void MCTSBot::setTimeBudget(chrono::milliseconds budget) { timeBudget = budget; }
+void MCTSBot::setThreadCount(int count) { threadCount = max(1, count); }
+void MCTSBot::setRave(bool enabled) { useRave = enabled; }
+
+// Ходы за пределы поля не рассматриваются ни в дереве, ни в симуляциях; дерево строится заново
+void MCTSBot::setPlayingArea(int minX, int minY, int maxX, int maxY) {
+    hasPlayingArea = true;
+    areaMinX = minX;
+    areaMinY = minY;
+    areaMaxX = maxX;
+    areaMaxY = maxY;
+    root.reset();
+    hasLastBotMove = false;
+}
+
+bool MCTSBot::isInsidePlayingArea(const Position &pos) const {
+    if (!hasPlayingArea) return true;
+    return pos.x >= areaMinX && pos.x <= areaMaxX && pos.y >= areaMinY && pos.y <= areaMaxY;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "BotEngine.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+
+class MCTSBot : public BotEngine {
+    private:
+        // Узел дерева: статистика хранится с точки зрения игрока, сделавшего ход move
+        struct Node {
+            Position move;
+            Cell player;
+            Node *parent;
+            vector<unique_ptr<Node>> children;
+            vector<Position> untriedMoves;
+            bool expanded;
+            bool terminal;
+            mutex lock;
+
+            // Результаты в полуочках: победа = 2, ничья = 1
+            atomic<int> visits;
+            atomic<int> wins;
+            atomic<int> amafVisits;
+            atomic<int> amafWins;
+            atomic<int> virtualLoss;
+
+            Node(const Position &move, Cell player, Node *parent);
+        };
+
+        // Рабочее состояние одного потока поиска
+        struct Worker {
+            GameBoard board;
+            mt19937 rng;
+            vector<Position> placed;
+            vector<Position> frontier;
+            unordered_map<pair<int, int>, Cell, PositionHash> amafMoves;
+        };
+
+        BotDifficulty difficulty;
+        Cell botSymbol;
+        Cell opponentSymbol;
+
+        // Параметры поиска
+        chrono::milliseconds timeBudget;
+        int maxIterations;
+        int threadCount;
+        int maxPlayoutMoves;
+        float explorationConstant;
+        bool useRave;
+        float raveEquivalence;
+
+        // Ограниченное поле (протокол Gomocup); по умолчанию поле бесконечно
+        bool hasPlayingArea;
+        int areaMinX, areaMinY, areaMaxX, areaMaxY;
+
+        // Дерево, переиспользуемое между ходами
+        unique_ptr<Node> root;
+        size_t rootStoneCount;
+        Position lastBotMove;
+        bool hasLastBotMove;
+        uint64_t gameId;
+        atomic<int> iterationsDone;
+
+        void applyDifficultySettings();
+
+        // Правила
+        bool isInsidePlayingArea(const Position &pos) const;
+        bool isWinningMove(const GameBoard &board, const Position &pos, Cell player, int lineLength) const;
+        optional<Position> findLineCompletion(const GameBoard &board, Cell player, int lineLength) const;
+        vector<Position> getCandidateMoves(const GameBoard &board) const;
+
+        // Поиск
+        void reuseOrResetRoot(const GameBoard &board);
+        void expandNode(Node *node, const GameBoard &board, int lineLength) const;
+        Node* selectChild(Node *node) const;
+        float childValue(const Node *child, float logParentVisits) const;
+        void runWorker(Worker &worker, const GameBoard &board, int lineLength, chrono::steady_clock::time_point deadline);
+        void runIteration(Worker &worker, int lineLength);
+        Cell playout(Worker &worker, Cell toMove, int lineLength);
+        void backpropagate(Worker &worker, Node *leaf, Cell winner);
+
+    public:
+        MCTSBot(BotDifficulty diff = BotDifficulty::EXPERT, Cell symbol = Cell::O);
+
+        Position getBestMove(const GameBoard &board, int lineLength) override;
+        void setDifficulty(BotDifficulty diff) override;
+        void setSymbol(Cell symbol) override;
+        BotDifficulty getDifficulty() const override;
+        // Дерево другой партии переиспользовать нельзя: совпадение числа камней и хода бота случайно
+        void setContext(const BotContext &context) override;
+
+        void setTimeBudget(chrono::milliseconds budget);
+        void setThreadCount(int count);
+        void setRave(bool enabled);
+        void setPlayingArea(int minX, int minY, int maxX, int maxY);
+};
@@ -0,0 +1,81 @@
+#include "OpeningBook.hpp"
+#include <algorithm>
+#include <cstring>
+
+
+OpeningBook::OpeningBook(): header(nullptr), entries(nullptr) {}
+
+OpeningBook::~OpeningBook() {
+    unload();
+}
+
+OpeningBook& OpeningBook::shared() {
+    static OpeningBook book;
+    return book;
+}
+
+PositionKey OpeningBook::makeKey(const GameBoard &board, Cell toMove) {
+    PositionKey key = computePositionKey(board, true);
+    if (toMove == Cell::X) key.hash ^= 0x9E3779B97F4A7C15ULL;
+    return key;
+}
+
+bool OpeningBook::load(const string &path) {
+    unload();
+    if (!file.open(path) || file.size() < sizeof(BookHeader)) {
+        file.close();
+        return false;
+    }
+
+    // Разбора нет: проверяется только заголовок, записи читаются прямо из отображения.
+    // Число записей сверяется с размером файла делением: произведение на битом заголовке переполняется
+    header = reinterpret_cast<const BookHeader*>(file.data());
+    size_t payload = file.size() - sizeof(BookHeader);
+    bool valid = memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 && header->version == VERSION &&
+                 payload % sizeof(BookEntry) == 0 && header->entryCount == payload / sizeof(BookEntry);
+    if (!valid) {
+        unload();
+        return false;
+    }
+
+    entries = reinterpret_cast<const BookEntry*>(file.data() + sizeof(BookHeader));
+    return true;
+}
+
+void OpeningBook::unload() {
+    file.close();
+    header = nullptr;
+    entries = nullptr;
+}
+
+bool OpeningBook::isLoaded() const { return entries != nullptr; }
+size_t OpeningBook::size() const { return header ? header->entryCount : 0; }
+
+optional<Position> OpeningBook::lookup(const GameBoard &board, Cell toMove, int lineLength, uint32_t roll) const {
+    if (!isLoaded() || (int)header->lineLength != lineLength) return nullopt;
+
+    PositionKey key = makeKey(board, toMove);
+    const BookEntry *first = entries;
+    const BookEntry *last = entries + header->entryCount;
+
+    const BookEntry *begin = lower_bound(first, last, key.hash,
+        [](const BookEntry &entry, uint64_t value) { return entry.key < value; });
+    const BookEntry *end = begin;
+    while (end != last && end->key == key.hash) end++;
+
+    uint32_t totalWeight = 0;
+    for (const BookEntry *it = begin; it != end; it++) totalWeight += it->weight;
+    if (totalWeight == 0) return nullopt;
+
+    uint32_t target = roll % totalWeight;
+    for (const BookEntry *it = begin; it != end; it++) {
+        if (target < it->weight) {
+            Position move = key.transform.inverse(Position(it->moveX, it->moveY));
+            if (board.get(move) != Cell::EMPTY) return nullopt;
+            return move;
+        }
+        target -= it->weight;
+    }
+
+    return nullopt;
+}
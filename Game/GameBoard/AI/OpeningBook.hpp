@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../GameBoard.hpp"
+#include "../PositionKey.hpp"
+#include "../Core/MappedFile.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+using namespace std;
+
+
+// Формат файла: заголовок, затем записи, отсортированные по ключу.
+// Для одной позиции может быть несколько записей с разными ходами.
+#pragma pack(push, 1)
+struct BookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t lineLength;
+    uint64_t entryCount;
+};
+
+struct BookEntry {
+    uint64_t key;
+    int16_t moveX;
+    int16_t moveY;
+    uint16_t weight;
+    uint16_t reserved;
+};
+#pragma pack(pop)
+
+
+class OpeningBook {
+    private:
+        MappedFile file;
+        const BookHeader *header;
+        const BookEntry *entries;
+
+    public:
+        static constexpr char MAGIC[8] = {'T', 'T', 'T', 'B', 'O', 'O', 'K', '1'};
+        static constexpr uint32_t VERSION = 1;
+
+        OpeningBook();
+        ~OpeningBook();
+        OpeningBook(const OpeningBook &) = delete;
+        OpeningBook& operator=(const OpeningBook &) = delete;
+
+        // Книга, общая для всех ботов процесса
+        static OpeningBook& shared();
+
+        // Ключ книги: позиция с точностью до сдвига и симметрий плюс очередь хода
+        static PositionKey makeKey(const GameBoard &board, Cell toMove);
+
+        bool load(const string &path);
+        void unload();
+        bool isLoaded() const;
+        size_t size() const;
+
+        // roll выбирает ход пропорционально весам
+        optional<Position> lookup(const GameBoard &board, Cell toMove, int lineLength, uint32_t roll) const;
+};
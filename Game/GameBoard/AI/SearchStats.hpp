@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../Core/Position.hpp"
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+
+// Откуда взят ход бота
+enum class MoveSource { NONE, IMMEDIATE, BOOK, RANDOM, SEARCH };
+
+// Статистика последнего вызова getBestMove
+struct SearchStats {
+    MoveSource source = MoveSource::NONE;
+    
+    // Узлы: внутренние узлы поиска, узлы форсированного продолжения, оценки листьев
+    uint64_t nodes = 0;
+    uint64_t interiorNodes = 0;
+    uint64_t quiescenceNodes = 0;
+    uint64_t leafEvaluations = 0;
+    
+    // Отсечения: всего и сколько из них дал первый же ход
+    uint64_t betaCutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;
+    
+    // Таблица транспозиций
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    
+    // Узлы случая expectimax: пробы Star2 и полные поиски исходов-событий
+    uint64_t chanceNodes = 0;
+    uint64_t chanceProbes = 0;
+    uint64_t chanceSearches = 0;
+    uint64_t chanceCutoffs = 0;
+    
+    // Поиск на плотном рабочем поле и его повтор на разреженном после выхода ходов за окно
+    bool denseWorkspace = false;
+    bool workspaceFallback = false;
+    
+    int depthReached = 0;
+    int score = 0;
+    
+    // Время по фазам, мс
+    double immediateMs = 0;
+    double bookMs = 0;
+    double searchMs = 0;
+    double totalMs = 0;
+    vector<double> iterationMs;
+    
+    // Главный вариант, начиная с хода бота
+    vector<Position> principalVariation;
+    
+    double nodesPerSecond() const { return totalMs > 0 ? nodes * 1000.0 / totalMs : 0; }
+    double betaCutoffRate() const { return interiorNodes ? (double)betaCutoffs / interiorNodes : 0; }
+    double firstMoveCutoffRate() const { return betaCutoffs ? (double)firstMoveCutoffs / betaCutoffs : 0; }
+    double ttHitRate() const { return ttProbes ? (double)ttHits / ttProbes : 0; }
+    // Полных поисков исходов на узел случая; без отсечений - по числу возможных событий
+    double searchesPerChanceNode() const { return chanceNodes ? (double)chanceSearches / chanceNodes : 0; }
+};
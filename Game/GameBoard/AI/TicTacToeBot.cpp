@@ -1,8 +1,28 @@
 #include "TicTacToeBot.hpp"
 
 
-int TicTacToeBot::evaluateLine(const GameBoard &board, const Position &start, int dx, int dy, Cell player, int lineLength) const {
+// Ход поиска вышел за окно рабочего поля: итерация прерывается и повторяется на разреженном поле
+static bool outsideWorkspace(const GameBoard &) { return false; }
+static bool outsideWorkspace(const WorkspaceBoard &board) { return board.overflowed(); }
+
+// Есть ли клетка, ход в которую сразу выигрывает; на разреженном поле ответ дает только перебор
+static bool mayHaveWinningMove(const GameBoard &, Cell, int) { return true; }
+static bool mayHaveWinningMove(const WorkspaceBoard &board, Cell player, int lineLength) {
+    int firstRow, lastRow;
+    if (!board.stoneRows(1, firstRow, lastRow)) return false;
+    
+    BitRows cells;
+    threatCells(board.bitRows(player), board.bitRows(player == Cell::X ? Cell::O : Cell::X), lineLength, firstRow, lastRow, cells);
+    for (int row = firstRow; row <= lastRow; row++) {
+        if (cells[row]) return true;
+    }
+    return false;
+}
+
+template <typename Board>
+int TicTacToeBot::evaluateLine(const Board &board, const Position &start, int dx, int dy, Cell player, int lineLength) const {
     int bestScore = 0;
+    LineView<Board> line(board, start, dx, dy);
     
     for (int offset = -lineLength + 1; offset <= 0; offset++) {
         int playerCount = 0;
@@ -10,8 +30,7 @@ int TicTacToeBot::evaluateLine(const GameBoard &board, const Position &start, in
         bool blocked = false;
         
         for (int i = 0; i < lineLength; i++) {
-            Position pos(start.x + dx * (offset + i), start.y + dy * (offset + i));
-            Cell cell = board.get(pos);
+            Cell cell = line[offset + i];
             
             if (cell == player) playerCount++;
             else if (cell == Cell::EMPTY) emptyCount++;
@@ -32,7 +51,8 @@ int TicTacToeBot::evaluateLine(const GameBoard &board, const Position &start, in
     return bestScore;
 }
 
-int TicTacToeBot::evaluatePosition(const GameBoard &board, int lineLength) const {
+template <typename Board>
+int TicTacToeBot::evaluatePosition(const Board &board, int lineLength) const {
     int score = 0;
 
     score += evaluateAllLines(board, botSymbol, lineLength);
@@ -42,42 +62,113 @@ int TicTacToeBot::evaluatePosition(const GameBoard &board, int lineLength) const
     return score;
 }
 
-int TicTacToeBot::evaluateAllLines(const GameBoard &board, Cell player, int lineLength) const {
+template <typename Board>
+int TicTacToeBot::evaluateAllLines(const Board &board, Cell player, int lineLength) const {
+    if constexpr (is_same_v<Board, WorkspaceBoard>) return evaluateAllLinesBits(board, player, lineLength);
+    
     int totalScore = 0;
-    auto positions = board.getOccupiedPositions(player);
+    const auto &positions = board.getOccupiedPositions(player);
     
     if (positions.empty()) return 0;
     
     constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
     
-    unordered_map<pair<int, int>, bool, PositionHash> processed;
-    
+    // Пара (камень, направление) встречается один раз, поэтому линии не запоминаются
     for (const auto &pos : positions) {
         for (const auto &dir : directions) {
-            int dx = dir.first, dy = dir.second;
+            totalScore += evaluateLine(board, pos, dir.first, dir.second, player, lineLength);
+        }
+    }
+    
+    return totalScore;
+}
+
+// То же, что evaluateLine по всем камням, но сразу для всех клеток: по каждому направлению ядро
+// считает открытые окна и число камней в них, затем клетка получает оценку первого решающего
+// окна через нее (в порядке evaluateLine), а без решающих окон - лучшего окна с двумя и более камнями
+int TicTacToeBot::evaluateAllLinesBits(const WorkspaceBoard &board, Cell player, int lineLength) const {
+    int firstRow, lastRow;
+    if (board.getOccupiedPositions(player).empty() || !board.stoneRows(lineLength - 1, firstRow, lastRow)) return 0;
+    
+    const BitRows &own = board.bitRows(player);
+    const BitRows &blockers = board.bitRows(player == Cell::X ? Cell::O : Cell::X);
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+    constexpr array<int, 3> decisiveScores = {10000, 1000, 100};
+    
+    int levels = min((int)decisiveScores.size(), lineLength);
+    int totalScore = 0;
+    // Нужны окна с двумя и более камнями и решающие уровни; строки вне [firstRow, lastRow] не читаются
+    int minCount = max(1, min(2, lineLength - levels + 1));
+    WindowTable windows;
+    for (const auto &dir : directions) {
+        int dx = dir.first, dy = dir.second;
+        countWindows(own, blockers, lineLength, dx, dy, minCount, firstRow, lastRow, windows);
+        
+        for (int row = firstRow; row <= lastRow; row++) {
+            uint64_t stones = own[row];
+            if (!stones) continue;
             
-            pair<int, int> lineKey = {pos.x * 1000 + dx, pos.y * 1000 + dy};
-            if (processed[lineKey]) continue;
-            processed[lineKey] = true;
+            // Окна через клетку начинаются на shift клеток раньше; evaluateLine идет от дальнего.
+            // Окно имеет одно число камней, поэтому уровень ищется, только если решающее окно нашлось
+            uint64_t assigned = 0;
+            for (int shift = lineLength - 1; shift >= 0; shift--) {
+                int startRow = row - shift * dy;
+                uint64_t decisive = 0;
+                for (int level = 0; level < levels; level++) decisive |= windows[lineLength - level][startRow];
+                uint64_t found = (decisive << (shift * dx)) & stones & ~assigned;
+                if (!found) continue;
+                
+                for (int level = 0; level < levels; level++) {
+                    uint64_t cells = (windows[lineLength - level][startRow] << (shift * dx)) & found;
+                    totalScore += decisiveScores[level] * __builtin_popcountll(cells);
+                }
+                assigned |= found;
+            }
             
-            totalScore += evaluateLine(board, pos, dx, dy, player, lineLength);
+            for (int count = lineLength - 3; count >= 2; count--) {
+                uint64_t covered = 0;
+                for (int shift = 0; shift < lineLength; shift++) covered |= windows[count][row - shift * dy] << (shift * dx);
+                uint64_t cells = covered & stones & ~assigned;
+                totalScore += count * 10 * __builtin_popcountll(cells);
+                assigned |= cells;
+            }
         }
     }
     
     return totalScore;
 }
 
-int TicTacToeBot::evaluateCenterControl(const GameBoard &board) const {
+// Центр ограниченного поля или центр прямоугольника камней: оценка и порядок ходов
+// не зависят от сдвига позиции, и таблица транспозиций делит записи между сдвигами
+template <typename Board>
+Position TicTacToeBot::evaluationCenter(const Board &board) const {
+    if (hasPlayingArea) return Position(areaMinX + (areaMaxX - areaMinX) / 2, areaMinY + (areaMaxY - areaMinY) / 2);
+    
+    int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+    for (Cell player : {Cell::X, Cell::O}) {
+        for (const auto &pos : board.getOccupiedPositions(player)) {
+            minX = min(minX, pos.x);
+            maxX = max(maxX, pos.x);
+            minY = min(minY, pos.y);
+            maxY = max(maxY, pos.y);
+        }
+    }
+    if (minX > maxX) return Position(0, 0);
+    return Position(minX + (maxX - minX) / 2, minY + (maxY - minY) / 2);
+}
+
+template <typename Board>
+int TicTacToeBot::evaluateCenterControl(const Board &board) const {
     int score = 0;
     
-    Position center(0, 0);
+    Position center = evaluationCenter(board);
     if (board.get(center) == botSymbol) score += 50;
     else if (board.get(center) == opponentSymbol) score -= 60;
     
     for (int dx = -1; dx <= 1; dx++) {
         for (int dy = -1; dy <= 1; dy++) {
             if (dx == 0 && dy == 0) continue;
-            Position pos(dx, dy);
+            Position pos(center.x + dx, center.y + dy);
             Cell cell = board.get(pos);
             
             if (cell == botSymbol) score += 20;
@@ -88,7 +179,8 @@ int TicTacToeBot::evaluateCenterControl(const GameBoard &board) const {
     return score;
 }
 
-optional<Position> TicTacToeBot::checkImmediateWinOrBlock(const GameBoard &board, int lineLength) {
+template <typename Board>
+optional<Position> TicTacToeBot::checkImmediateWinOrBlock(Board &board, int lineLength) {
     auto winMove = findWinningMove(board, botSymbol, lineLength);
     if (winMove.has_value()) return winMove;
     
@@ -98,32 +190,39 @@ optional<Position> TicTacToeBot::checkImmediateWinOrBlock(const GameBoard &board
     return nullopt;
 }
 
-optional<Position> TicTacToeBot::findWinningMove(const GameBoard &board, Cell player, int lineLength) const {
+template <typename Board>
+optional<Position> TicTacToeBot::findWinningMove(Board &board, Cell player, int lineLength) const {
     auto emptyPositions = getPotentialMoves(board);
     
     for (const auto &pos : emptyPositions) {
-        GameBoard tempBoard = board;
-        tempBoard.set(pos, player);
-        if (checkWinForPlayer(tempBoard, player, lineLength)) return pos;
+        board.set(pos, player);
+        bool win = checkWinForPlayer(board, player, lineLength);
+        board.erase(pos);
+        if (win) return pos;
     }
     
     return nullopt;
 }
 
-bool TicTacToeBot::checkWinForPlayer(const GameBoard &board, Cell player, int lineLength) const {
-    auto positions = board.getOccupiedPositions(player);
+template <typename Board>
+bool TicTacToeBot::checkWinForPlayer(const Board &board, Cell player, int lineLength) const {
+    if constexpr (is_same_v<Board, WorkspaceBoard>) {
+        int firstRow, lastRow;
+        return board.stoneRows(0, firstRow, lastRow) && hasLine(board.bitRows(player), lineLength, firstRow, lastRow);
+    }
+    
+    const auto &positions = board.getOccupiedPositions(player);
     
     for (const auto &pos : positions) {
         constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
         
         for (const auto &dir : directions) {
-            int dx = dir.first, dy = dir.second;
+            LineView<Board> line(board, pos, dir.first, dir.second);
             
             for (int offset = -lineLength + 1; offset <= 0; offset++) {
                 bool win = true;
                 for (int i = 0; i < lineLength; i++) {
-                    Position checkPos(pos.x + dx * (offset + i), pos.y + dy * (offset + i));
-                    if (board.get(checkPos) != player) {
+                    if (line[offset + i] != player) {
                         win = false;
                         break;
                     }
@@ -136,82 +235,306 @@ bool TicTacToeBot::checkWinForPlayer(const GameBoard &board, Cell player, int li
     return false;
 }
 
-pair<int, Position> TicTacToeBot::minimax(const GameBoard &board, int depth, int alpha, int beta, bool maximizingPlayer, int lineLength) {
-    if (depth == 0) return {evaluatePosition(board, lineLength), Position(0, 0)};
+template <typename Board>
+bool TicTacToeBot::isWinningMove(const Board &board, const Position &move, Cell player, int lineLength) const {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
     
-    vector<Position> possibleMoves = getPotentialMoves(board);
-    if (possibleMoves.empty()) return {0, Position(0, 0)};
+    for (const auto &dir : directions) {
+        LineView<Board> line(board, move, dir.first, dir.second);
+        int count = 1;
+        for (int i = 1; i < lineLength && line[i] == player; i++) count++;
+        for (int i = 1; i < lineLength && line[-i] == player; i++) count++;
+        if (count >= lineLength) return true;
+    }
     
-    sort(possibleMoves.begin(), possibleMoves.end(),
-        [&](const Position &a, const Position &b) {
-            return evaluateMove(board, a) > evaluateMove(board, b);
-        });
+    return false;
+}
+
+uint64_t TicTacToeBot::transpositionKey(const PositionKey &key, Cell player) const {
+    uint64_t hash = key.hash ^ (player == Cell::X ? SIDE_TO_MOVE_KEY : 0);
+    if (!hasPlayingArea) return hash;
+    
+    uint64_t frame = (uint64_t)(uint32_t)key.transform.offsetX << 32 | (uint32_t)key.transform.offsetY;
+    frame = (frame ^ (frame >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    frame = (frame ^ (frame >> 27)) * 0x94D049BB133111EBULL;
+    return hash ^ frame ^ (frame >> 31);
+}
+
+template <typename Board>
+int TicTacToeBot::negamax(Board &board, int depth, int alpha, int beta, Cell player, int lineLength, int ply, const Position &lastMove,
+    const IncrementalKey &boardKey) {
+    if (depth <= 0) return quiescence(board, alpha, beta, player, lineLength, 0, lastMove);
+    stats.nodes++;
+    stats.interiorNodes++;
+    if (outsideWorkspace(board)) searchAborted = true;
+    if (checkDeadline()) return 0;
+    
+    vector<Position> possibleMoves = getOrderedMoves(board, ply);
+    if (possibleMoves.empty()) return 0;
+    
+    Cell opponent = (player == Cell::X) ? Cell::O : Cell::X;
+    int alphaOriginal = alpha;
+    
+    PositionKey key = boardKey.key();
+    uint64_t ttKey = transpositionKey(key, player);
+    TTEntry &entry = transpositionTable[ttKey & (TT_SIZE - 1)];
+    stats.ttProbes++;
+    
+    if (entry.key == ttKey && entry.depth >= 0) {
+        stats.ttHits++;
+        if (ply > 0 && entry.depth >= depth) {
+            if (entry.bound == Bound::EXACT) return entry.score;
+            if (entry.bound == Bound::LOWER) alpha = max(alpha, entry.score);
+            if (entry.bound == Bound::UPPER) beta = min(beta, entry.score);
+            if (alpha >= beta) return entry.score;
+        }
+        
+        // Лучший ход из таблицы проверяется первым
+        Position hashMove = key.transform.inverse(entry.bestMove);
+        if (ply > 0) {
+            auto it = find(possibleMoves.begin(), possibleMoves.end(), hashMove);
+            if (it != possibleMoves.end()) rotate(possibleMoves.begin(), it, it + 1);
+        }
+    }
+    
+    // Победа в один ход и блок четвёрки соперника не должны отсекаться лимитом ходов;
+    // на рабочем поле кандидаты перебираются, только если карта угроз не пуста
+    vector<Position> blocks;
+    if (mayHaveWinningMove(board, player, lineLength)) {
+        for (const auto &move : getThreatCandidates(board, player)) {
+            if (isWinningMove(board, move, player, lineLength)) {
+                if (ply == 0) rootBestMove = move;
+                return winScore(depth);
+            }
+        }
+    }
+    if (mayHaveWinningMove(board, opponent, lineLength)) {
+        for (const auto &move : getThreatCandidates(board, opponent)) {
+            if (isWinningMove(board, move, opponent, lineLength)) blocks.push_back(move);
+        }
+    }
+    if (!blocks.empty()) possibleMoves = blocks;
     
     int movesToConsider = min(maxMovesToConsider, (int)possibleMoves.size());
+    int bestScore = -INF;
+    Position bestMove = possibleMoves[0];
     
-    if (maximizingPlayer) {
-        int maxEval = INT_MIN;
-        Position bestMove = possibleMoves[0];
+    for (int i = 0; i < movesToConsider; i++) {
+        const Position &move = possibleMoves[i];
         
-        for (int i = 0; i < movesToConsider; i++) {
-            const Position &move = possibleMoves[i];
-            
-            GameBoard newBoard = board;
-            newBoard.set(move, botSymbol);
+        // Выигрышный ход завершает поиск: чем раньше победа, тем выше оценка
+        if (isWinningMove(board, move, player, lineLength)) {
+            if (ply == 0) rootBestMove = move;
+            return winScore(depth);
+        }
+        
+        board.set(move, player);
+        IncrementalKey childKey = boardKey.with(move, player);
+        
+        int score;
+        if (i == 0) {
+            score = -negamax(board, depth - 1, -beta, -alpha, opponent, lineLength, ply + 1, move, childKey);
+        } else {
+            // Поздние ходы сначала проверяются на уменьшенной глубине с нулевым окном
+            int reduction = (i >= lmrFullDepthMoves && depth >= lmrMinDepth) ? 1 : 0;
+            score = -negamax(board, depth - 1 - reduction, -alpha - 1, -alpha, opponent, lineLength, ply + 1, move, childKey);
             
-            if (checkWinForPlayer(newBoard, botSymbol, lineLength)) {
-                return {10000 + depth * 10, move};
+            if (reduction > 0 && score > alpha) {
+                score = -negamax(board, depth - 1, -alpha - 1, -alpha, opponent, lineLength, ply + 1, move, childKey);
             }
-            
-            auto [eval, _] = minimax(newBoard, depth - 1, alpha, beta, false, lineLength);
-            
-            if (eval > maxEval) {
-                maxEval = eval;
-                bestMove = move;
-            }
-            
-            alpha = max(alpha, eval);
-            if (beta <= alpha) {
-                break;
+            if (score > alpha && score < beta) {
+                score = -negamax(board, depth - 1, -beta, -alpha, opponent, lineLength, ply + 1, move, childKey);
             }
         }
         
-        return {maxEval, bestMove};
-    } else {
-        int minEval = INT_MAX;
-        Position bestMove = possibleMoves[0];
+        board.erase(move);
+        if (searchAborted) return 0;
         
-        for (int i = 0; i < movesToConsider; i++) {
-            const Position &move = possibleMoves[i];
-            
-            GameBoard newBoard = board;
-            newBoard.set(move, opponentSymbol);
-            
-            if (checkWinForPlayer(newBoard, opponentSymbol, lineLength)) {
-                return {-10000 - depth * 10, move};
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (ply == 0) rootBestMove = move;
+        }
+        
+        alpha = max(alpha, score);
+        if (alpha >= beta) {
+            stats.betaCutoffs++;
+            if (i == 0) stats.firstMoveCutoffs++;
+            break;
+        }
+    }
+    
+    if (depth >= entry.depth || entry.key != ttKey) {
+        entry.key = ttKey;
+        entry.depth = depth;
+        entry.score = bestScore;
+        entry.bound = (bestScore <= alphaOriginal) ? Bound::UPPER : (bestScore >= beta ? Bound::LOWER : Bound::EXACT);
+        entry.bestMove = key.transform.apply(bestMove);
+    }
+    
+    return bestScore;
+}
+
+template <typename Board>
+TicTacToeBot::Threat TicTacToeBot::classifyThreat(const Board &board, const Position &move, Cell player, int lineLength) const {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+    Threat best = Threat::NONE;
+    
+    // Окно из 2 * lineLength + 1 клеток вокруг хода: 0 - пусто, 1 - свой, 2 - чужой
+    array<int, 2 * MAX_THREAT_LINE + 1> line;
+    if (lineLength > MAX_THREAT_LINE) return Threat::NONE;
+    
+    for (const auto &dir : directions) {
+        LineView<Board> cells(board, move, dir.first, dir.second);
+        for (int i = -lineLength; i <= lineLength; i++) {
+            Cell cell = (i == 0) ? player : cells[i];
+            line[i + lineLength] = (cell == Cell::EMPTY) ? 0 : (cell == player ? 1 : 2);
+        }
+        
+        for (int start = 1; start <= lineLength; start++) {
+            int own = 0;
+            bool blocked = false;
+            for (int i = start; i < start + lineLength; i++) {
+                if (line[i] == 2) {
+                    blocked = true;
+                    break;
+                }
+                own += line[i];
             }
+            if (blocked) continue;
             
-            auto [eval, _] = minimax(newBoard, depth - 1, alpha, beta, true, lineLength);
-            
-            if (eval < minEval) {
-                minEval = eval;
-                bestMove = move;
+            if (own == lineLength) return Threat::WIN;
+            if (own == lineLength - 1) best = Threat::FOUR;
+            else if (own == lineLength - 2 && best == Threat::NONE &&
+                     line[start - 1] == 0 && line[start + lineLength] == 0) best = Threat::OPEN_THREE;
+        }
+    }
+    
+    return best;
+}
+
+template <typename Board>
+vector<Position> TicTacToeBot::getThreatCandidates(const Board &board, Cell player) const {
+    vector<Position> moves;
+    unordered_set<pair<int, int>, PositionHash> moveSet;
+    
+    for (const auto &pos : board.getOccupiedPositions(player)) {
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                Position candidate(pos.x + dx, pos.y + dy);
+                if (board.get(candidate) != Cell::EMPTY || !isInsidePlayingArea(candidate)) continue;
+                if (moveSet.insert(candidate.toPair()).second) moves.push_back(candidate);
             }
+        }
+    }
+    
+    return moves;
+}
+
+template <typename Board>
+int TicTacToeBot::quiescence(Board &board, int alpha, int beta, Cell player, int lineLength, int qDepth, const Position &lastMove) {
+    stats.nodes++;
+    stats.quiescenceNodes++;
+    stats.leafEvaluations++;
+    if (outsideWorkspace(board)) {
+        searchAborted = true;
+        return 0;
+    }
+    Cell opponent = (player == Cell::X) ? Cell::O : Cell::X;
+    
+    int eval = evaluatePosition(board, lineLength);
+    int standPat = (player == botSymbol) ? eval : -eval;
+    if (qDepth >= min(maxQuiescenceDepth, MAX_QUIESCENCE_PLIES)) return standPat;
+    
+    // Тихая позиция: последний ход не создал четвёрку или открытую тройку. Глубже горизонта
+    // последний ход - ответ на форсирующий ход, и своя победа ищется до проверки тишины:
+    // блок одного конца четвёрки сам по себе тихий
+    Threat lastThreat = classifyThreat(board, lastMove, opponent, lineLength);
+    if (lastThreat == Threat::NONE && qDepth == 0) return standPat;
+    
+    vector<pair<int, Position>> forcing;
+    for (const auto &move : getThreatCandidates(board, player)) {
+        Threat own = classifyThreat(board, move, player, lineLength);
+        if (own == Threat::WIN) return winScore(-qDepth);
+        if (own == Threat::FOUR) forcing.emplace_back(1, move);
+    }
+    if (lastThreat == Threat::NONE) return standPat;
+    
+    // Ответы на угрозу лежат на линиях через последний ход соперника
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+    vector<Position> blocks;
+    for (const auto &dir : directions) {
+        LineView<Board> line(board, lastMove, dir.first, dir.second);
+        for (int i = -lineLength + 1; i < lineLength; i++) {
+            Position cell(lastMove.x + dir.first * i, lastMove.y + dir.second * i);
+            if (line[i] != Cell::EMPTY || !isInsidePlayingArea(cell)) continue;
             
-            beta = min(beta, eval);
-            if (beta <= alpha) {
-                break;
-            }
+            Threat their = classifyThreat(board, cell, opponent, lineLength);
+            if (their == Threat::WIN) blocks.push_back(cell);
+            else if (their == Threat::FOUR && lastThreat == Threat::OPEN_THREE) forcing.emplace_back(2, cell);
         }
+    }
+    
+    // Против четвёрки помогает только блок, иначе соперник выигрывает следующим ходом
+    if (!blocks.empty()) {
+        forcing.clear();
+        for (const auto &move : blocks) forcing.emplace_back(3, move);
+    }
+    if (forcing.empty()) return standPat;
+    
+    stable_sort(forcing.begin(), forcing.end(),
+        [](const pair<int, Position> &a, const pair<int, Position> &b) {
+            return a.first > b.first;
+        });
+    
+    int bestScore = -INF;
+    int movesToConsider = min(maxQuiescenceMoves, (int)forcing.size());
+    for (int i = 0; i < movesToConsider; i++) {
+        const Position &move = forcing[i].second;
+        
+        board.set(move, player);
+        int score = -quiescence(board, -beta, -alpha, opponent, lineLength, qDepth + 1, move);
+        board.erase(move);
+        
+        if (score > bestScore) bestScore = score;
+        alpha = max(alpha, score);
+        if (alpha >= beta) break;
+    }
+    
+    return bestScore;
+}
+
+template <typename Board>
+int TicTacToeBot::searchWithAspiration(Board &board, int depth, int previousScore, int lineLength) {
+    int alpha = -INF, beta = INF;
+    if (depth > 1) {
+        alpha = previousScore - aspirationWindow;
+        beta = previousScore + aspirationWindow;
+    }
+    
+    IncrementalKey rootKey(board);
+    while (true) {
+        int score = negamax(board, depth, alpha, beta, botSymbol, lineLength, 0, rootBestMove, rootKey);
+        if (searchAborted) return score;
         
-        return {minEval, bestMove};
+        // Выход за окно: расширяем соответствующую границу и ищем заново
+        if (score <= alpha && alpha > -INF) {
+            alpha = -INF;
+            continue;
+        }
+        if (score >= beta && beta < INF) {
+            beta = INF;
+            continue;
+        }
+        return score;
     }
 }
 
-int TicTacToeBot::evaluateMove(const GameBoard &board, const Position &move) const {
+template <typename Board>
+int TicTacToeBot::evaluateMove(const Board &board, const Position &move, const Position &center) const {
     int score = 0;
     
-    int distance = abs(move.x) + abs(move.y);
+    int distance = abs(move.x - center.x) + abs(move.y - center.y);
     score += (5 - distance) * 10;
     
     for (int dx = -1; dx <= 1; dx++) {
@@ -228,19 +551,17 @@ int TicTacToeBot::evaluateMove(const GameBoard &board, const Position &move) con
     return score;
 }
 
-vector<Position> TicTacToeBot::getPotentialMoves(const GameBoard &board) const {
+template <typename Board>
+vector<Position> TicTacToeBot::getPotentialMoves(const Board &board) const {
     vector<Position> moves;
     unordered_set<pair<int, int>, PositionHash> moveSet;
     
-    int minX, maxX, minY, maxY;
-    board.getBounds(minX, maxX, minY, maxY);
-    
-    int expansion = (difficulty == BotDifficulty::HARD) ? 3 : 2;
     int searchRadius;
     switch (difficulty) {
         case BotDifficulty::EASY: searchRadius = 1; break;
         case BotDifficulty::MEDIUM: searchRadius = 2; break;
-        case BotDifficulty::HARD: searchRadius = 2; break;
+        case BotDifficulty::HARD:
+        case BotDifficulty::EXPERT: searchRadius = 2; break;
     }
     
     auto occupied = board.getOccupiedPositions();
@@ -250,7 +571,7 @@ vector<Position> TicTacToeBot::getPotentialMoves(const GameBoard &board) const {
             for (int dy = -searchRadius; dy <= searchRadius; dy++) {
                 Position candidate(pos.x + dx, pos.y + dy);
                 
-                if (board.get(candidate) == Cell::EMPTY) {
+                if (board.get(candidate) == Cell::EMPTY && isInsidePlayingArea(candidate)) {
                     pair<int, int> key = candidate.toPair();
                     if (moveSet.find(key) == moveSet.end()) {
                         moves.push_back(candidate);
@@ -268,74 +589,238 @@ vector<Position> TicTacToeBot::getPotentialMoves(const GameBoard &board) const {
         }};
         
         for (const auto &pos : startPositions) {
-            if (board.get(pos) == Cell::EMPTY) moves.push_back(pos);
+            if (board.get(pos) == Cell::EMPTY && isInsidePlayingArea(pos)) moves.push_back(pos);
         }
     }
     
     return moves;
 }
 
-TicTacToeBot::TicTacToeBot(BotDifficulty diff, Cell symbol): difficulty(diff), botSymbol(symbol) {
-    opponentSymbol = (botSymbol == Cell::X) ? Cell::O : Cell::X;
+template <typename Board>
+vector<Position> TicTacToeBot::getOrderedMoves(const Board &board, int ply) const {
+    vector<Position> moves = getPotentialMoves(board);
+    Position center = evaluationCenter(board);
+    
+    vector<pair<int, Position>> scored;
+    scored.reserve(moves.size());
+    for (const auto &move : moves) {
+        int score = evaluateMove(board, move, center);
+        if (ply == 0 && move == rootBestMove) score = INF;
+        scored.emplace_back(score, move);
+    }
     
+    stable_sort(scored.begin(), scored.end(),
+        [](const pair<int, Position> &a, const pair<int, Position> &b) {
+            return a.first > b.first;
+        });
+    
+    for (size_t i = 0; i < scored.size(); i++) moves[i] = scored[i].second;
+    return moves;
+}
+
+void TicTacToeBot::applyDifficultySettings() {
     switch (difficulty) {
         case BotDifficulty::EASY:
             searchDepth = 2;
             maxMovesToConsider = 6;
+            maxQuiescenceDepth = 4;
             break;
         case BotDifficulty::MEDIUM:
             searchDepth = 3;
             maxMovesToConsider = 10;
+            maxQuiescenceDepth = 6;
             break;
         case BotDifficulty::HARD:
+        case BotDifficulty::EXPERT:
             searchDepth = 4;
             maxMovesToConsider = 15;
+            maxQuiescenceDepth = 8;
             break;
     }
 }
 
+TicTacToeBot::TicTacToeBot(BotDifficulty diff, Cell symbol): difficulty(diff), botSymbol(symbol),
+    rng(static_cast<unsigned>(chrono::system_clock::now().time_since_epoch().count())),
+    aspirationWindow(50), lmrFullDepthMoves(3), lmrMinDepth(3), rootBestMove(0, 0),
+    timeBudget(0), searchAborted(false), hasPlayingArea(false), areaMinX(0), areaMinY(0), areaMaxX(0), areaMaxY(0),
+    maxQuiescenceMoves(4) {
+    opponentSymbol = (botSymbol == Cell::X) ? Cell::O : Cell::X;
+    applyDifficultySettings();
+    clearTranspositionTable();
+}
+
 Position TicTacToeBot::getBestMove(const GameBoard &board, int lineLength) {
-    auto immediate = checkImmediateWinOrBlock(board, lineLength);
+    using Clock = chrono::steady_clock;
+    auto elapsedMs = [](Clock::time_point from) {
+        return chrono::duration<double, milli>(Clock::now() - from).count();
+    };
+    
+    TraceScope trace("TicTacToeBot::getBestMove", "bot");
+    stats = SearchStats();
+    auto start = Clock::now();
+    
+    // Поиск идет на плотной копии поля, если камни помещаются в окно, иначе на разреженной
+    GameBoard searchBoard = board;
+    WorkspaceBoard workspace;
+    bool useWorkspace = WorkspaceBoard::supportsLineLength(lineLength) && workspace.load(board);
+    
+    optional<Position> immediate;
+    if (useWorkspace) immediate = checkImmediateWinOrBlock(workspace, lineLength);
+    if (!useWorkspace || workspace.overflowed()) {
+        useWorkspace = false;
+        immediate = checkImmediateWinOrBlock(searchBoard, lineLength);
+    }
+    stats.denseWorkspace = useWorkspace;
+    stats.immediateMs = elapsedMs(start);
     if (immediate.has_value()) {
+        stats.source = MoveSource::IMMEDIATE;
+        stats.principalVariation = {immediate.value()};
+        stats.totalMs = elapsedMs(start);
         return immediate.value();
     }
     
+    if (difficulty != BotDifficulty::EASY) {
+        auto bookStart = Clock::now();
+        auto bookMove = OpeningBook::shared().lookup(board, botSymbol, lineLength, rng());
+        stats.bookMs = elapsedMs(bookStart);
+        if (bookMove.has_value() && isInsidePlayingArea(bookMove.value())) {
+            stats.source = MoveSource::BOOK;
+            stats.principalVariation = {bookMove.value()};
+            stats.totalMs = elapsedMs(start);
+            return bookMove.value();
+        }
+    }
+    
     if (difficulty == BotDifficulty::EASY) {
-        static mt19937 rng(static_cast<unsigned>(chrono::system_clock::now().time_since_epoch().count()));
         uniform_int_distribution<int> dist(0, 100);
         if (dist(rng) < 40) {
             auto moves = getPotentialMoves(board);
             if (!moves.empty()) {
                 uniform_int_distribution<int> moveDist(0, moves.size() - 1);
-                return moves[moveDist(rng)];
+                Position move = moves[moveDist(rng)];
+                stats.source = MoveSource::RANDOM;
+                stats.principalVariation = {move};
+                stats.totalMs = elapsedMs(start);
+                return move;
             }
         }
     }
     
-    return minimax(board, searchDepth, INT_MIN, INT_MAX, true, lineLength).second;
+    vector<Position> rootMoves = getPotentialMoves(searchBoard);
+    if (rootMoves.empty()) return Position(0, 0);
+    
+    // Итеративное углубление: лучший ход прошлой итерации проверяется первым
+    auto searchStart = Clock::now();
+    stats.source = MoveSource::SEARCH;
+    rootBestMove = rootMoves[0];
+    deadline = start + timeBudget;
+    searchAborted = false;
+    int score = 0;
+    for (int depth = 1; depth <= searchDepth; depth++) {
+        TraceScope iterationTrace("iteration", "bot", "depth", depth);
+        auto iterationStart = Clock::now();
+        Position previousBest = rootBestMove;
+        int iterationScore = useWorkspace ? searchWithAspiration(workspace, depth, score, lineLength)
+                                          : searchWithAspiration(searchBoard, depth, score, lineLength);
+        if (useWorkspace && workspace.overflowed()) {
+            // Итерация повторяется на разреженном поле; таблица транспозиций от поля не зависит
+            useWorkspace = false;
+            stats.workspaceFallback = true;
+            searchAborted = false;
+            rootBestMove = previousBest;
+            iterationScore = searchWithAspiration(searchBoard, depth, score, lineLength);
+        }
+        if (searchAborted) {
+            rootBestMove = previousBest;
+            break;
+        }
+        score = iterationScore;
+        stats.iterationMs.push_back(elapsedMs(iterationStart));
+        stats.depthReached = depth;
+        if (abs(score) >= WIN_SCORE) break;
+    }
+    
+    stats.score = score;
+    stats.searchMs = elapsedMs(searchStart);
+    stats.principalVariation = extractPrincipalVariation(board, stats.depthReached);
+    stats.totalMs = elapsedMs(start);
+    return rootBestMove;
+}
+
+// Главный вариант восстанавливается по лучшим ходам из таблицы транспозиций
+vector<Position> TicTacToeBot::extractPrincipalVariation(const GameBoard &board, int maxLength) const {
+    vector<Position> line = {rootBestMove};
+    GameBoard pvBoard = board;
+    pvBoard.set(rootBestMove, botSymbol);
+    IncrementalKey pvKey = IncrementalKey(board).with(rootBestMove, botSymbol);
+    Cell player = opponentSymbol;
+    
+    while ((int)line.size() < maxLength) {
+        PositionKey key = pvKey.key();
+        uint64_t ttKey = transpositionKey(key, player);
+        const TTEntry &entry = transpositionTable[ttKey & (TT_SIZE - 1)];
+        if (entry.key != ttKey || entry.depth < 0) break;
+        
+        Position move = key.transform.inverse(entry.bestMove);
+        if (pvBoard.get(move) != Cell::EMPTY) break;
+        
+        line.push_back(move);
+        pvBoard.set(move, player);
+        pvKey.add(move, player);
+        player = (player == Cell::X) ? Cell::O : Cell::X;
+    }
+    
+    return line;
+}
+
+// Узел стоит десятки микросекунд, поэтому часы опрашиваются раз в 16 узлов
+bool TicTacToeBot::checkDeadline() {
+    if (searchAborted) return true;
+    if (timeBudget.count() > 0 && (stats.nodes & 15) == 0 && chrono::steady_clock::now() >= deadline) searchAborted = true;
+    return searchAborted;
+}
+
+void TicTacToeBot::setSearchDepth(int depth) {
+    searchDepth = max(1, depth);
+}
+
+void TicTacToeBot::setTimeBudget(chrono::milliseconds budget) {
+    timeBudget = budget;
+}
+
+void TicTacToeBot::setPlayingArea(int minX, int minY, int maxX, int maxY) {
+    hasPlayingArea = true;
+    areaMinX = minX;
+    areaMinY = minY;
+    areaMaxX = maxX;
+    areaMaxY = maxY;
+}
+
+bool TicTacToeBot::isInsidePlayingArea(const Position &pos) const {
+    if (!hasPlayingArea) return true;
+    return pos.x >= areaMinX && pos.x <= areaMaxX && pos.y >= areaMinY && pos.y <= areaMaxY;
 }
 
 void TicTacToeBot::setDifficulty(BotDifficulty diff) {
     difficulty = diff;
-    switch (difficulty) {
-        case BotDifficulty::EASY:
-            searchDepth = 2;
-            maxMovesToConsider = 6;
-            break;
-        case BotDifficulty::MEDIUM:
-            searchDepth = 3;
-            maxMovesToConsider = 10;
-            break;
-        case BotDifficulty::HARD:
-            searchDepth = 4;
-            maxMovesToConsider = 15;
-            break;
-    }
+    applyDifficultySettings();
+    clearTranspositionTable();
+}
+
+void TicTacToeBot::clearTranspositionTable() {
+    transpositionTable.assign(TT_SIZE, TTEntry{0, -1, 0, Bound::EXACT, Position(0, 0)});
 }
 
 void TicTacToeBot::setSymbol(Cell symbol) {
     botSymbol = symbol;
     opponentSymbol = (botSymbol == Cell::X) ? Cell::O : Cell::X;
+    clearTranspositionTable();
 }
 
 BotDifficulty TicTacToeBot::getDifficulty() const { return difficulty; }
+
+// Оценка вызывается и вне поиска (бенчмарки), поэтому инстанцируется явно для обоих полей
+template int TicTacToeBot::evaluatePosition(const GameBoard &board, int lineLength) const;
+template int TicTacToeBot::evaluatePosition(const WorkspaceBoard &board, int lineLength) const;
+template vector<Position> TicTacToeBot::getPotentialMoves(const GameBoard &board) const;
+template vector<Position> TicTacToeBot::getPotentialMoves(const WorkspaceBoard &board) const;
@@ -1,7 +1,9 @@
 #pragma once
 
-#include "../GameBoard.hpp"
-#include "../../GameStates.hpp"
+#include "BotEngine.hpp"
+#include "../PositionKey.hpp"
+#include "../WorkspaceBoard.hpp"
+#include "OpeningBook.hpp"
 #include <optional>
 #include <vector>
 #include <algorithm>
@@ -14,37 +16,104 @@
 using namespace std;
 
 
-class TicTacToeBot {
+class TicTacToeBot : public BotEngine {
+    friend struct BenchAccess;
+    friend struct SelfCheckAccess;
+
     private:
         BotDifficulty difficulty;
         Cell botSymbol;
         Cell opponentSymbol;
         int searchDepth;
         int maxMovesToConsider;
+        mt19937 rng;
+        
+        // Параметры PVS
+        static constexpr int INF = 1000000000;
+        static constexpr int WIN_SCORE = 1000000;
+        // Победа тем дороже, чем раньше найдена; в тихом поиске оставшаяся глубина отрицательна,
+        // запас MAX_QUIESCENCE_PLIES держит все победы не ниже WIN_SCORE
+        static constexpr int MAX_QUIESCENCE_PLIES = 16;
+        static int winScore(int remainingDepth) { return WIN_SCORE + (remainingDepth + MAX_QUIESCENCE_PLIES) * 10; }
+        int aspirationWindow;
+        int lmrFullDepthMoves;
+        int lmrMinDepth;
+        Position rootBestMove;
+        
+        // Ограничение времени: незавершенная итерация отбрасывается
+        chrono::milliseconds timeBudget;
+        chrono::steady_clock::time_point deadline;
+        bool searchAborted;
+        
+        // Ограниченное поле (протокол Gomocup); по умолчанию поле бесконечно
+        bool hasPlayingArea;
+        int areaMinX, areaMinY, areaMaxX, areaMaxY;
         
-        // Методы оценки
-        int evaluateLine(const GameBoard &board, const Position &start, int dx, int dy, Cell player, int lineLength) const;
-        int evaluatePosition(const GameBoard &board, int lineLength) const;
-        int evaluateAllLines(const GameBoard &board, Cell player, int lineLength) const;
-        int evaluateCenterControl(const GameBoard &board) const;
+        // Форсированное продолжение на горизонте
+        enum class Threat { NONE, OPEN_THREE, FOUR, WIN };
+        static constexpr int MAX_THREAT_LINE = 32;
+        int maxQuiescenceDepth;
+        int maxQuiescenceMoves;
+        
+        // Таблица транспозиций по каноническому ключу позиции
+        enum class Bound { EXACT, LOWER, UPPER };
+        struct TTEntry {
+            uint64_t key;
+            int depth;
+            int score;
+            Bound bound;
+            Position bestMove;
+        };
+        static constexpr size_t TT_SIZE = 1 << 16;
+        static constexpr uint64_t SIDE_TO_MOVE_KEY = 0x5DEECE66DULL;
+        vector<TTEntry> transpositionTable;
+        // Без границ оценка и ходы зависят только от взаимного расположения камней, и позиции,
+        // отличающиеся сдвигом, делят запись; на ограниченном поле ключ включает сдвиг системы ключа
+        uint64_t transpositionKey(const PositionKey &key, Cell player) const;
+        
+        // Методы оценки и поиска шаблонны по полю: GameBoard или плотный WorkspaceBoard
+        template <typename Board> int evaluateLine(const Board &board, const Position &start, int dx, int dy, Cell player, int lineLength) const;
+        template <typename Board> int evaluatePosition(const Board &board, int lineLength) const;
+        template <typename Board> int evaluateAllLines(const Board &board, Cell player, int lineLength) const;
+        template <typename Board> int evaluateCenterControl(const Board &board) const;
+        template <typename Board> Position evaluationCenter(const Board &board) const;
+        int evaluateAllLinesBits(const WorkspaceBoard &board, Cell player, int lineLength) const;
         
         // Поиск ходов
-        optional<Position> checkImmediateWinOrBlock(const GameBoard &board, int lineLength);
-        optional<Position> findWinningMove(const GameBoard &board, Cell player, int lineLength) const;
-        bool checkWinForPlayer(const GameBoard &board, Cell player, int lineLength) const;
+        template <typename Board> optional<Position> checkImmediateWinOrBlock(Board &board, int lineLength);
+        template <typename Board> optional<Position> findWinningMove(Board &board, Cell player, int lineLength) const;
+        template <typename Board> bool checkWinForPlayer(const Board &board, Cell player, int lineLength) const;
+        template <typename Board> bool isWinningMove(const Board &board, const Position &move, Cell player, int lineLength) const;
         
-        // Минимакс
-        pair<int, Position> minimax(const GameBoard &board, int depth, int alpha, int beta, bool maximizingPlayer, int lineLength);
+        // Негамакс с поиском главного варианта
+        template <typename Board> int negamax(Board &board, int depth, int alpha, int beta, Cell player, int lineLength, int ply, const Position &lastMove,
+            const IncrementalKey &boardKey);
+        template <typename Board> int searchWithAspiration(Board &board, int depth, int previousScore, int lineLength);
+        template <typename Board> int quiescence(Board &board, int alpha, int beta, Cell player, int lineLength, int qDepth, const Position &lastMove);
+        template <typename Board> Threat classifyThreat(const Board &board, const Position &move, Cell player, int lineLength) const;
+        template <typename Board> vector<Position> getThreatCandidates(const Board &board, Cell player) const;
         
         // Вспомогательные методы
-        int evaluateMove(const GameBoard &board, const Position &move) const;
-        vector<Position> getPotentialMoves(const GameBoard &board) const;
+        template <typename Board> int evaluateMove(const Board &board, const Position &move, const Position &center) const;
+        template <typename Board> vector<Position> getPotentialMoves(const Board &board) const;
+        template <typename Board> vector<Position> getOrderedMoves(const Board &board, int ply) const;
+        void applyDifficultySettings();
+        void clearTranspositionTable();
+        bool checkDeadline();
+        bool isInsidePlayingArea(const Position &pos) const;
+        vector<Position> extractPrincipalVariation(const GameBoard &board, int maxLength) const;
 
     public:
         TicTacToeBot(BotDifficulty diff = BotDifficulty::MEDIUM, Cell symbol = Cell::O);
         
-        Position getBestMove(const GameBoard &board, int lineLength);
-        void setDifficulty(BotDifficulty diff);
-        void setSymbol(Cell symbol);
-        BotDifficulty getDifficulty() const;
+        Position getBestMove(const GameBoard &board, int lineLength) override;
+        void setDifficulty(BotDifficulty diff) override;
+        void setSymbol(Cell symbol) override;
+        BotDifficulty getDifficulty() const override;
+        
+        // Переопределяют настройки уровня; 0 - без ограничения времени
+        void setSearchDepth(int depth);
+        void setTimeBudget(chrono::milliseconds budget);
+        // Ходы ищутся только внутри прямоугольника, границы включены
+        void setPlayingArea(int minX, int minY, int maxX, int maxY);
 };
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+
+// Примитивы компактных двоичных форматов: varint (LEB128), zigzag и little-endian поля.
+// Малые по модулю числа любого знака занимают один байт.
+
+inline uint64_t zigzagEncode(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+// Контрольная сумма FNV-1a: ловит оборванные при сбое записи, не защищает от подделки
+inline uint32_t checksum32(const uint8_t *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+class BinaryWriter {
+    private:
+        vector<uint8_t> buffer;
+
+    public:
+        void writeByte(uint8_t value) { buffer.push_back(value); }
+
+        void writeVarint(uint64_t value) {
+            while (value >= 0x80) {
+                buffer.push_back((uint8_t)(value | 0x80));
+                value >>= 7;
+            }
+            buffer.push_back((uint8_t)value);
+        }
+
+        void writeSigned(int64_t value) { writeVarint(zigzagEncode(value)); }
+
+        void writeFixed32(uint32_t value) {
+            for (int i = 0; i < 4; i++) buffer.push_back((uint8_t)(value >> (8 * i)));
+        }
+
+        void writeFixed64(uint64_t value) {
+            for (int i = 0; i < 8; i++) buffer.push_back((uint8_t)(value >> (8 * i)));
+        }
+
+        void writeBytes(const void *bytes, size_t count) {
+            const uint8_t *begin = static_cast<const uint8_t*>(bytes);
+            buffer.insert(buffer.end(), begin, begin + count);
+        }
+
+        const vector<uint8_t>& data() const { return buffer; }
+        size_t size() const { return buffer.size(); }
+        void clear() { buffer.clear(); }
+};
+
+// Чтение без копирования; после первой ошибки (конец данных) все чтения возвращают false
+class BinaryReader {
+    private:
+        const uint8_t *begin;
+        const uint8_t *current;
+        const uint8_t *end;
+        bool ok;
+
+    public:
+        BinaryReader(const uint8_t *data = nullptr, size_t size = 0):
+            begin(data), current(data), end(data + size), ok(true) {}
+
+        bool readByte(uint8_t &value) {
+            if (!ok || current >= end) return ok = false;
+            value = *current++;
+            return true;
+        }
+
+        bool readVarint(uint64_t &value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte;
+                if (!readByte(byte)) return false;
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) return true;
+            }
+            return ok = false;
+        }
+
+        bool readSigned(int64_t &value) {
+            uint64_t raw;
+            if (!readVarint(raw)) return false;
+            value = zigzagDecode(raw);
+            return true;
+        }
+
+        bool readFixed32(uint32_t &value) {
+            if (!ok || end - current < 4) return ok = false;
+            value = 0;
+            for (int i = 0; i < 4; i++) value |= (uint32_t)current[i] << (8 * i);
+            current += 4;
+            return true;
+        }
+
+        bool readFixed64(uint64_t &value) {
+            if (!ok || end - current < 8) return ok = false;
+            value = 0;
+            for (int i = 0; i < 8; i++) value |= (uint64_t)current[i] << (8 * i);
+            current += 8;
+            return true;
+        }
+
+        bool readBytes(void *out, size_t count) {
+            if (!ok || (size_t)(end - current) < count) return ok = false;
+            memcpy(out, current, count);
+            current += count;
+            return true;
+        }
+
+        size_t offset() const { return current - begin; }
+        void seek(size_t offset) {
+            ok = offset <= (size_t)(end - begin);
+            current = ok ? begin + offset : end;
+        }
+        bool atEnd() const { return current >= end; }
+        bool good() const { return ok; }
+};
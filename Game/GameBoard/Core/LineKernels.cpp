@@ -0,0 +1,251 @@
+#include "LineKernels.hpp"
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LINE_KERNELS_AVX2 1
+#include <immintrin.h>
+#else
+#define LINE_KERNELS_AVX2 0
+#endif
+
+
+static constexpr array<pair<int, int>, 4> KERNEL_DIRECTIONS = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+// Скалярные ядра: строка за строкой
+
+static bool hasLineScalar(const BitRows &own, int length, int dx, int dy, int firstRow, int lastRow) {
+    for (int row = firstRow; row <= lastRow; row++) {
+        uint64_t line = ~0ULL;
+        for (int i = 0; i < length && line; i++) line &= own[row + i * dy] >> (i * dx);
+        if (line) return true;
+    }
+    return false;
+}
+
+// Число камней own в окнах с началами в строке row разрядными плоскостями; результат - открытые окна
+static uint64_t countPlanes(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int row, uint64_t planes[4]) {
+    uint64_t blocked = 0;
+    for (int bit = 0; bit < 4; bit++) planes[bit] = 0;
+    for (int i = 0; i < length; i++) {
+        uint64_t carry = own[row + i * dy] >> (i * dx);
+        blocked |= blockers[row + i * dy] >> (i * dx);
+        // Сумматор по разрядам: к счетчику каждого окна прибавляется его i-я клетка
+        for (int bit = 0; bit < 4; bit++) {
+            uint64_t next = planes[bit] & carry;
+            planes[bit] ^= carry;
+            carry = next;
+        }
+    }
+    return ~blocked;
+}
+
+static uint64_t equalCount(uint64_t open, const uint64_t planes[4], int count) {
+    for (int bit = 0; bit < 4; bit++) open &= ((count >> bit) & 1) ? planes[bit] : ~planes[bit];
+    return open;
+}
+
+static void countWindowsScalar(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int minCount,
+                               int firstRow, int lastRow, WindowTable &out) {
+    for (int row = firstRow; row <= lastRow; row++) {
+        uint64_t planes[4];
+        uint64_t open = countPlanes(own, blockers, length, dx, dy, row, planes);
+        for (int count = minCount; count <= length; count++) out[count][row] = equalCount(open, planes, count);
+    }
+}
+
+static void windowMaskScalar(const BitRows &own, const BitRows &blockers, int length, int count, int dx, int dy,
+                             int firstRow, int lastRow, BitRows &out) {
+    for (int row = firstRow; row <= lastRow; row++) {
+        uint64_t planes[4];
+        uint64_t open = countPlanes(own, blockers, length, dx, dy, row, planes);
+        out[row] = equalCount(open, planes, count);
+    }
+}
+
+static void coverWindowsScalar(const BitRows &starts, int length, int dx, int dy, int firstRow, int lastRow, BitRows &cells) {
+    for (int row = firstRow; row <= lastRow; row++) {
+        uint64_t covered = 0;
+        for (int i = 0; i < length; i++) covered |= starts[row - i * dy] << (i * dx);
+        cells[row] |= covered;
+    }
+}
+
+// AVX2: четыре строки за раз, остаток строк - скалярно
+
+#if LINE_KERNELS_AVX2
+__attribute__((target("avx2")))
+static bool hasLineAvx2(const BitRows &own, int length, int dx, int dy, int firstRow, int lastRow) {
+    int row = firstRow;
+    for (; row + 3 <= lastRow; row += 4) {
+        __m256i line = _mm256_set1_epi64x(-1);
+        for (int i = 0; i < length; i++) {
+            __m256i cells = _mm256_loadu_si256((const __m256i*)(own.data() + row + i * dy));
+            line = _mm256_and_si256(line, _mm256_srl_epi64(cells, _mm_cvtsi32_si128(i * dx)));
+        }
+        if (!_mm256_testz_si256(line, line)) return true;
+    }
+    return hasLineScalar(own, length, dx, dy, row, lastRow);
+}
+
+__attribute__((target("avx2")))
+static __m256i countPlanesAvx2(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int row, __m256i planes[4]) {
+    __m256i blocked = _mm256_setzero_si256();
+    for (int bit = 0; bit < 4; bit++) planes[bit] = blocked;
+    for (int i = 0; i < length; i++) {
+        __m128i shift = _mm_cvtsi32_si128(i * dx);
+        __m256i carry = _mm256_srl_epi64(_mm256_loadu_si256((const __m256i*)(own.data() + row + i * dy)), shift);
+        __m256i blocker = _mm256_srl_epi64(_mm256_loadu_si256((const __m256i*)(blockers.data() + row + i * dy)), shift);
+        blocked = _mm256_or_si256(blocked, blocker);
+        for (int bit = 0; bit < 4; bit++) {
+            __m256i next = _mm256_and_si256(planes[bit], carry);
+            planes[bit] = _mm256_xor_si256(planes[bit], carry);
+            carry = next;
+        }
+    }
+    return _mm256_xor_si256(blocked, _mm256_set1_epi64x(-1));
+}
+
+__attribute__((target("avx2")))
+static __m256i equalCountAvx2(__m256i open, const __m256i planes[4], int count) {
+    for (int bit = 0; bit < 4; bit++) {
+        open = ((count >> bit) & 1) ? _mm256_and_si256(open, planes[bit]) : _mm256_andnot_si256(planes[bit], open);
+    }
+    return open;
+}
+
+__attribute__((target("avx2")))
+static void countWindowsAvx2(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int minCount,
+                             int firstRow, int lastRow, WindowTable &out) {
+    int row = firstRow;
+    for (; row + 3 <= lastRow; row += 4) {
+        __m256i planes[4];
+        __m256i open = countPlanesAvx2(own, blockers, length, dx, dy, row, planes);
+        for (int count = minCount; count <= length; count++) {
+            _mm256_storeu_si256((__m256i*)(out[count] + row), equalCountAvx2(open, planes, count));
+        }
+    }
+    countWindowsScalar(own, blockers, length, dx, dy, minCount, row, lastRow, out);
+}
+
+__attribute__((target("avx2")))
+static void windowMaskAvx2(const BitRows &own, const BitRows &blockers, int length, int count, int dx, int dy,
+                           int firstRow, int lastRow, BitRows &out) {
+    int row = firstRow;
+    for (; row + 3 <= lastRow; row += 4) {
+        __m256i planes[4];
+        __m256i open = countPlanesAvx2(own, blockers, length, dx, dy, row, planes);
+        _mm256_storeu_si256((__m256i*)(out.data() + row), equalCountAvx2(open, planes, count));
+    }
+    windowMaskScalar(own, blockers, length, count, dx, dy, row, lastRow, out);
+}
+
+__attribute__((target("avx2")))
+static void coverWindowsAvx2(const BitRows &starts, int length, int dx, int dy, int firstRow, int lastRow, BitRows &cells) {
+    int row = firstRow;
+    for (; row + 3 <= lastRow; row += 4) {
+        __m256i covered = _mm256_loadu_si256((const __m256i*)(cells.data() + row));
+        for (int i = 0; i < length; i++) {
+            __m256i window = _mm256_loadu_si256((const __m256i*)(starts.data() + row - i * dy));
+            covered = _mm256_or_si256(covered, _mm256_sll_epi64(window, _mm_cvtsi32_si128(i * dx)));
+        }
+        _mm256_storeu_si256((__m256i*)(cells.data() + row), covered);
+    }
+    coverWindowsScalar(starts, length, dx, dy, row, lastRow, cells);
+}
+#endif
+
+static KernelIsa detectKernelIsa() {
+#if LINE_KERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return KernelIsa::AVX2;
+#endif
+    return KernelIsa::SCALAR;
+}
+
+static KernelIsa& activeKernelIsa() {
+    static KernelIsa isa = detectKernelIsa();
+    return isa;
+}
+
+KernelIsa getKernelIsa() {
+    return activeKernelIsa();
+}
+
+void setKernelIsa(KernelIsa isa) {
+    activeKernelIsa() = (isa == KernelIsa::AVX2) ? detectKernelIsa() : KernelIsa::SCALAR;
+}
+
+const char* kernelIsaName(KernelIsa isa) {
+    return isa == KernelIsa::AVX2 ? "avx2" : "scalar";
+}
+
+// Строки окна не выходят за рамку BitRows
+static bool validRange(int length, int &firstRow, int &lastRow) {
+    firstRow = max(firstRow, 0);
+    lastRow = min(lastRow, BIT_BOARD_ROWS - 1);
+    return length > 0 && length <= MAX_KERNEL_LINE && firstRow <= lastRow;
+}
+
+bool hasLine(const BitRows &own, int length, int firstRow, int lastRow) {
+    if (!validRange(length, firstRow, lastRow)) return false;
+    for (const auto &dir : KERNEL_DIRECTIONS) {
+#if LINE_KERNELS_AVX2
+        if (activeKernelIsa() == KernelIsa::AVX2) {
+            if (hasLineAvx2(own, length, dir.first, dir.second, firstRow, lastRow)) return true;
+            continue;
+        }
+#endif
+        if (hasLineScalar(own, length, dir.first, dir.second, firstRow, lastRow)) return true;
+    }
+    return false;
+}
+
+void countWindows(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int minCount,
+                  int firstRow, int lastRow, WindowTable &out) {
+    if (!validRange(length, firstRow, lastRow)) return;
+    minCount = max(minCount, 0);
+#if LINE_KERNELS_AVX2
+    if (activeKernelIsa() == KernelIsa::AVX2) {
+        countWindowsAvx2(own, blockers, length, dx, dy, minCount, firstRow, lastRow, out);
+        return;
+    }
+#endif
+    countWindowsScalar(own, blockers, length, dx, dy, minCount, firstRow, lastRow, out);
+}
+
+void windowMask(const BitRows &own, const BitRows &blockers, int length, int count, int dx, int dy,
+                int firstRow, int lastRow, BitRows &out) {
+    if (!validRange(length, firstRow, lastRow)) return;
+#if LINE_KERNELS_AVX2
+    if (activeKernelIsa() == KernelIsa::AVX2) {
+        windowMaskAvx2(own, blockers, length, count, dx, dy, firstRow, lastRow, out);
+        return;
+    }
+#endif
+    windowMaskScalar(own, blockers, length, count, dx, dy, firstRow, lastRow, out);
+}
+
+void threatCells(const BitRows &own, const BitRows &blockers, int length, int firstRow, int lastRow, BitRows &cells) {
+    if (!validRange(length, firstRow, lastRow)) return;
+    for (int row = firstRow; row <= lastRow; row++) cells[row] = 0;
+
+    // Окна через клетки строк [firstRow, lastRow] начинаются не дальше length - 1 строк от них
+    int startFirst = max(firstRow - (length - 1), 0);
+    int startLast = min(lastRow + (length - 1), BIT_BOARD_ROWS - 1);
+    for (const auto &dir : KERNEL_DIRECTIONS) {
+        // Открытые окна без одного камня: последняя пустая клетка окна и есть угроза
+        BitRows starts;
+        windowMask(own, blockers, length, length - 1, dir.first, dir.second, startFirst, startLast, starts);
+#if LINE_KERNELS_AVX2
+        if (activeKernelIsa() == KernelIsa::AVX2) {
+            coverWindowsAvx2(starts, length, dir.first, dir.second, firstRow, lastRow, cells);
+            continue;
+        }
+#endif
+        coverWindowsScalar(starts, length, dir.first, dir.second, firstRow, lastRow, cells);
+    }
+
+    for (int row = firstRow; row <= lastRow; row++) cells[row] &= ~(own[row] | blockers[row]);
+}
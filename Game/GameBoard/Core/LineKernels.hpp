@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+using namespace std;
+
+
+// Битовые ядра линий на квадрате 64 x 64: строка - uint64_t, бит x строки y - клетка (x, y).
+// Окно длины length с началом (x, y) по направлению (dx, dy) - клетки (x + i * dx, y + i * dy),
+// dx - 0 или 1, dy - от -1 до 1; клетки за краем квадрата пустые. Строки идут векторами AVX2
+// по четыре, если процессор их поддерживает, иначе по одной; результат совпадает бит в бит
+constexpr int BIT_BOARD_ROWS = 64;
+constexpr int MAX_KERNEL_LINE = 15;
+
+// Строки квадрата с нулевой рамкой: ядра читают до MAX_KERNEL_LINE строк за краем без проверок
+struct BitRows {
+    static constexpr int PADDING = 16;
+    alignas(32) uint64_t padded[BIT_BOARD_ROWS + 2 * PADDING] = {};
+
+    uint64_t* data() { return padded + PADDING; }
+    const uint64_t* data() const { return padded + PADDING; }
+    uint64_t& operator[](int row) { return padded[PADDING + row]; }
+    uint64_t operator[](int row) const { return padded[PADDING + row]; }
+};
+
+// Начала открытых окон (без блокирующих клеток) по числу камней: [n][row]
+using WindowTable = uint64_t[MAX_KERNEL_LINE + 1][BIT_BOARD_ROWS];
+
+enum class KernelIsa { SCALAR, AVX2 };
+
+// Ядра выбираются по процессору при первом вызове; setKernelIsa - для сравнения в бенчмарках,
+// AVX2 включается, только если процессор его поддерживает
+KernelIsa getKernelIsa();
+void setKernelIsa(KernelIsa isa);
+const char* kernelIsaName(KernelIsa isa);
+
+// Строки [firstRow, lastRow] считаются целиком, границы внутри квадрата
+// Есть ли length камней подряд в любом из четырех направлений
+bool hasLine(const BitRows &own, int length, int firstRow, int lastRow);
+// Окна длины length по направлению с minCount..length камнями own; остальные строки таблицы не трогаются
+void countWindows(const BitRows &own, const BitRows &blockers, int length, int dx, int dy, int minCount,
+                  int firstRow, int lastRow, WindowTable &out);
+// Начала открытых окон ровно с count камнями own
+void windowMask(const BitRows &own, const BitRows &blockers, int length, int count, int dx, int dy,
+                int firstRow, int lastRow, BitRows &out);
+// Карта угроз: пустые клетки, камень на которых замыкает length подряд хотя бы в одном направлении
+void threatCells(const BitRows &own, const BitRows &blockers, int length, int firstRow, int lastRow, BitRows &cells);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+
+// Файл, отображенный в память только для чтения (mmap / MapViewOfFile)
+class MappedFile {
+    private:
+        const uint8_t *bytes;
+        size_t byteCount;
+
+#ifdef _WIN32
+        void *fileHandle;
+        void *mappingHandle;
+#else
+        int fileDescriptor;
+#endif
+
+    public:
+        MappedFile();
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile& operator=(const MappedFile &) = delete;
+
+        // Пустой файл не отображается: open вернет false
+        bool open(const string &path);
+        void close();
+
+        bool isOpen() const { return bytes != nullptr; }
+        const uint8_t* data() const { return bytes; }
+        size_t size() const { return byteCount; }
+};
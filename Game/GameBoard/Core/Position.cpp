@@ -9,14 +9,6 @@ bool Position::operator<(const Position &other) const {
     return y < other.y;
 }
 
-Vector2f Position::toPixel(float cellSize, Vector2f center) const {
-    return Vector2f(center.x + (x + 0.5f) * cellSize, center.y + (y + 0.5f) * cellSize);
-}
-
-Vector2f Position::toCorner(float cellSize, Vector2f center) const {
-    return Vector2f(center.x + x * cellSize, center.y + y * cellSize);
-}
-
 float Position::distanceTo(const Position &other) const {
     int dx = x - other.x;
     int dy = y - other.y;
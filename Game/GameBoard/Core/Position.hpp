@@ -1,11 +1,10 @@
 #pragma once
 
-#include <SFML/System.hpp>
 #include <cmath>
 #include <functional>
+#include <utility>
 
 using namespace std;
-using namespace sf;
 
 
 struct PositionHash {
@@ -21,8 +20,6 @@ struct Position {
     bool operator==(const Position &other) const;
     bool operator<(const Position &other) const;
     
-    Vector2f toPixel(float cellSize, Vector2f center) const;
-    Vector2f toCorner(float cellSize, Vector2f center) const;
     float distanceTo(const Position &other) const;
     pair<int, int> toPair() const;
 };
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+using namespace std;
+
+
+// Кольцевая очередь без блокировок: ровно один поток пишет и ровно один читает
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    private:
+        array<T, Capacity> slots;
+        alignas(64) atomic<size_t> head;
+        alignas(64) atomic<size_t> tail;
+
+    public:
+        SpscQueue(): head(0), tail(0) {}
+
+        bool push(T value) {
+            size_t currentTail = tail.load(memory_order_relaxed);
+            if (currentTail - head.load(memory_order_acquire) == Capacity) return false;
+
+            slots[currentTail & (Capacity - 1)] = move(value);
+            tail.store(currentTail + 1, memory_order_release);
+            return true;
+        }
+
+        bool pop(T &out) {
+            size_t currentHead = head.load(memory_order_relaxed);
+            if (currentHead == tail.load(memory_order_acquire)) return false;
+
+            out = move(slots[currentHead & (Capacity - 1)]);
+            slots[currentHead & (Capacity - 1)] = T();
+            head.store(currentHead + 1, memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return head.load(memory_order_acquire) == tail.load(memory_order_acquire);
+        }
+};
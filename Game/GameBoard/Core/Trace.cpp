@@ -0,0 +1,90 @@
+#include "Trace.hpp"
+#include <cstdio>
+
+
+Tracer::Tracer(): enabled(false), origin(chrono::steady_clock::now()), generation(0) {}
+
+Tracer& Tracer::instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+// Буфер потока привязан к поколению трассировки, чтобы повторный start() не писал в старые буферы
+Tracer::ThreadBuffer& Tracer::localBuffer() {
+    thread_local ThreadBuffer *buffer = nullptr;
+    thread_local uint64_t bufferGeneration = 0;
+
+    uint64_t current = generation.load(memory_order_acquire);
+    if (!buffer || bufferGeneration != current) {
+        lock_guard<mutex> guard(registryMutex);
+        buffers.push_back(make_unique<ThreadBuffer>());
+        buffer = buffers.back().get();
+        buffer->threadId = (int)buffers.size();
+        bufferGeneration = current;
+    }
+    return *buffer;
+}
+
+void Tracer::start(const string &path) {
+    lock_guard<mutex> guard(registryMutex);
+    buffers.clear();
+    outputPath = path;
+    origin = chrono::steady_clock::now();
+    generation++;
+    enabled = true;
+}
+
+bool Tracer::stop() {
+    if (!enabled.exchange(false)) return true;
+
+    lock_guard<mutex> guard(registryMutex);
+    FILE *file = fopen(outputPath.c_str(), "w");
+    if (!file) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const auto &buffer : buffers) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", buffer->threadId, buffer->threadId);
+        first = false;
+
+        for (const auto &event : buffer->events) {
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%d",
+                    event.name, event.category, event.phase, (long long)event.timestampUs, buffer->threadId);
+            if (event.phase == 'X') fprintf(file, ",\"dur\":%lld", (long long)event.durationUs);
+            if (event.phase == 'i') fprintf(file, ",\"s\":\"t\"");
+            if (event.argName) fprintf(file, ",\"args\":{\"%s\":%lld}", event.argName, (long long)event.argValue);
+            fprintf(file, "}");
+        }
+    }
+    fprintf(file, "\n]}\n");
+
+    buffers.clear();
+    return fclose(file) == 0;
+}
+
+int64_t Tracer::nowUs() const {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+void Tracer::record(const TraceEvent &event) {
+    if (!isEnabled()) return;
+    localBuffer().events.push_back(event);
+}
+
+void Tracer::instant(const char *name, const char *category, const char *argName, int64_t argValue) {
+    if (!isEnabled()) return;
+    record(TraceEvent{name, category, 'i', nowUs(), 0, argName, argValue});
+}
+
+TraceScope::TraceScope(const char *name, const char *category, const char *argName, int64_t argValue):
+    name(name), category(category), argName(argName), argValue(argValue), startUs(0),
+    active(Tracer::instance().isEnabled()) {
+    if (active) startUs = Tracer::instance().nowUs();
+}
+
+TraceScope::~TraceScope() {
+    if (!active) return;
+    Tracer &tracer = Tracer::instance();
+    tracer.record(TraceEvent{name, category, 'X', startUs, tracer.nowUs() - startUs, argName, argValue});
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Событие в формате Chrome trace: 'X' - отрезок, 'i' - мгновенное
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    char phase;
+    int64_t timestampUs;
+    int64_t durationUs;
+    const char *argName;
+    int64_t argValue;
+};
+
+// Запись трассировки в JSON для chrome://tracing и Perfetto.
+// Каждый поток пишет в свой буфер без блокировок; мьютекс берется только
+// при первой записи потока. stop() вызывается, когда фоновые потоки завершены.
+class Tracer {
+    private:
+        struct ThreadBuffer {
+            int threadId;
+            deque<TraceEvent> events;
+        };
+
+        atomic<bool> enabled;
+        string outputPath;
+        chrono::steady_clock::time_point origin;
+
+        mutex registryMutex;
+        vector<unique_ptr<ThreadBuffer>> buffers;
+        atomic<uint64_t> generation;
+
+        Tracer();
+        ThreadBuffer& localBuffer();
+
+    public:
+        static Tracer& instance();
+
+        void start(const string &path);
+        bool stop();
+        bool isEnabled() const { return enabled.load(memory_order_relaxed); }
+
+        int64_t nowUs() const;
+        void record(const TraceEvent &event);
+        void instant(const char *name, const char *category, const char *argName = nullptr, int64_t argValue = 0);
+};
+
+// Отрезок трассировки на время жизни объекта
+class TraceScope {
+    private:
+        const char *name;
+        const char *category;
+        const char *argName;
+        int64_t argValue;
+        int64_t startUs;
+        bool active;
+
+    public:
+        TraceScope(const char *name, const char *category, const char *argName = nullptr, int64_t argValue = 0);
+        ~TraceScope();
+        TraceScope(const TraceScope &) = delete;
+        TraceScope& operator=(const TraceScope &) = delete;
+};
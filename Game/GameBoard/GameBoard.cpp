@@ -75,6 +75,13 @@ void GameBoard::getBounds(int &minXOut, int &maxXOut, int &minYOut, int &maxYOut
     maxYOut = maxY;
 }
 
+void GameBoard::setBounds(int newMinX, int newMaxX, int newMinY, int newMaxY) {
+    minX = newMinX;
+    maxX = newMaxX;
+    minY = newMinY;
+    maxY = newMaxY;
+}
+
 double GameBoard::getFillPercentage() const {
     if (minX > maxX || minY > maxY) return 0.0;
     
@@ -30,6 +30,8 @@ class GameBoard {
         vector<Position> getOccupiedPositions() const;
         vector<Position> getOccupiedPositions(Cell cellType) const;
         void getBounds(int &minXOut, int &maxXOut, int &minYOut, int &maxYOut) const;
+        // Восстановление сохраненного поля вместе с расширениями
+        void setBounds(int newMinX, int newMaxX, int newMinY, int newMaxY);
         
         double getFillPercentage() const;
         bool shouldExpand(const Position &newPos) const;
@@ -0,0 +1,249 @@
+#include "GameJournal.hpp"
+#include "Core/MappedFile.hpp"
+#include "Core/Trace.hpp"
+#include <algorithm>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+static constexpr uint32_t JOURNAL_VERSION = 2;
+
+// Данные файла доходят до диска, а не только до кэша ОС
+static bool syncFile(FILE *file) {
+    if (fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// На POSIX rename переживает сбой питания, только если сохранен и каталог
+static void syncDirectory(const string &directory) {
+#ifndef _WIN32
+    int descriptor = ::open(directory.c_str(), O_RDONLY);
+    if (descriptor < 0) return;
+    fsync(descriptor);
+    ::close(descriptor);
+#else
+    (void)directory;
+#endif
+}
+
+static void writeSettingsFields(BinaryWriter &writer, const RecordSettings &settings) {
+    writer.writeByte((uint8_t)settings.mode);
+    writer.writeByte((uint8_t)settings.winningLength);
+    writer.writeByte((uint8_t)settings.opponent);
+    writer.writeByte((uint8_t)settings.difficulty);
+    writer.writeFixed32((uint32_t)settings.targetScore);
+    writer.writeFixed32((uint32_t)settings.timeLimit.count());
+}
+
+static bool readSettingsFields(BinaryReader &reader, RecordSettings &settings) {
+    uint8_t mode, winningLength, opponent, difficulty;
+    uint32_t targetScore, timeLimitMs;
+    if (!reader.readByte(mode) || !reader.readByte(winningLength) || !reader.readByte(opponent) || !reader.readByte(difficulty) ||
+        !reader.readFixed32(targetScore) || !reader.readFixed32(timeLimitMs)) return false;
+
+    settings.mode = (GameMode)mode;
+    settings.winningLength = winningLength;
+    settings.opponent = (OpponentType)opponent;
+    settings.difficulty = (BotDifficulty)difficulty;
+    settings.targetScore = (int)targetScore;
+    settings.timeLimit = chrono::milliseconds(timeLimitMs);
+    return true;
+}
+
+// Поколения случайны, а не счетчик: каталог мог остаться от прошлого запуска с тем же счетчиком
+GameJournal::GameJournal(): journal(nullptr), entriesSinceSnapshot(0), unsyncedEntries(0), generations(random_device{}()) {}
+
+GameJournal::~GameJournal() {
+    close();
+}
+
+bool GameJournal::open(const string &newDirectory) {
+    close();
+    error_code error;
+    filesystem::create_directories(newDirectory, error);
+    if (!filesystem::is_directory(newDirectory, error)) return false;
+    directory = newDirectory;
+    return true;
+}
+
+bool GameJournal::restartJournal(uint64_t baseMoves, uint64_t generation) {
+    if (journal) fclose(journal);
+    journal = fopen(journalPath().c_str(), "wb");
+    if (!journal) return false;
+
+    pending.clear();
+    pending.writeBytes(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    pending.writeFixed64(baseMoves);
+    pending.writeFixed64(generation);
+    bool ok = fwrite(pending.data().data(), 1, pending.size(), journal) == pending.size() && syncFile(journal);
+    pending.clear();
+
+    entriesSinceSnapshot = 0;
+    unsyncedEntries = 0;
+    lastSync = chrono::steady_clock::now();
+    return ok;
+}
+
+bool GameJournal::writeSnapshot(const RecordSettings &settings, uint64_t moveCount, const BinaryWriter &state) {
+    if (!isOpen()) return false;
+    TraceScope trace("journalSnapshot", "journal");
+
+    uint64_t generation = generations();
+    BinaryWriter writer;
+    writer.writeBytes(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writer.writeFixed32(JOURNAL_VERSION);
+    writeSettingsFields(writer, settings);
+    writer.writeFixed64(moveCount);
+    writer.writeFixed64(generation);
+    writer.writeFixed32((uint32_t)state.size());
+    writer.writeBytes(state.data().data(), state.size());
+    writer.writeFixed32(checksum32(writer.data().data(), writer.size()));
+
+    string temporaryPath = snapshotPath() + ".tmp";
+    FILE *file = fopen(temporaryPath.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(writer.data().data(), 1, writer.size(), file) == writer.size();
+    ok = syncFile(file) && ok;
+    fclose(file);
+
+    error_code error;
+    if (ok) filesystem::rename(temporaryPath, snapshotPath(), error);
+    if (!ok || error) {
+        filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    syncDirectory(directory);
+
+    // Сбой до нового журнала оставляет старый: его поколение не совпадет со снимком,
+    // и загрузка вернет снимок без хвоста, даже если после отмены в старом журнале есть ходы дальше снимка
+    return restartJournal(moveCount, generation);
+}
+
+void GameJournal::append(const JournalEntry &entry) {
+    if (!journal) return;
+
+    BinaryWriter payload;
+    payload.writeVarint(entry.moveCount);
+    payload.writeSigned(entry.move.x);
+    payload.writeSigned(entry.move.y);
+    payload.writeVarint((uint64_t)max<int64_t>(0, entry.timeLeftX.count()));
+    payload.writeVarint((uint64_t)max<int64_t>(0, entry.timeLeftO.count()));
+    payload.writeByte((uint8_t)entry.nextEvent);
+
+    pending.writeVarint(payload.size());
+    pending.writeBytes(payload.data().data(), payload.size());
+    pending.writeFixed32(checksum32(payload.data().data(), payload.size()));
+
+    // Каждая запись сразу уходит в ОС и переживает падение процесса; на диск - пачкой
+    fwrite(pending.data().data(), 1, pending.size(), journal);
+    fflush(journal);
+    pending.clear();
+
+    entriesSinceSnapshot++;
+    unsyncedEntries++;
+    if (unsyncedEntries >= syncEvery || chrono::steady_clock::now() - lastSync >= syncInterval) sync();
+}
+
+void GameJournal::sync() {
+    if (!journal || unsyncedEntries == 0) return;
+    TraceScope trace("journalSync", "journal");
+    syncFile(journal);
+    unsyncedEntries = 0;
+    lastSync = chrono::steady_clock::now();
+}
+
+void GameJournal::close() {
+    if (journal) {
+        sync();
+        fclose(journal);
+        journal = nullptr;
+    }
+    directory.clear();
+}
+
+void GameJournal::discard() {
+    if (!isOpen()) return;
+    string path = directory;
+    close();
+
+    error_code error;
+    filesystem::remove(path + "/journal.bin", error);
+    filesystem::remove(path + "/snapshot.bin", error);
+}
+
+bool GameJournal::readSettings(const string &directory, RecordSettings &settings) {
+    JournalContents contents;
+    if (!load(directory, contents)) return false;
+    settings = contents.settings;
+    return true;
+}
+
+bool GameJournal::load(const string &directory, JournalContents &contents) {
+    contents = JournalContents();
+
+    MappedFile snapshot;
+    if (!snapshot.open(directory + "/snapshot.bin") || snapshot.size() < sizeof(SNAPSHOT_MAGIC) + 4) return false;
+
+    size_t checkedSize = snapshot.size() - 4;
+    BinaryReader reader(snapshot.data(), snapshot.size());
+    char magic[8];
+    uint32_t version, stateSize, checksum;
+    bool ok = reader.readBytes(magic, sizeof(magic)) && equal(begin(magic), end(magic), SNAPSHOT_MAGIC) &&
+              reader.readFixed32(version) && version == JOURNAL_VERSION &&
+              readSettingsFields(reader, contents.settings) && reader.readFixed64(contents.snapshotMoves) &&
+              reader.readFixed64(contents.generation) && reader.readFixed32(stateSize) && reader.offset() + stateSize == checkedSize;
+    if (!ok) return false;
+
+    contents.state.assign(snapshot.data() + reader.offset(), snapshot.data() + checkedSize);
+    reader.seek(checkedSize);
+    if (!reader.readFixed32(checksum) || checksum != checksum32(snapshot.data(), checkedSize)) return false;
+
+    // Журнала может не быть или он от прошлого снимка (сбой сразу после снимка): тогда хвост пуст
+    MappedFile journal;
+    if (!journal.open(directory + "/journal.bin")) return true;
+
+    BinaryReader entries(journal.data(), journal.size());
+    uint64_t baseMoves, generation;
+    if (!entries.readBytes(magic, sizeof(magic)) || !equal(begin(magic), end(magic), JOURNAL_MAGIC) ||
+        !entries.readFixed64(baseMoves) || !entries.readFixed64(generation) ||
+        generation != contents.generation || baseMoves != contents.snapshotMoves) return true;
+
+    uint64_t expectedMove = contents.snapshotMoves + 1;
+    while (!entries.atEnd()) {
+        uint64_t payloadSize;
+        if (!entries.readVarint(payloadSize) || payloadSize > journal.size() - entries.offset()) break;
+
+        const uint8_t *payload = journal.data() + entries.offset();
+        entries.seek(entries.offset() + payloadSize);
+        uint32_t entryChecksum;
+        if (!entries.readFixed32(entryChecksum) || entryChecksum != checksum32(payload, payloadSize)) break;
+
+        BinaryReader fields(payload, payloadSize);
+        JournalEntry entry;
+        int64_t x, y;
+        uint64_t timeX, timeO;
+        uint8_t nextEvent;
+        if (!fields.readVarint(entry.moveCount) || !fields.readSigned(x) || !fields.readSigned(y) ||
+            !fields.readVarint(timeX) || !fields.readVarint(timeO) || !fields.readByte(nextEvent)) break;
+
+        if (entry.moveCount != expectedMove) break;
+
+        entry.move = Position((int)x, (int)y);
+        entry.timeLeftX = chrono::milliseconds(timeX);
+        entry.timeLeftO = chrono::milliseconds(timeO);
+        entry.nextEvent = (RandomEvent)nextEvent;
+        contents.tail.push_back(entry);
+        expectedMove++;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "GameRecord.hpp"
+#include "Core/BinaryIO.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Ход в журнале: все, что нужно, чтобы повторить его поверх снимка
+struct JournalEntry {
+    uint64_t moveCount = 0;
+    Position move;
+    chrono::milliseconds timeLeftX = chrono::milliseconds(0);
+    chrono::milliseconds timeLeftO = chrono::milliseconds(0);
+    RandomEvent nextEvent = RandomEvent::NOTHING;
+};
+
+// Содержимое каталога автосохранения после загрузки
+struct JournalContents {
+    RecordSettings settings;
+    uint64_t snapshotMoves = 0;
+    uint64_t generation = 0;
+    vector<uint8_t> state;
+    vector<JournalEntry> tail;
+};
+
+// Автосохранение одной партии: snapshot.bin - полное состояние на момент хода snapshotMoves,
+// journal.bin - ходы после него. Снимок заменяется атомарно (запись во временный файл и rename),
+// после чего журнал начинается заново. Снимок и заголовок журнала несут случайное поколение:
+// журнал другого поколения при загрузке не читается, поэтому сбой между rename и новым журналом
+// не повторяет поверх снимка ходы, отмененные до него. Запись журнала с контрольной суммой;
+// оборванный при сбое хвост отбрасывается. fsync - пачками, не чаще syncEvery ходов или syncInterval.
+class GameJournal {
+    private:
+        string directory;
+        FILE *journal;
+        BinaryWriter pending;
+        size_t entriesSinceSnapshot;
+        size_t unsyncedEntries;
+        chrono::steady_clock::time_point lastSync;
+        mt19937_64 generations;
+
+        static constexpr size_t syncEvery = 8;
+        static constexpr chrono::milliseconds syncInterval = chrono::milliseconds(250);
+
+        string snapshotPath() const { return directory + "/snapshot.bin"; }
+        string journalPath() const { return directory + "/journal.bin"; }
+        bool restartJournal(uint64_t baseMoves, uint64_t generation);
+
+    public:
+        static constexpr char SNAPSHOT_MAGIC[8] = {'T', 'T', 'T', 'S', 'N', 'A', 'P', '1'};
+        static constexpr char JOURNAL_MAGIC[8] = {'T', 'T', 'T', 'J', 'R', 'N', 'L', '2'};
+
+        GameJournal();
+        ~GameJournal();
+        GameJournal(const GameJournal &) = delete;
+        GameJournal& operator=(const GameJournal &) = delete;
+
+        // Каталог создается при необходимости; файлы появляются с первым снимком
+        bool open(const string &directory);
+        bool isOpen() const { return !directory.empty(); }
+
+        bool writeSnapshot(const RecordSettings &settings, uint64_t moveCount, const BinaryWriter &state);
+        void append(const JournalEntry &entry);
+        size_t getEntriesSinceSnapshot() const { return entriesSinceSnapshot; }
+
+        void sync();
+        void close();
+        // Партия закончена или брошена: восстанавливать нечего
+        void discard();
+
+        static bool readSettings(const string &directory, RecordSettings &settings);
+        static bool load(const string &directory, JournalContents &contents);
+};
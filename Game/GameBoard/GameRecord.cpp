@@ -0,0 +1,384 @@
+#include "GameRecord.hpp"
+#include <algorithm>
+
+
+static constexpr uint32_t RECORD_VERSION = 1;
+
+GameRecordWriter::GameRecordWriter(): file(nullptr), fileOffset(0), moveCount(0), lastMove(0, 0), lastPlayer(Cell::EMPTY),
+    lastEvent(RandomEvent::NOTHING), lastMoveMs(0), finished(false) {}
+
+GameRecordWriter::~GameRecordWriter() {
+    close();
+}
+
+bool GameRecordWriter::open(const string &path, const RecordSettings &newSettings) {
+    close();
+    file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    settings = newSettings;
+    settings.keyframeInterval = max<uint32_t>(1, settings.keyframeInterval);
+    startTime = chrono::steady_clock::now();
+    fileOffset = 0;
+    moveCount = 0;
+    lastMove = Position(0, 0);
+    lastPlayer = Cell::EMPTY;
+    lastEvent = RandomEvent::NOTHING;
+    lastMoveMs = 0;
+    finished = false;
+    keyframes.clear();
+
+    uint64_t startedAt = chrono::duration_cast<chrono::milliseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    pending.clear();
+    pending.writeBytes(GameRecordReader::MAGIC, sizeof(GameRecordReader::MAGIC));
+    pending.writeFixed32(RECORD_VERSION);
+    pending.writeByte((uint8_t)settings.mode);
+    pending.writeByte((uint8_t)settings.winningLength);
+    pending.writeByte((uint8_t)settings.opponent);
+    pending.writeByte((uint8_t)settings.difficulty);
+    pending.writeFixed32((uint32_t)settings.targetScore);
+    pending.writeFixed32((uint32_t)settings.timeLimit.count());
+    pending.writeFixed32(settings.keyframeInterval);
+    pending.writeFixed64(startedAt);
+    return flush();
+}
+
+bool GameRecordWriter::flush() {
+    if (!file) return false;
+    bool ok = pending.size() == 0 || fwrite(pending.data().data(), 1, pending.size(), file) == pending.size();
+    ok = fflush(file) == 0 && ok;
+    fileOffset += pending.size();
+    pending.clear();
+    return ok;
+}
+
+void GameRecordWriter::recordMove(const Position &move, Cell player) {
+    if (!file || finished) return;
+
+    uint64_t nowMs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count();
+    pending.writeByte((uint8_t)RecordTag::MOVE);
+    pending.writeByte((uint8_t)player);
+    pending.writeSigned(move.x - lastMove.x);
+    pending.writeSigned(move.y - lastMove.y);
+    pending.writeVarint(nowMs - lastMoveMs);
+
+    lastMove = move;
+    lastPlayer = player;
+    lastEvent = RandomEvent::NOTHING;
+    lastMoveMs = nowMs;
+    moveCount++;
+}
+
+void GameRecordWriter::recordEvent(RandomEvent event, Cell player) {
+    if (!file || finished) return;
+    pending.writeByte((uint8_t)RecordTag::EVENT);
+    pending.writeByte((uint8_t)event);
+    pending.writeByte((uint8_t)player);
+    lastEvent = event;
+}
+
+void GameRecordWriter::commitMove(const GameBoard &board, pair<int, int> bonusScore,
+                                  pair<chrono::milliseconds, chrono::milliseconds> timeLeft) {
+    if (!file || finished) return;
+
+    if (settings.mode == GameMode::TIMED) {
+        pending.writeByte((uint8_t)RecordTag::CLOCK);
+        pending.writeVarint((uint64_t)max<int64_t>(0, timeLeft.first.count()));
+        pending.writeVarint((uint64_t)max<int64_t>(0, timeLeft.second.count()));
+    }
+    if (moveCount % settings.keyframeInterval == 0) writeKeyframe(board, bonusScore, timeLeft);
+    flush();
+}
+
+// Камни упорядочены, чтобы смещения между соседними были малы
+void GameRecordWriter::writeKeyframe(const GameBoard &board, pair<int, int> bonusScore,
+                                     pair<chrono::milliseconds, chrono::milliseconds> timeLeft) {
+    keyframes.emplace_back(moveCount, fileOffset + pending.size());
+
+    vector<Position> stones = board.getOccupiedPositions();
+    sort(stones.begin(), stones.end(), [](const Position &a, const Position &b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+
+    pending.writeByte((uint8_t)RecordTag::KEYFRAME);
+    pending.writeVarint(moveCount);
+    pending.writeSigned(lastMove.x);
+    pending.writeSigned(lastMove.y);
+    pending.writeByte((uint8_t)lastPlayer);
+    pending.writeByte((uint8_t)lastEvent);
+    pending.writeVarint(lastMoveMs);
+    pending.writeSigned(bonusScore.first);
+    pending.writeSigned(bonusScore.second);
+    pending.writeVarint((uint64_t)max<int64_t>(0, timeLeft.first.count()));
+    pending.writeVarint((uint64_t)max<int64_t>(0, timeLeft.second.count()));
+    pending.writeVarint(stones.size());
+
+    Position previous(0, 0);
+    for (const auto &stone : stones) {
+        pending.writeSigned(stone.x - previous.x);
+        pending.writeSigned(stone.y - previous.y);
+        pending.writeByte((uint8_t)board.get(stone));
+        previous = stone;
+    }
+}
+
+void GameRecordWriter::recordEnd(Cell winner, bool endedByScore) {
+    if (!file || finished) return;
+    pending.writeByte((uint8_t)RecordTag::END);
+    pending.writeByte((uint8_t)winner);
+    pending.writeByte(endedByScore ? 1 : 0);
+    flush();
+    finished = true;
+}
+
+void GameRecordWriter::close() {
+    if (!file) return;
+
+    uint64_t indexOffset = fileOffset + pending.size();
+    pending.writeByte((uint8_t)RecordTag::INDEX);
+    pending.writeVarint(moveCount);
+    pending.writeVarint(keyframes.size());
+    uint64_t previousMove = 0, previousOffset = 0;
+    for (const auto &keyframe : keyframes) {
+        pending.writeVarint(keyframe.first - previousMove);
+        pending.writeVarint(keyframe.second - previousOffset);
+        previousMove = keyframe.first;
+        previousOffset = keyframe.second;
+    }
+    pending.writeFixed64(indexOffset);
+    pending.writeBytes(GameRecordReader::INDEX_MAGIC, sizeof(GameRecordReader::INDEX_MAGIC));
+    flush();
+
+    fclose(file);
+    file = nullptr;
+}
+
+
+GameRecordReader::GameRecordReader(): firstRecordOffset(0), recordsEnd(0), totalMoves(0) {}
+
+bool GameRecordReader::open(const string &path) {
+    close();
+    if (!file.open(path)) return false;
+
+    BinaryReader reader(file.data(), file.size());
+    if (!readHeader(reader)) {
+        close();
+        return false;
+    }
+    firstRecordOffset = reader.offset();
+
+    if (!loadIndex()) scanRecords();
+    return true;
+}
+
+void GameRecordReader::close() {
+    file.close();
+    keyframes.clear();
+    totalMoves = 0;
+    firstRecordOffset = recordsEnd = 0;
+}
+
+bool GameRecordReader::readHeader(BinaryReader &reader) {
+    char magic[8];
+    uint32_t version, targetScore, timeLimitMs, keyframeInterval;
+    uint8_t mode, winningLength, opponent, difficulty;
+    uint64_t startedAt;
+
+    bool ok = reader.readBytes(magic, sizeof(magic)) && equal(begin(magic), end(magic), MAGIC) &&
+              reader.readFixed32(version) && version == RECORD_VERSION &&
+              reader.readByte(mode) && reader.readByte(winningLength) && reader.readByte(opponent) && reader.readByte(difficulty) &&
+              reader.readFixed32(targetScore) && reader.readFixed32(timeLimitMs) && reader.readFixed32(keyframeInterval) &&
+              reader.readFixed64(startedAt);
+    if (!ok) return false;
+
+    settings.mode = (GameMode)mode;
+    settings.winningLength = winningLength;
+    settings.opponent = (OpponentType)opponent;
+    settings.difficulty = (BotDifficulty)difficulty;
+    settings.targetScore = (int)targetScore;
+    settings.timeLimit = chrono::milliseconds(timeLimitMs);
+    settings.keyframeInterval = max<uint32_t>(1, keyframeInterval);
+    return true;
+}
+
+// Оглавление в конце файла: запись INDEX, ее смещение и метка
+bool GameRecordReader::loadIndex() {
+    const size_t trailerSize = 8 + sizeof(INDEX_MAGIC);
+    if (file.size() < firstRecordOffset + trailerSize) return false;
+
+    const uint8_t *trailer = file.data() + file.size() - trailerSize;
+    if (!equal(INDEX_MAGIC, INDEX_MAGIC + sizeof(INDEX_MAGIC), trailer + 8)) return false;
+
+    BinaryReader reader(file.data(), file.size());
+    reader.seek(file.size() - trailerSize);
+    uint64_t indexOffset;
+    if (!reader.readFixed64(indexOffset) || indexOffset < firstRecordOffset) return false;
+
+    reader.seek(indexOffset);
+    uint8_t tag;
+    uint64_t moves, count;
+    if (!reader.readByte(tag) || tag != (uint8_t)RecordTag::INDEX || !reader.readVarint(moves) || !reader.readVarint(count)) return false;
+
+    vector<Keyframe> loaded;
+    uint64_t moveCount = 0, offset = 0;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t moveDelta, offsetDelta;
+        if (!reader.readVarint(moveDelta) || !reader.readVarint(offsetDelta)) return false;
+        moveCount += moveDelta;
+        offset += offsetDelta;
+        if (offset < firstRecordOffset || offset >= indexOffset) return false;
+        loaded.push_back({moveCount, offset});
+    }
+
+    keyframes = move(loaded);
+    totalMoves = moves;
+    recordsEnd = indexOffset;
+    return true;
+}
+
+// Запись не закрыта (партия идет или прервана): оглавление собирается проходом без построения поля
+void GameRecordReader::scanRecords() {
+    BinaryReader reader(file.data(), file.size());
+    reader.seek(firstRecordOffset);
+    keyframes.clear();
+    totalMoves = 0;
+    recordsEnd = firstRecordOffset;
+
+    RecordTag tag;
+    while (!reader.atEnd()) {
+        size_t offset = reader.offset();
+        if (!applyRecord(reader, nullptr, tag)) break;
+        if (tag == RecordTag::MOVE) totalMoves++;
+        if (tag == RecordTag::KEYFRAME) keyframes.push_back({totalMoves, offset});
+        recordsEnd = reader.offset();
+    }
+}
+
+bool GameRecordReader::applyRecord(BinaryReader &reader, ReplayState *state, RecordTag &tag) const {
+    uint8_t rawTag;
+    if (!reader.readByte(rawTag)) return false;
+    tag = (RecordTag)rawTag;
+
+    switch (tag) {
+        case RecordTag::MOVE: {
+            uint8_t player;
+            int64_t dx, dy;
+            uint64_t dt;
+            if (!reader.readByte(player) || !reader.readSigned(dx) || !reader.readSigned(dy) || !reader.readVarint(dt)) return false;
+            if (state) {
+                state->lastMove = Position(state->lastMove.x + (int)dx, state->lastMove.y + (int)dy);
+                state->board.set(state->lastMove, (Cell)player);
+                state->lastPlayer = (Cell)player;
+                state->lastEvent = RandomEvent::NOTHING;
+                state->timeMs += dt;
+                state->moveCount++;
+            }
+            return true;
+        }
+        case RecordTag::EVENT: {
+            uint8_t event, player;
+            if (!reader.readByte(event) || !reader.readByte(player)) return false;
+            if (!state) return true;
+
+            // Те же правки, что делает InfiniteTicTacToe::handleRandomEvent
+            int &bonus = ((Cell)player == Cell::X) ? state->bonusScore.first : state->bonusScore.second;
+            state->lastEvent = (RandomEvent)event;
+            switch ((RandomEvent)event) {
+                case RandomEvent::SCORE_PLUS_10: bonus += 10; break;
+                case RandomEvent::SCORE_MINUS_10: bonus -= 10; break;
+                case RandomEvent::SCORE_PLUS_25: bonus += 25; break;
+                case RandomEvent::SCORE_MINUS_25: bonus -= 25; break;
+                case RandomEvent::SWAP_PLAYERS:
+                    for (const auto &pos : state->board.getOccupiedPositions()) {
+                        state->board.set(pos, state->board.get(pos) == Cell::X ? Cell::O : Cell::X);
+                    }
+                    break;
+                case RandomEvent::CLEAR_AREA:
+                    for (int dx = -1; dx <= 1; dx++) {
+                        for (int dy = -1; dy <= 1; dy++) state->board.erase(Position(state->lastMove.x + dx, state->lastMove.y + dy));
+                    }
+                    break;
+                default: break;
+            }
+            return true;
+        }
+        case RecordTag::CLOCK: {
+            uint64_t xLeft, oLeft;
+            if (!reader.readVarint(xLeft) || !reader.readVarint(oLeft)) return false;
+            if (state) state->timeLeft = {chrono::milliseconds(xLeft), chrono::milliseconds(oLeft)};
+            return true;
+        }
+        case RecordTag::KEYFRAME: {
+            uint64_t moveCount, timeMs, xLeft, oLeft, stoneCount;
+            int64_t lastX, lastY, bonusX, bonusY;
+            uint8_t lastPlayer, lastEvent;
+            if (!reader.readVarint(moveCount) || !reader.readSigned(lastX) || !reader.readSigned(lastY) ||
+                !reader.readByte(lastPlayer) || !reader.readByte(lastEvent) || !reader.readVarint(timeMs) || !reader.readSigned(bonusX) || !reader.readSigned(bonusY) ||
+                !reader.readVarint(xLeft) || !reader.readVarint(oLeft) || !reader.readVarint(stoneCount)) return false;
+
+            if (state) {
+                state->board.clear();
+                state->moveCount = moveCount;
+                state->lastMove = Position((int)lastX, (int)lastY);
+                state->timeMs = timeMs;
+                state->bonusScore = {(int)bonusX, (int)bonusY};
+                state->timeLeft = {chrono::milliseconds(xLeft), chrono::milliseconds(oLeft)};
+                state->lastPlayer = (Cell)lastPlayer;
+                state->lastEvent = (RandomEvent)lastEvent;
+            }
+
+            Position stone(0, 0);
+            for (uint64_t i = 0; i < stoneCount; i++) {
+                int64_t dx, dy;
+                uint8_t cell;
+                if (!reader.readSigned(dx) || !reader.readSigned(dy) || !reader.readByte(cell)) return false;
+                stone = Position(stone.x + (int)dx, stone.y + (int)dy);
+                if (state) state->board.set(stone, (Cell)cell);
+            }
+            return true;
+        }
+        case RecordTag::END: {
+            uint8_t winner, byScore;
+            if (!reader.readByte(winner) || !reader.readByte(byScore)) return false;
+            if (state) {
+                state->finished = true;
+                state->winner = (Cell)winner;
+                state->endedByScore = byScore != 0;
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool GameRecordReader::seek(size_t moveIndex, ReplayState &state) const {
+    if (!isOpen()) return false;
+    moveIndex = min(moveIndex, totalMoves);
+    state = ReplayState();
+    state.timeLeft = {settings.timeLimit, settings.timeLimit};
+
+    BinaryReader reader(file.data(), recordsEnd);
+    reader.seek(firstRecordOffset);
+
+    // Последний ключевой кадр не позже нужного хода
+    auto it = upper_bound(keyframes.begin(), keyframes.end(), (uint64_t)moveIndex,
+        [](uint64_t value, const Keyframe &keyframe) { return value < keyframe.moveCount; });
+    RecordTag tag;
+    if (it != keyframes.begin()) {
+        reader.seek((--it)->offset);
+        if (!applyRecord(reader, &state, tag) || tag != RecordTag::KEYFRAME) return false;
+    }
+
+    // Записи события и часов относятся к ходу перед ними, поэтому остановка - на следующем MOVE
+    while (!reader.atEnd()) {
+        const uint8_t next = file.data()[reader.offset()];
+        if (next == (uint8_t)RecordTag::MOVE && state.moveCount == moveIndex) break;
+        if (next == (uint8_t)RecordTag::KEYFRAME) {
+            if (!applyRecord(reader, nullptr, tag)) break;
+            continue;
+        }
+        if (!applyRecord(reader, &state, tag)) break;
+    }
+    return true;
+}
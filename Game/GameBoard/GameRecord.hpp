@@ -0,0 +1,126 @@
+#pragma once
+
+#include "GameBoard.hpp"
+#include "Core/BinaryIO.hpp"
+#include "Core/MappedFile.hpp"
+#include "../GameStates.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Двоичная запись партии. После заголовка идут записи с однобайтовым тегом:
+//   MOVE     - игрок, zigzag-varint смещение от прошлого хода, varint мс от прошлого хода
+//   EVENT    - случайное событие и игрок, к которому оно применено
+//   CLOCK    - остаток часов обоих игроков после хода (режим TIMED)
+//   KEYFRAME - полное поле после каждого keyframeInterval-го хода
+//   END      - итог партии
+//   INDEX    - оглавление ключевых кадров, дописывается при закрытии; за ним смещение и метка
+// Файл только дописывается; без INDEX (партия прервана) оглавление строится проходом по файлу.
+enum class RecordTag : uint8_t { MOVE = 1, EVENT = 2, CLOCK = 3, KEYFRAME = 4, END = 5, INDEX = 6 };
+
+struct RecordSettings {
+    GameMode mode = GameMode::CLASSIC;
+    int winningLength = 5;
+    int targetScore = 100;
+    chrono::milliseconds timeLimit = chrono::milliseconds(0);
+    OpponentType opponent = OpponentType::PLAYER_VS_PLAYER;
+    BotDifficulty difficulty = BotDifficulty::MEDIUM;
+    uint32_t keyframeInterval = 64;
+};
+
+// Состояние партии после заданного числа ходов
+struct ReplayState {
+    GameBoard board;
+    size_t moveCount = 0;
+    Position lastMove;
+    Cell lastPlayer = Cell::EMPTY;
+    RandomEvent lastEvent = RandomEvent::NOTHING;
+    uint64_t timeMs = 0;
+    pair<int, int> bonusScore = {0, 0};
+    pair<chrono::milliseconds, chrono::milliseconds> timeLeft;
+    bool finished = false;
+    Cell winner = Cell::EMPTY;
+    bool endedByScore = false;
+};
+
+class GameRecordWriter {
+    private:
+        FILE *file;
+        RecordSettings settings;
+        BinaryWriter pending;
+        uint64_t fileOffset;
+        chrono::steady_clock::time_point startTime;
+
+        size_t moveCount;
+        Position lastMove;
+        Cell lastPlayer;
+        RandomEvent lastEvent;
+        uint64_t lastMoveMs;
+        bool finished;
+
+        // Оглавление: номер хода и смещение ключевого кадра
+        vector<pair<uint64_t, uint64_t>> keyframes;
+
+        void writeKeyframe(const GameBoard &board, pair<int, int> bonusScore,
+                           pair<chrono::milliseconds, chrono::milliseconds> timeLeft);
+        bool flush();
+
+    public:
+        GameRecordWriter();
+        ~GameRecordWriter();
+        GameRecordWriter(const GameRecordWriter &) = delete;
+        GameRecordWriter& operator=(const GameRecordWriter &) = delete;
+
+        bool open(const string &path, const RecordSettings &settings);
+        bool isOpen() const { return file != nullptr; }
+
+        void recordMove(const Position &move, Cell player);
+        void recordEvent(RandomEvent event, Cell player);
+        // Завершает ход: часы, при необходимости ключевой кадр, сброс на диск
+        void commitMove(const GameBoard &board, pair<int, int> bonusScore,
+                        pair<chrono::milliseconds, chrono::milliseconds> timeLeft);
+        void recordEnd(Cell winner, bool endedByScore);
+        // Дописывает оглавление и закрывает файл
+        void close();
+};
+
+class GameRecordReader {
+    private:
+        struct Keyframe {
+            uint64_t moveCount;
+            uint64_t offset;
+        };
+
+        MappedFile file;
+        RecordSettings settings;
+        size_t firstRecordOffset;
+        size_t recordsEnd;
+        vector<Keyframe> keyframes;
+        size_t totalMoves;
+
+        bool readHeader(BinaryReader &reader);
+        bool loadIndex();
+        void scanRecords();
+        // Применяет одну запись к state (nullptr - только разбор); false - конец данных или поврежденная запись
+        bool applyRecord(BinaryReader &reader, ReplayState *state, RecordTag &tag) const;
+
+    public:
+        static constexpr char MAGIC[8] = {'T', 'T', 'T', 'R', 'E', 'C', '0', '1'};
+        static constexpr char INDEX_MAGIC[8] = {'T', 'T', 'T', 'R', 'I', 'D', 'X', '1'};
+
+        GameRecordReader();
+
+        bool open(const string &path);
+        void close();
+        bool isOpen() const { return file.isOpen(); }
+
+        const RecordSettings& getSettings() const { return settings; }
+        size_t getMoveCount() const { return totalMoves; }
+
+        // Ближайший ключевой кадр плюс не более keyframeInterval ходов
+        bool seek(size_t moveIndex, ReplayState &state) const;
+};
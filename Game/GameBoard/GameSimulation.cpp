@@ -0,0 +1,194 @@
+#include "GameSimulation.hpp"
+#include <ctime>
+#include <filesystem>
+
+
+GameSimulation::GameSimulation(chrono::milliseconds tickLength):
+    tickLength(tickLength), gameId(0), paused(false), lastCommand(0), running(false),
+    publishedBoardGameId(0), publishedBoardRevision(0), publishedGameId(0), publishedRevision(UINT64_MAX), publishedGameWon(false),
+    moveAnswerPending(false) {}
+
+GameSimulation::~GameSimulation() {
+    stop();
+}
+
+void GameSimulation::start() {
+    if (running.exchange(true)) return;
+    worker = thread(&GameSimulation::run, this);
+}
+
+void GameSimulation::stop() {
+    running = false;
+    if (worker.joinable()) worker.join();
+}
+
+bool GameSimulation::post(const SimulationCommand &command) {
+    return commands.push(command);
+}
+
+shared_ptr<const GameSnapshot> GameSimulation::takeLatestSnapshot() {
+    shared_ptr<const GameSnapshot> latest, next;
+    while (snapshots.pop(next)) latest = move(next);
+    return latest;
+}
+
+void GameSimulation::run() {
+    auto nextTick = chrono::steady_clock::now();
+    
+    while (running.load()) {
+        {
+            TraceScope trace("simulationTick", "simulation");
+            
+            // Ход бота откладывается на следующий шаг, чтобы сначала ушел снимок с ходом игрока
+            bool changed = false;
+            SimulationCommand command;
+            while (commands.pop(command)) changed |= execute(command);
+            
+            if (!changed) step();
+            publish();
+        }
+        
+        // После долгого хода бота не догоняем пропущенные шаги
+        nextTick += tickLength;
+        auto now = chrono::steady_clock::now();
+        if (nextTick < now) nextTick = now;
+        this_thread::sleep_until(nextTick);
+    }
+}
+
+bool GameSimulation::execute(const SimulationCommand &command) {
+    const GameSettings &settings = command.settings;
+    lastCommand = command.sequence;
+    
+    switch (command.type) {
+        case SimulationCommand::Type::START:
+            game = make_unique<InfiniteTicTacToe>(settings.mode, settings.winningLength, settings.targetScore,
+                                                  settings.timeLimit, settings.opponent, settings.difficulty);
+            gameId = command.gameId;
+            paused = false;
+            startRecording();
+            if (!autosaveDirectory.empty()) game->startJournal(autosaveDirectory);
+            return true;
+        case SimulationCommand::Type::RESET:
+            if (!game) return false;
+            game->reset(settings.mode, settings.winningLength, settings.targetScore, settings.timeLimit);
+            gameId = command.gameId;
+            paused = false;
+            startRecording();
+            if (!autosaveDirectory.empty()) game->startJournal(autosaveDirectory);
+            return true;
+        case SimulationCommand::Type::RESTORE:
+            // Восстановленная партия ждет на паузе, пока игрок не вернется к ней
+            game = make_unique<InfiniteTicTacToe>(settings.mode, settings.winningLength, settings.targetScore,
+                                                  settings.timeLimit, settings.opponent, settings.difficulty);
+            gameId = command.gameId;
+            paused = true;
+            // Запись партии с середины не ведется: в ней не было бы первых ходов
+            if (autosaveDirectory.empty() || !game->resumeJournal(autosaveDirectory)) {
+                game = make_unique<InfiniteTicTacToe>(settings.mode, settings.winningLength, settings.targetScore,
+                                                      settings.timeLimit, settings.opponent, settings.difficulty);
+                startRecording();
+                if (!autosaveDirectory.empty()) game->startJournal(autosaveDirectory);
+            }
+            return true;
+        case SimulationCommand::Type::MOVE:
+            moveAnswerPending = true;
+            if (!game || command.gameId != gameId || game->isGameWon() || game->isBotCurrentTurn()) return false;
+            game->makeMove(command.move);
+            return true;
+        case SimulationCommand::Type::UNDO:
+            moveAnswerPending = true;
+            if (!game || command.gameId != gameId || !game->undo()) return false;
+            while (game->isBotCurrentTurn() && game->canUndo()) game->undo();
+            return true;
+        case SimulationCommand::Type::REDO:
+            moveAnswerPending = true;
+            if (!game || command.gameId != gameId || !game->redo()) return false;
+            while (game->isBotCurrentTurn() && game->canRedo()) game->redo();
+            return true;
+        case SimulationCommand::Type::PAUSE:
+            paused = true;
+            return false;
+        case SimulationCommand::Type::RESUME:
+            paused = false;
+            return false;
+        case SimulationCommand::Type::CLOSE:
+            // Брошенную партию не предлагаем продолжить
+            if (game) game->stopJournal(true);
+            game.reset();
+            gameId = command.gameId;
+            return true;
+    }
+    return false;
+}
+
+// Файл вида records/20260101-120000-3.tttr; ошибка записи не мешает игре
+void GameSimulation::startRecording() {
+    if (recordDirectory.empty() || !game) return;
+    
+    error_code error;
+    filesystem::create_directories(recordDirectory, error);
+    
+    char stamp[32];
+    time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    game->startRecording(recordDirectory + "/" + stamp + "-" + to_string(gameId) + ".tttr");
+}
+
+void GameSimulation::step() {
+    if (!game || paused || game->isGameWon()) return;
+    
+    if (game->getGameMode() == GameMode::TIMED && game->isTimeUp()) {
+        game->stopJournal(true);
+        return;
+    }
+    if (game->isBotCurrentTurn()) game->makeBotMove();
+}
+
+void GameSimulation::publish() {
+    if (!game) return;
+    
+    // Пока идут часы TIMED, снимок нужен на каждом шаге; иначе только после изменений
+    bool clockRunning = game->getGameMode() == GameMode::TIMED && !game->isGameWon() && !paused;
+    bool changed = gameId != publishedGameId || game->getRevision() != publishedRevision ||
+                   game->isGameWon() != publishedGameWon || moveAnswerPending;
+    if (!changed && !clockRunning) return;
+    
+    // Поле копируется только после изменения, иначе снимки делят одну копию
+    if (!publishedBoard || gameId != publishedBoardGameId || game->getRevision() != publishedBoardRevision) {
+        publishedBoard = make_shared<const GameBoard>(game->getBoard());
+        publishedBoardGameId = gameId;
+        publishedBoardRevision = game->getRevision();
+    }
+    
+    auto snapshot = make_shared<GameSnapshot>();
+    snapshot->gameId = gameId;
+    snapshot->revision = game->getRevision();
+    snapshot->lastCommand = lastCommand;
+    snapshot->board = publishedBoard;
+    snapshot->winLine = game->getWinLine();
+    snapshot->mode = game->getGameMode();
+    snapshot->opponentType = game->getOpponentType();
+    snapshot->botDifficulty = game->getBotDifficulty();
+    snapshot->winningLength = game->getWinningLength();
+    snapshot->targetScore = game->getTargetScore();
+    snapshot->currentPlayer = game->getCurrentPlayer();
+    snapshot->winner = game->getWinner();
+    snapshot->gameWon = game->isGameWon();
+    snapshot->gameEndedByScore = game->isGameEndedByScore();
+    snapshot->botTurn = game->isBotCurrentTurn();
+    snapshot->nextEvent = game->getNextEvent();
+    snapshot->score = game->getScore();
+    snapshot->baseScore = game->getBaseScore();
+    snapshot->bonusScore = game->getBonusScore();
+    snapshot->timeLeft = game->getTimeLeft();
+    if (game->getBotStats()) snapshot->botStats = *game->getBotStats();
+    
+    // Очередь полна: интерфейс отстает, снимок уйдет на следующем шаге
+    if (!snapshots.push(move(snapshot))) return;
+    
+    publishedGameId = gameId;
+    publishedRevision = game->getRevision();
+    publishedGameWon = game->isGameWon();
+    moveAnswerPending = false;
+}
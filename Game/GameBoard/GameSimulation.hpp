@@ -0,0 +1,87 @@
+#pragma once
+
+#include "InfiniteTicTacToe.hpp"
+#include "GameSnapshot.hpp"
+#include "Core/SpscQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+
+struct GameSettings {
+    GameMode mode = GameMode::CLASSIC;
+    int winningLength = 5;
+    int targetScore = 100;
+    chrono::seconds timeLimit = chrono::seconds(10);
+    OpponentType opponent = OpponentType::PLAYER_VS_PLAYER;
+    BotDifficulty difficulty = BotDifficulty::MEDIUM;
+};
+
+// Команда от потока интерфейса; gameId отсекает команды к уже закрытой партии
+struct SimulationCommand {
+    // RESTORE - продолжить партию из автосохранения; если не вышло, начать новую с settings
+    // UNDO/REDO против бота откатывают и его ответ, чтобы очередь вернулась к игроку
+    enum class Type { START, RESET, MOVE, PAUSE, RESUME, CLOSE, RESTORE, UNDO, REDO };
+    
+    Type type = Type::MOVE;
+    uint64_t gameId = 0;
+    uint64_t sequence = 0;
+    Position move;
+    GameSettings settings;
+};
+
+// Поток симуляции: владеет партией, обновляет ее с фиксированным шагом
+// и публикует снимки. Интерфейс общается с ним только через очереди.
+class GameSimulation {
+    private:
+        chrono::milliseconds tickLength;
+        unique_ptr<InfiniteTicTacToe> game;
+        uint64_t gameId;
+        bool paused;
+        uint64_t lastCommand;
+        
+        thread worker;
+        atomic<bool> running;
+        SpscQueue<SimulationCommand, 64> commands;
+        SpscQueue<shared_ptr<const GameSnapshot>, 8> snapshots;
+        
+        // Последний опубликованный снимок
+        shared_ptr<const GameBoard> publishedBoard;
+        uint64_t publishedBoardGameId;
+        uint64_t publishedBoardRevision;
+        uint64_t publishedGameId;
+        uint64_t publishedRevision;
+        bool publishedGameWon;
+        // Ответ на ход игрока нужен, даже если ход отклонен: интерфейс ждет снимок
+        bool moveAnswerPending;
+        // Каталог записей партий; пустой - запись выключена
+        string recordDirectory;
+        // Каталог автосохранения; пустой - выключено
+        string autosaveDirectory;
+        
+        void run();
+        void startRecording();
+        bool execute(const SimulationCommand &command);
+        void step();
+        void publish();
+
+    public:
+        explicit GameSimulation(chrono::milliseconds tickLength = chrono::milliseconds(10));
+        ~GameSimulation();
+        GameSimulation(const GameSimulation &) = delete;
+        GameSimulation& operator=(const GameSimulation &) = delete;
+        
+        // Задается до start()
+        void setRecordDirectory(const string &directory) { recordDirectory = directory; }
+        void setAutosaveDirectory(const string &directory) { autosaveDirectory = directory; }
+        
+        void start();
+        void stop();
+        
+        // Вызываются только из потока интерфейса
+        bool post(const SimulationCommand &command);
+        shared_ptr<const GameSnapshot> takeLatestSnapshot();
+};
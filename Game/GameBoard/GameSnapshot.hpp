@@ -0,0 +1,42 @@
+#pragma once
+
+#include "GameBoard.hpp"
+#include "AI/SearchStats.hpp"
+#include "../GameStates.hpp"
+#include <chrono>
+#include <memory>
+#include <optional>
+
+using namespace std;
+
+
+// Неизменяемый снимок партии для отрисовки из другого потока.
+// Поле разделяется между снимками, пока не изменится ревизия.
+struct GameSnapshot {
+    uint64_t gameId = 0;
+    uint64_t revision = 0;
+    // Порядковый номер последней выполненной команды интерфейса
+    uint64_t lastCommand = 0;
+    shared_ptr<const GameBoard> board;
+    vector<Position> winLine;
+    
+    GameMode mode = GameMode::CLASSIC;
+    OpponentType opponentType = OpponentType::PLAYER_VS_PLAYER;
+    BotDifficulty botDifficulty = BotDifficulty::MEDIUM;
+    int winningLength = 5;
+    int targetScore = 0;
+    
+    Cell currentPlayer = Cell::X;
+    Cell winner = Cell::EMPTY;
+    bool gameWon = false;
+    bool gameEndedByScore = false;
+    bool botTurn = false;
+    RandomEvent nextEvent = RandomEvent::NOTHING;
+    
+    pair<int, int> score;
+    pair<int, int> baseScore;
+    pair<int, int> bonusScore;
+    pair<chrono::milliseconds, chrono::milliseconds> timeLeft;
+    
+    optional<SearchStats> botStats;
+};
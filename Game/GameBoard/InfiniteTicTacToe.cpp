@@ -1,16 +1,6 @@
 #include "InfiniteTicTacToe.hpp"
 
 
-bool InfiniteTicTacToe::checkLine(const Position &start, int dx, int dy, int length, Cell player) const {
-    for (int i = 0; i < length; i++) {
-        Position pos(start.x + dx * i, start.y + dy * i);
-        if (board.get(pos) != player) {
-            return false;
-        }
-    }
-    return true;
-}
-
 vector<Position> InfiniteTicTacToe::getWinningLine(const Position &start, int dx, int dy, int length, Cell player) const {
     vector<Position> line;
     for (int i = 0; i < length; i++) {
@@ -33,20 +23,23 @@ bool InfiniteTicTacToe::checkWin(const Position &lastMove) {
         int dx = directions[dirIdx].first;
         int dy = directions[dirIdx].second;
         
-        for (int start = -winningLength + 1; start <= 0; start++) {
-            Position startPos(lastMove.x + dx * start, lastMove.y + dy * start);
-            if (checkLine(startPos, dx, dy, winningLength, player)) {
-                winLine = getWinningLine(startPos, dx, dy, winningLength, player);
-                lastCheckedPos = lastMove;
-                
-                if (mode == GameMode::CLASSIC || mode == GameMode::TIMED) {
-                    gameWon = true;
-                    winner = player;
-                    gameEndedByScore = false;
-                }
-                return true;
-            }
+        // Серия через ход: before своих клеток перед ним и after после, не дальше L - 1 в каждую сторону.
+        // Первое по порядку окно из L своих начинается за before клеток до хода
+        int before = 0, after = 0;
+        while (before < winningLength - 1 && board.get(Position(lastMove.x - dx * (before + 1), lastMove.y - dy * (before + 1))) == player) before++;
+        while (after < winningLength - 1 && board.get(Position(lastMove.x + dx * (after + 1), lastMove.y + dy * (after + 1))) == player) after++;
+        if (before + after + 1 < winningLength) continue;
+        
+        Position startPos(lastMove.x - dx * before, lastMove.y - dy * before);
+        winLine = getWinningLine(startPos, dx, dy, winningLength, player);
+        lastCheckedPos = lastMove;
+        
+        if (mode == GameMode::CLASSIC || mode == GameMode::TIMED) {
+            gameWon = true;
+            winner = player;
+            gameEndedByScore = false;
         }
+        return true;
     }
     
     lastCheckedPos = lastMove;
@@ -56,26 +49,42 @@ bool InfiniteTicTacToe::checkWin(const Position &lastMove) {
 void InfiniteTicTacToe::expandBoardIfNeeded(const Position &newPos) {
     if (board.shouldExpand(newPos)) {
         board.expandField();
-        graphicsDirty = true;
+        revision++;
     }
 }
 
 RandomEvent InfiniteTicTacToe::generateRandomEvent() {
     if (mode != GameMode::RANDOM_EVENTS) return RandomEvent::NOTHING;
     
+    // Порядок отрезков прежний: с весами по умолчанию тот же бросок дает то же событие
+    static constexpr RandomEvent order[] = {
+        RandomEvent::NOTHING, RandomEvent::SCORE_PLUS_10, RandomEvent::SCORE_MINUS_10, RandomEvent::SCORE_PLUS_25,
+        RandomEvent::SCORE_MINUS_25, RandomEvent::BONUS_MOVE, RandomEvent::CLEAR_AREA, RandomEvent::SWAP_PLAYERS
+    };
     int roll = eventChance(rng);
+    for (RandomEvent event : order) {
+        roll -= eventWeights[(int)event];
+        if (roll < 0) return event;
+    }
+    return RandomEvent::NOTHING;
+}
+
+bool InfiniteTicTacToe::setEventWeights(const array<int, 8> &weights) {
+    int total = 0;
+    for (int weight : weights) {
+        if (weight < 0) return false;
+        total += weight;
+    }
+    if (total <= 0) return false;
     
-    if (roll < 35) return RandomEvent::NOTHING;
-    else if (roll < 50) return RandomEvent::SCORE_PLUS_10;
-    else if (roll < 65) return RandomEvent::SCORE_MINUS_10;
-    else if (roll < 70) return RandomEvent::SCORE_PLUS_25;
-    else if (roll < 75) return RandomEvent::SCORE_MINUS_25;
-    else if (roll < 90) return RandomEvent::BONUS_MOVE;
-    else if (roll < 95) return RandomEvent::CLEAR_AREA;
-    else return RandomEvent::SWAP_PLAYERS;
+    eventWeights = weights;
+    eventChance = uniform_int_distribution<int>(0, total - 1);
+    return true;
 }
 
 void InfiniteTicTacToe::handleRandomEvent(RandomEvent event) {
+    Tracer::instance().instant("randomEvent", "game", "event", static_cast<int>(event));
+    if (recorder) recorder->recordEvent(event, currentPlayer);
     switch (event) {
         case RandomEvent::NOTHING:
             updateTotalScores();
@@ -103,8 +112,9 @@ void InfiniteTicTacToe::handleRandomEvent(RandomEvent event) {
         case RandomEvent::BONUS_MOVE:
             return;
         case RandomEvent::SWAP_PLAYERS:
+            if (activeTurn) activeTurn->swapped = true;
             swapAllCells();
-            graphicsDirty = true;
+            revision++;
             calculateBaseScores();
             updateTotalScores();
             break;
@@ -115,10 +125,12 @@ void InfiniteTicTacToe::handleRandomEvent(RandomEvent event) {
                 for (int dx = -1; dx <= 1; dx++) {
                     for (int dy = -1; dy <= 1; dy++) {
                         Position pos(last.x + dx, last.y + dy);
+                        Cell cell = board.get(pos);
+                        if (activeTurn && cell != Cell::EMPTY) activeTurn->erased.emplace_back(pos, cell);
                         board.erase(pos);
                     }
                 }
-                graphicsDirty = true;
+                revision++;
                 
                 calculateBaseScores();
                 updateTotalScores();
@@ -158,27 +170,9 @@ void InfiniteTicTacToe::updateTotalScores() {
 }
 
 void InfiniteTicTacToe::calculateBaseScores() {
-    playerXBaseScore = 0;
-    playerOBaseScore = 0;
-    
-    visited.clear();
-    
-    vector<Position> xPositions = board.getOccupiedPositions(Cell::X);
-    vector<Position> oPositions = board.getOccupiedPositions(Cell::O);
-    
-    for (const auto &pos : xPositions) {
-        if (visited.find(pos.toPair()) == visited.end()) {
-            playerXBaseScore += findMaxLineScore(pos, Cell::X);
-        }
-    }
-    
-    visited.clear();
-    
-    for (const auto &pos : oPositions) {
-        if (visited.find(pos.toPair()) == visited.end()) {
-            playerOBaseScore += findMaxLineScore(pos, Cell::O);
-        }
-    }
+    TraceScope trace("calculateBaseScores", "scoring");
+    playerXBaseScore = calculateLineScore(board, Cell::X);
+    playerOBaseScore = calculateLineScore(board, Cell::O);
     
     if (mode == GameMode::SCORING) {
         playerXScore = playerXBaseScore;
@@ -203,177 +197,6 @@ void InfiniteTicTacToe::calculateBoardScores() {
     }
 }
 
-int InfiniteTicTacToe::findMaxLineScore(const Position &startPos, Cell player) {
-    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
-    
-    int maxLineLength = 0;
-    vector<Position> maxLinePositions;
-    
-    for (const auto &dir : directions) {
-        int dx = dir.first;
-        int dy = dir.second;
-        
-        int forwardLength = countInDirection(startPos, dx, dy, player);
-        int backwardLength = countInDirection(startPos, -dx, -dy, player);
-        int totalLength = forwardLength + backwardLength - 1;
-        
-        if (totalLength > maxLineLength) {
-            maxLineLength = totalLength;
-            maxLinePositions.clear();
-            
-            for (int i = -(backwardLength - 1); i < forwardLength; i++) {
-                Position pos(startPos.x + dx * i, startPos.y + dy * i);
-                maxLinePositions.push_back(pos);
-            }
-        }
-    }
-    
-    if (maxLineLength > 0) {
-        for (const auto &pos : maxLinePositions) {
-            visited[pos.toPair()] = true;
-        }
-        
-        return maxLineLength * maxLineLength;
-    }
-    
-    return 0;
-}
-
-int InfiniteTicTacToe::countInDirection(const Position &start, int dx, int dy, Cell player) const {
-    int count = 0;
-    Position current = start;
-    
-    while (board.get(current) == player) {
-        count++;
-        current = Position(current.x + dx, current.y + dy);
-    }
-    
-    return count;
-}
-
-void InfiniteTicTacToe::updateGraphics() const {
-    if (!graphicsDirty && !winLine.empty()) return;
-    
-    gridVertices.clear();
-    xVertices.clear();
-    oVertices.clear();
-    highlightVertices.clear();
-    
-    int minX, maxX, minY, maxY;
-    board.getBounds(minX, maxX, minY, maxY);
-    
-    int visibleMargin = 1;
-    int visibleMinX = minX - visibleMargin;
-    int visibleMaxX = maxX + visibleMargin;
-    int visibleMinY = minY - visibleMargin;
-    int visibleMaxY = maxY + visibleMargin;
-    
-    const float halfCell = cellSize * 0.5f;
-    const float offset = cellSize * 0.35f;
-    
-    Color gridColor(100, 100, 100, 100);
-    
-    for (int x = visibleMinX; x <= visibleMaxX + 1; x++) {
-        float pixelX = center.x + x * cellSize;
-        Vertex v1, v2;
-        v1.position = Vector2f(pixelX, center.y + visibleMinY * cellSize);
-        v1.color = gridColor;
-        v2.position = Vector2f(pixelX, center.y + (visibleMaxY + 1) * cellSize);
-        v2.color = gridColor;
-        gridVertices.append(v1);
-        gridVertices.append(v2);
-    }
-    
-    for (int y = visibleMinY; y <= visibleMaxY + 1; y++) {
-        float pixelY = center.y + y * cellSize;
-        Vertex v1, v2;
-        v1.position = Vector2f(center.x + visibleMinX * cellSize, pixelY);
-        v1.color = gridColor;
-        v2.position = Vector2f(center.x + (visibleMaxX + 1) * cellSize, pixelY);
-        v2.color = gridColor;
-        gridVertices.append(v1);
-        gridVertices.append(v2);
-    }
-    
-    for (int x = visibleMinX; x <= visibleMaxX; x++) {
-        for (int y = visibleMinY; y <= visibleMaxY; y++) {
-            Position pos(x, y);
-            Cell cell = board.get(pos);
-            
-            if (cell == Cell::EMPTY) continue;
-            
-            Vector2f pixelPos = pos.toPixel(cellSize, center);
-            
-            if (cell == Cell::X) {
-                Color xColor = Color::Red;
-                
-                Vertex v1, v2;
-                v1.position = Vector2f(pixelPos.x - offset, pixelPos.y - offset);
-                v1.color = xColor;
-                v2.position = Vector2f(pixelPos.x + offset, pixelPos.y + offset);
-                v2.color = xColor;
-                xVertices.append(v1);
-                xVertices.append(v2);
-                
-                Vertex v3, v4;
-                v3.position = Vector2f(pixelPos.x + offset, pixelPos.y - offset);
-                v3.color = xColor;
-                v4.position = Vector2f(pixelPos.x - offset, pixelPos.y + offset);
-                v4.color = xColor;
-                xVertices.append(v3);
-                xVertices.append(v4);
-            } 
-            else if (cell == Cell::O) {
-                Color oColor = Color::Blue;
-                const int segments = 24;
-                float radius = cellSize * 0.25f;
-                
-                for (int i = 0; i < segments; i++) {
-                    float angle1 = 2 * 3.14159f * i / segments;
-                    float angle2 = 2 * 3.14159f * (i + 1) / segments;
-                    
-                    Vertex v1, v2;
-                    v1.position = Vector2f(
-                        pixelPos.x + cos(angle1) * radius, 
-                        pixelPos.y + sin(angle1) * radius
-                    );
-                    v1.color = oColor;
-                    v2.position = Vector2f(
-                        pixelPos.x + cos(angle2) * radius, 
-                        pixelPos.y + sin(angle2) * radius
-                    );
-                    v2.color = oColor;
-                    oVertices.append(v1);
-                    oVertices.append(v2);
-                }
-            }
-        }
-    }
-    
-    if (!winLine.empty() && (mode == GameMode::CLASSIC || mode == GameMode::TIMED)) {
-        Color highlightColor(255, 255, 0, 100);
-        for (const auto &pos : winLine) {
-            Vector2f pixelPos = pos.toPixel(cellSize, center);
-            Vertex v1, v2, v3, v4;
-            v1.position = Vector2f(pixelPos.x - halfCell + 2, pixelPos.y - halfCell + 2);
-            v1.color = highlightColor;
-            v2.position = Vector2f(pixelPos.x + halfCell - 2, pixelPos.y - halfCell + 2);
-            v2.color = highlightColor;
-            v3.position = Vector2f(pixelPos.x - halfCell + 2, pixelPos.y + halfCell - 2);
-            v3.color = highlightColor;
-            v4.position = Vector2f(pixelPos.x + halfCell - 2, pixelPos.y + halfCell - 2);
-            v4.color = highlightColor;
-            
-            highlightVertices.append(v1);
-            highlightVertices.append(v2);
-            highlightVertices.append(v3);
-            highlightVertices.append(v4);
-        }
-    }
-    
-    graphicsDirty = false;
-}
-
 void InfiniteTicTacToe::stopTimer() const{
 
     if (mode != GameMode::TIMED || !isTimerRunning) return;
@@ -408,13 +231,11 @@ void InfiniteTicTacToe::updateTimers() const {
 }
 
 InfiniteTicTacToe::InfiniteTicTacToe(GameMode mode, int winningLength, int targetScore, chrono::seconds timeLimit,
-    Vector2f windowCenter, OpponentType oppType, BotDifficulty botDiff):
+    OpponentType oppType, BotDifficulty botDiff):
         currentPlayer(Cell::X), 
         mode(mode), 
         winningLength(winningLength), 
         targetScore(targetScore), 
-        cellSize(40.0f), 
-        center(windowCenter), 
         opponentType(oppType),
         botDifficulty(botDiff), 
         isBotTurn(false), 
@@ -430,23 +251,22 @@ InfiniteTicTacToe::InfiniteTicTacToe(GameMode mode, int winningLength, int targe
         nextEvent(RandomEvent::NOTHING),
         rng(static_cast<unsigned int>(chrono::steady_clock::now().time_since_epoch().count())),
         eventChance(0, 100), 
-        graphicsDirty(true), 
-        gridVertices(PrimitiveType::Lines),
-        xVertices(PrimitiveType::Lines), 
-        oVertices(PrimitiveType::Lines), 
-        highlightVertices(PrimitiveType::TriangleStrip),
+        eventWeights(DEFAULT_EVENT_WEIGHTS),
         initialTimeLimit(chrono::duration_cast<chrono::milliseconds>(timeLimit)),
         playerXTimeLeft(chrono::duration_cast<chrono::milliseconds>(timeLimit)),
         playerOTimeLeft(chrono::duration_cast<chrono::milliseconds>(timeLimit)),
         isTimerRunning(false),
-        playerWithTimerRunning(Cell::EMPTY) {
+        playerWithTimerRunning(Cell::EMPTY),
+        revision(0),
+        activeTurn(nullptr),
+        journalReplayCost(0) {
 
     lastMoveTime = chrono::steady_clock::now();
     checkDirections.fill(true);
 
     if (mode == GameMode::TIMED) startTimerForPlayer(currentPlayer);
     if (opponentType == OpponentType::PLAYER_VS_BOT) {
-        bot = make_unique<TicTacToeBot>(botDiff, currentPlayer);
+        bot = createBot(botDiff, currentPlayer, mode);
         isBotTurn = true;
     }
 }
@@ -463,21 +283,49 @@ void InfiniteTicTacToe::startTimerForPlayer(Cell player) const{
     playerWithTimerRunning = player;
 }
 
-bool InfiniteTicTacToe::handleClick(const Vector2f &mousePos) {
-    if (gameWon) return false;
-    if (opponentType == OpponentType::PLAYER_VS_BOT && isBotTurn) return false;
+InfiniteTicTacToe::~InfiniteTicTacToe() {
+    stopRecording();
+    stopJournal(false);
+}
+
+bool InfiniteTicTacToe::makeMove(const Position &pos) {
+    TraceScope trace("makeMove", "game");
+    size_t movesBefore = moveHistory.size();
+    auto moveStart = chrono::steady_clock::now();
     
-    int gridX = static_cast<int>(floor((mousePos.x - center.x) / cellSize));
-    int gridY = static_cast<int>(floor((mousePos.y - center.y) / cellSize));
+    TurnDelta turn;
+    captureTurnState(turn.before);
+    activeTurn = &turn;
+    bool ended = applyMove(pos);
+    activeTurn = nullptr;
     
-    Position pos(gridX, gridY);
+    if (moveHistory.size() != movesBefore) {
+        turn.move = pos;
+        turn.player = turn.before.currentPlayer;
+        captureTurnState(turn.after);
+        undoStack.push_back(move(turn));
+        redoStack.clear();
+    }
     
+    // Ход, событие и часы уходят на диск одной порцией
+    if (recorder && moveHistory.size() != movesBefore) {
+        recorder->commitMove(board, getBonusScore(), getTimeLeft());
+        if (gameWon) recorder->recordEnd(winner, gameEndedByScore);
+    }
+    if (journal && moveHistory.size() != movesBefore) journalMove(chrono::steady_clock::now() - moveStart);
+    return ended;
+}
+
+bool InfiniteTicTacToe::applyMove(const Position &pos) {
+    if (gameWon) return false;
     if (board.get(pos) != Cell::EMPTY) return false;
 
     board.set(pos, currentPlayer);
     moveHistory.push_back(pos);
+    if (recorder) recorder->recordMove(pos, currentPlayer);
     lastMoveTime = chrono::steady_clock::now();
-    bool wonByLine = checkWin(pos);
+    revision++;
+    checkWin(pos);
     
     expandBoardIfNeeded(pos);
     if (mode == GameMode::SCORING || mode == GameMode::RANDOM_EVENTS) calculateBoardScores();
@@ -485,20 +333,18 @@ bool InfiniteTicTacToe::handleClick(const Vector2f &mousePos) {
         if (mode == GameMode::TIMED) {
             stopTimer();
         }
-        graphicsDirty = true;
         return true;
     }
     
     if (mode == GameMode::RANDOM_EVENTS  && nextEvent != RandomEvent::NOTHING) {
         RandomEvent event = nextEvent;
+        if (activeTurn) activeTurn->event = event;
         handleRandomEvent(event);
 
         nextEvent = RandomEvent::NOTHING;
 
-        if (event == RandomEvent::BONUS_MOVE) {
-            graphicsDirty = true;
-            return false;
-        }
+        if (event == RandomEvent::BONUS_MOVE) return false;
+        if (gameWon) return true;
     }
     
     if (mode == GameMode::TIMED) {
@@ -515,244 +361,388 @@ bool InfiniteTicTacToe::handleClick(const Vector2f &mousePos) {
         startTimerForPlayer(currentPlayer);
     }
 
-    if (opponentType == OpponentType::PLAYER_VS_BOT) isBotTurn = true;
-    graphicsDirty = true;
+    if (opponentType == OpponentType::PLAYER_VS_BOT) isBotTurn = !isBotTurn;
     
     return false;
 }
 
-void InfiniteTicTacToe::makeBotMove() {
-    if (!bot || !isBotTurn || gameWon) return;
+void InfiniteTicTacToe::captureTurnState(TurnState &state) const {
+    updateTimers();
+    state.currentPlayer = currentPlayer;
+    state.winner = winner;
+    state.nextEvent = nextEvent;
+    state.isBotTurn = isBotTurn;
+    state.gameWon = gameWon;
+    state.gameEndedByScore = gameEndedByScore;
+    state.scores = {playerXScore, playerOScore, playerXBaseScore, playerOBaseScore, playerXBonusScore, playerOBonusScore};
+    state.timeLeftX = playerXTimeLeft;
+    state.timeLeftO = playerOTimeLeft;
+    state.rng = rng;
+    board.getBounds(state.bounds[0], state.bounds[1], state.bounds[2], state.bounds[3]);
+    state.winLine = winLine;
+    state.lastCheckedPos = lastCheckedPos;
+}
 
-    Position botMove = bot->getBestMove(board, winningLength);
+void InfiniteTicTacToe::restoreTurnState(const TurnState &state) {
+    currentPlayer = state.currentPlayer;
+    winner = state.winner;
+    nextEvent = state.nextEvent;
+    isBotTurn = state.isBotTurn;
+    gameWon = state.gameWon;
+    gameEndedByScore = state.gameEndedByScore;
+    playerXScore = state.scores[0];
+    playerOScore = state.scores[1];
+    playerXBaseScore = state.scores[2];
+    playerOBaseScore = state.scores[3];
+    playerXBonusScore = state.scores[4];
+    playerOBonusScore = state.scores[5];
+    playerXTimeLeft = state.timeLeftX;
+    playerOTimeLeft = state.timeLeftO;
+    rng = state.rng;
+    board.setBounds(state.bounds[0], state.bounds[1], state.bounds[2], state.bounds[3]);
+    winLine = state.winLine;
+    lastCheckedPos = state.lastCheckedPos;
+}
 
-    board.set(botMove, currentPlayer);
-    moveHistory.push_back(botMove);
-    lastMoveTime = chrono::steady_clock::now();
-    bool wonByLine = checkWin(botMove);
-    graphicsDirty = true;
-    expandBoardIfNeeded(botMove);
-    if (gameWon) return;
+// Изменения хода применяются в обратном порядке: событие, затем камень
+bool InfiniteTicTacToe::undo() {
+    if (undoStack.empty()) return false;
+    TraceScope trace("undo", "game");
+    
+    // Запись партии хранит только основную линию и закрывается на первой отмене
+    stopRecording();
+    
+    TurnDelta &turn = undoStack.back();
+    if (turn.swapped) swapAllCells();
+    for (const auto &[pos, cell] : turn.erased) board.set(pos, cell);
+    board.erase(turn.move);
+    moveHistory.pop_back();
+    restoreTurnState(turn.before);
+    
+    redoStack.push_back(move(turn));
+    undoStack.pop_back();
+    afterHistoryChange();
+    return true;
+}
 
-    currentPlayer = (currentPlayer == Cell::X) ? Cell::O : Cell::X;
-    isBotTurn = false;
-}
-
-void InfiniteTicTacToe::draw(RenderWindow &window) const {
-    updateGraphics();
-    
-    VertexArray axes(PrimitiveType::Lines, 4);
-    axes[0].position = Vector2f(0, center.y);
-    axes[0].color = Color(150, 150, 150, 150);
-    axes[1].position = Vector2f(window.getSize().x, center.y);
-    axes[1].color = Color(150, 150, 150, 150);
-    axes[2].position = Vector2f(center.x, 0);
-    axes[2].color = Color(150, 150, 150, 150);
-    axes[3].position = Vector2f(center.x, window.getSize().y);
-    axes[3].color = Color(150, 150, 150, 150);
-    window.draw(axes);
-    
-    if (gridVertices.getVertexCount() > 0) window.draw(gridVertices);
-    if (highlightVertices.getVertexCount() > 0) window.draw(highlightVertices);
-    if (xVertices.getVertexCount() > 0) window.draw(xVertices);
-    if (oVertices.getVertexCount() > 0) window.draw(oVertices);
-    
-    CircleShape centerPoint(5);
-    centerPoint.setFillColor(Color::Green);
-    centerPoint.setPosition(Vector2f(center.x - 2.5f, center.y - 2.5f));
-    window.draw(centerPoint);
-}
-
-void InfiniteTicTacToe::drawUI(RenderWindow &window, const Font &font) const {
-    RectangleShape infoPanel;
-    infoPanel.setSize(Vector2f(280, 210));
-    infoPanel.setFillColor(Color(40, 40, 40, 220));
-    infoPanel.setPosition(Vector2f(10, 10));
-    window.draw(infoPanel);
-    
-    Text currentPlayerText(font, L"Текущий: " + String(currentPlayer == Cell::X ? L"X" : L"O"), 20);
-    currentPlayerText.setFillColor(currentPlayer == Cell::X ? Color::Red : Color::Blue);
-    currentPlayerText.setPosition(Vector2f(20, 20));
-    window.draw(currentPlayerText);
-    
-    String modeStr;
-    switch (mode) {
-        case GameMode::CLASSIC: modeStr = L"Классический"; break;
-        case GameMode::TIMED: modeStr = L"С таймером"; break;
-        case GameMode::SCORING: modeStr = L"Система очков"; break;
-        case GameMode::RANDOM_EVENTS: modeStr = L"Случайные события"; break;
-    }
-    
-    Text modeText(font, L"Режим: " + modeStr, 16);
-    modeText.setFillColor(Color::White);
-    modeText.setPosition(Vector2f(20, 50));
-    window.draw(modeText);
-    
-    if (mode == GameMode::CLASSIC || mode == GameMode::TIMED) {
-        Text lengthText(font, L"Линия: " + to_wstring(winningLength), 16);
-        lengthText.setFillColor(Color::White);
-        lengthText.setPosition(Vector2f(20, 75));
-        window.draw(lengthText);
-    }
-
-    if (mode == GameMode::CLASSIC) {
-        String opponentStr;
-        if (opponentType == OpponentType::PLAYER_VS_PLAYER) {
-            opponentStr = L"Игрок";
-        } else {
-            opponentStr = L"Бот";
-            String difficultyStr;
-            switch (botDifficulty) {
-                case BotDifficulty::EASY: difficultyStr = L" (лёгкий)"; break;
-                case BotDifficulty::MEDIUM: difficultyStr = L" (средний)"; break;
-                case BotDifficulty::HARD: difficultyStr = L" (сложный)"; break;
-            }
-            opponentStr += difficultyStr;
-        }
-        
-        Text opponentText(font, L"Противник: " + opponentStr, 14);
-        opponentText.setFillColor(Color::Green);
-        opponentText.setPosition(Vector2f(20, 100));
-        window.draw(opponentText);
-    }
+bool InfiniteTicTacToe::redo() {
+    if (redoStack.empty()) return false;
+    TraceScope trace("redo", "game");
     
-    if (mode == GameMode::SCORING || mode == GameMode::RANDOM_EVENTS) {
-        Text scoreText(font, L"Счет: X=" + to_wstring(playerXScore) + L" O=" + to_wstring(playerOScore), 16);
-        scoreText.setFillColor(Color::White);
-        scoreText.setPosition(Vector2f(20, 75));
-        window.draw(scoreText);
-        
-        if (mode == GameMode::RANDOM_EVENTS) {
-            Text baseText(font, L"Базовые: X=" + to_wstring(playerXBaseScore) + L" O=" + to_wstring(playerOBaseScore), 14);
-            baseText.setFillColor(Color::Green);
-            baseText.setPosition(Vector2f(20, 100));
-            window.draw(baseText);
-            
-            Text bonusText(font, L"Бонусы: X=" + to_wstring(playerXBonusScore) + L" O=" + to_wstring(playerOBonusScore), 14);
-            bonusText.setFillColor(Color::Cyan);
-            bonusText.setPosition(Vector2f(20, 125));
-            window.draw(bonusText);
-            
-            Text targetText(font, L"Цель: " + to_wstring(targetScore), 16);
-            targetText.setFillColor(Color::Yellow);
-            targetText.setPosition(Vector2f(20, 150));
-            window.draw(targetText);
-        } else {
-            Text targetText(font, L"Цель: " + to_wstring(targetScore), 16);
-            targetText.setFillColor(Color::Yellow);
-            targetText.setPosition(Vector2f(20, 100));
-            window.draw(targetText);
-        }
-    }
+    TurnDelta &turn = redoStack.back();
+    board.set(turn.move, turn.player);
+    for (const auto &erased : turn.erased) board.erase(erased.first);
+    if (turn.swapped) swapAllCells();
+    moveHistory.push_back(turn.move);
+    restoreTurnState(turn.after);
     
-    if (mode == GameMode::TIMED) { 
+    undoStack.push_back(move(turn));
+    redoStack.pop_back();
+    afterHistoryChange();
+    return true;
+}
 
-    updateTimers();
+// Часы идут у того, чья очередь после отката; автосохранение начинается с нового снимка
+void InfiniteTicTacToe::afterHistoryChange() {
+    revision++;
+    lastMoveTime = chrono::steady_clock::now();
+    
+    if (mode == GameMode::TIMED) {
+        isTimerRunning = false;
+        playerWithTimerRunning = Cell::EMPTY;
+        if (!gameWon) startTimerForPlayer(currentPlayer);
+    }
+    if (gameWon) stopJournal(true);
+    else if (journal) writeJournalSnapshot();
+    else if (!journalDirectory.empty()) startJournal(journalDirectory);
+}
 
-    float xSeconds = playerXTimeLeft.count() / 1000.0f;
-    float oSeconds = playerOTimeLeft.count() / 1000.0f;
+bool InfiniteTicTacToe::makeBotMove() {
+    if (!bot || !isBotTurn || gameWon) return false;
+    TraceScope trace("makeBotMove", "game");
+    bot->setContext(getBotContext());
+    return makeMove(bot->getBestMove(board, winningLength));
+}
 
-    wstringstream xStream, oStream;
-    xStream << fixed << setprecision(1) << xSeconds;
-    oStream << fixed << setprecision(1) << oSeconds;
-    
-    Color xColor = (currentPlayer == Cell::X) ? Color::Yellow : Color(200, 200, 200);
-    Color oColor = (currentPlayer == Cell::O) ? Color::Yellow : Color(200, 200, 200);
+BotContext InfiniteTicTacToe::getBotContext() const {
+    BotContext context;
+    context.mode = mode;
+    context.targetScore = targetScore;
+    context.pendingEvent = nextEvent;
+    context.bonusX = playerXBonusScore;
+    context.bonusO = playerOBonusScore;
+    context.eventWeights = eventWeights;
+    return context;
+}
 
-    if (playerXTimeLeft.count() < 10000) xColor = Color::Red;
-    if (playerOTimeLeft.count() < 10000) oColor = Color::Red;
+bool InfiniteTicTacToe::isGameWon() const { return gameWon; }
+bool InfiniteTicTacToe::isBotCurrentTurn() const { return isBotTurn; }
+Cell InfiniteTicTacToe::getCurrentPlayer() const { return currentPlayer; }
+pair<int, int> InfiniteTicTacToe::getScore() const { return {playerXScore, playerOScore}; }
+GameMode InfiniteTicTacToe::getGameMode() const { return mode; }
+int InfiniteTicTacToe::getTargetScore() const { return targetScore; }
+chrono::seconds InfiniteTicTacToe::getTimeLimit() const { return chrono::duration_cast<chrono::seconds>(initialTimeLimit); }
+const GameBoard& InfiniteTicTacToe::getBoard() const { return board; }
+const vector<Position>& InfiniteTicTacToe::getWinLine() const { return winLine; }
+const vector<Position>& InfiniteTicTacToe::getMoveHistory() const { return moveHistory; }
+Cell InfiniteTicTacToe::getWinner() const { return winner; }
+bool InfiniteTicTacToe::isGameEndedByScore() const { return gameEndedByScore; }
+int InfiniteTicTacToe::getWinningLength() const { return winningLength; }
+OpponentType InfiniteTicTacToe::getOpponentType() const { return opponentType; }
+BotDifficulty InfiniteTicTacToe::getBotDifficulty() const { return botDifficulty; }
+RandomEvent InfiniteTicTacToe::getNextEvent() const { return nextEvent; }
+pair<int, int> InfiniteTicTacToe::getBaseScore() const { return {playerXBaseScore, playerOBaseScore}; }
+pair<int, int> InfiniteTicTacToe::getBonusScore() const { return {playerXBonusScore, playerOBonusScore}; }
+uint64_t InfiniteTicTacToe::getRevision() const { return revision; }
+const SearchStats* InfiniteTicTacToe::getBotStats() const { return bot ? &bot->getSearchStats() : nullptr; }
+
+pair<chrono::milliseconds, chrono::milliseconds> InfiniteTicTacToe::getTimeLeft() const {
+    updateTimers();
+    return {playerXTimeLeft, playerOTimeLeft};
+}
 
-    Text xTimerText(font, L"X: " + xStream.str() + L"с", 18);
-    xTimerText.setFillColor(xColor);
-    xTimerText.setPosition(Vector2f(20, 100));
-    window.draw(xTimerText);
+bool InfiniteTicTacToe::startRecording(const string &path) {
+    stopRecording();
+    recorder = make_unique<GameRecordWriter>();
+    if (!recorder->open(path, getRecordSettings())) {
+        recorder.reset();
+        return false;
+    }
+    return true;
+}
 
-    Text oTimerText(font, L"O: " + oStream.str() + L"с", 18);
-    oTimerText.setFillColor(oColor);
-    oTimerText.setPosition(Vector2f(20, 125));
-    window.draw(oTimerText);
+void InfiniteTicTacToe::stopRecording() {
+    if (!recorder) return;
+    if (gameWon) recorder->recordEnd(winner, gameEndedByScore);
+    recorder->close();
+    recorder.reset();
+}
 
+RecordSettings InfiniteTicTacToe::getRecordSettings() const {
+    RecordSettings settings;
+    settings.mode = mode;
+    settings.winningLength = winningLength;
+    settings.targetScore = targetScore;
+    settings.timeLimit = initialTimeLimit;
+    settings.opponent = opponentType;
+    settings.difficulty = botDifficulty;
+    return settings;
+}
+
+bool InfiniteTicTacToe::startJournal(const string &directory) {
+    stopJournal(false);
+    journalDirectory = directory;
+    journal = make_unique<GameJournal>();
+    if (!journal->open(directory) || !writeJournalSnapshot()) {
+        journal.reset();
+        return false;
+    }
+    return true;
 }
-    
-    if (mode == GameMode::RANDOM_EVENTS) {
-        String eventStr;
-        switch (nextEvent) {
-            case RandomEvent::NOTHING: eventStr = L"Обычный ход"; break;
-            case RandomEvent::SCORE_PLUS_10: eventStr = L"+10 очков"; break;
-            case RandomEvent::SCORE_MINUS_10: eventStr = L"-10 очков"; break;
-            case RandomEvent::SCORE_PLUS_25: eventStr = L"+25 очков"; break;
-            case RandomEvent::SCORE_MINUS_25: eventStr = L"-25 очков"; break;
-            case RandomEvent::BONUS_MOVE: eventStr = L"Бонусный ход!"; break;
-            case RandomEvent::SWAP_PLAYERS: eventStr = L"Смена элементов!"; break;
-            case RandomEvent::CLEAR_AREA: eventStr = L"Очистка области!"; break;
-        }
-        
-        Text eventText(font, L"Cобытие этого хода: " + eventStr, 14);
 
-        eventText.setFillColor(Color::Cyan);
-        eventText.setPosition(Vector2f(20, 175));
-        window.draw(eventText);
+// Снимок плюс повтор хвоста журнала; хвост короткий, поэтому счет пересчитывается
+// только на его ходах, а не для всей партии
+bool InfiniteTicTacToe::resumeJournal(const string &directory) {
+    TraceScope trace("resumeJournal", "journal");
+    JournalContents contents;
+    if (!GameJournal::load(directory, contents)) return false;
+    
+    BinaryReader reader(contents.state.data(), contents.state.size());
+    stopRecording();
+    stopJournal(false);
+    if (!loadState(contents.settings, reader) || moveHistory.size() != contents.snapshotMoves) return false;
+    
+    // Случайные события повторяются тем же генератором; nextEvent и часы берутся из журнала
+    for (const auto &entry : contents.tail) {
+        if (gameWon) break;
+        applyMove(entry.move);
+        if (moveHistory.size() != entry.moveCount) return false;
+        playerXTimeLeft = entry.timeLeftX;
+        playerOTimeLeft = entry.timeLeftO;
+        nextEvent = entry.nextEvent;
     }
+    if (gameWon) return false;
     
+    if (mode == GameMode::TIMED) {
+        isTimerRunning = false;
+        startTimerForPlayer(currentPlayer);
+    }
+    revision++;
+    
+    // Новый снимок сразу поглощает повторенный хвост
+    return startJournal(directory);
+}
+
+void InfiniteTicTacToe::stopJournal(bool discard) {
+    if (!journal) return;
+    if (discard) journal->discard();
+    else journal->close();
+    journal.reset();
+}
+
+void InfiniteTicTacToe::journalMove(chrono::steady_clock::duration moveCost) {
+    // Законченную партию восстанавливать незачем
     if (gameWon) {
-        RectangleShape winPanel;
-        winPanel.setSize(Vector2f(420, 160));
-        winPanel.setFillColor(Color(0, 0, 0, 220));
-        winPanel.setPosition(Vector2f(
-            window.getSize().x / 2.0f - 210, 
-            window.getSize().y / 2.0f - 80
-        ));
-        window.draw(winPanel);
-        
-        String winMessage;
-        if (gameEndedByScore) {
-            winMessage = L"Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
-                        L" достиг цели в " + to_wstring(targetScore) + L" очков!\n" +
-                        L"Финальный счет: X=" + to_wstring(playerXScore) + 
-                        L" O=" + to_wstring(playerOScore);
-        } 
-        else if (mode == GameMode::TIMED  && winLine.empty()) {
+        stopJournal(true);
+        return;
+    }
+    
+    JournalEntry entry;
+    entry.moveCount = moveHistory.size();
+    entry.move = moveHistory.back();
+    tie(entry.timeLeftX, entry.timeLeftO) = getTimeLeft();
+    entry.nextEvent = nextEvent;
+    journal->append(entry);
+    
+    journalReplayCost += moveCost;
+    if (journal->getEntriesSinceSnapshot() >= journalSnapshotInterval || journalReplayCost >= journalReplayBudget) {
+        writeJournalSnapshot();
+    }
+}
 
-            winMessage = L" Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
-                        L" выиграл по времени!\n" +
-                        L"У противника закончилось время.";
-        }
-        else {
-            winMessage = L"Игрок " + String(winner == Cell::X ? L"X" : L"O") + 
-                        L" собрал линию из " + to_wstring(winningLength) + L" элементов!";
+bool InfiniteTicTacToe::writeJournalSnapshot() {
+    journalReplayCost = chrono::steady_clock::duration(0);
+    BinaryWriter state;
+    saveState(state);
+    return journal->writeSnapshot(getRecordSettings(), moveHistory.size(), state);
+}
+
+// Полное состояние партии, кроме настроек: их хранит заголовок снимка
+void InfiniteTicTacToe::saveState(BinaryWriter &writer) const {
+    updateTimers();
+    writer.writeByte((uint8_t)currentPlayer);
+    writer.writeByte((uint8_t)winner);
+    writer.writeByte((uint8_t)nextEvent);
+    writer.writeByte((uint8_t)((gameWon ? 1 : 0) | (gameEndedByScore ? 2 : 0) | (isBotTurn ? 4 : 0)));
+    for (int score : {playerXScore, playerOScore, playerXBaseScore, playerOBaseScore, playerXBonusScore, playerOBonusScore}) {
+        writer.writeSigned(score);
+    }
+    writer.writeVarint((uint64_t)max<int64_t>(0, playerXTimeLeft.count()));
+    writer.writeVarint((uint64_t)max<int64_t>(0, playerOTimeLeft.count()));
+    
+    stringstream rngState;
+    rngState << rng;
+    string rngText = rngState.str();
+    writer.writeVarint(rngText.size());
+    writer.writeBytes(rngText.data(), rngText.size());
+    
+    int minX, maxX, minY, maxY;
+    board.getBounds(minX, maxX, minY, maxY);
+    for (int bound : {minX, maxX, minY, maxY}) writer.writeSigned(bound);
+    
+    // Камни по строкам, координаты - разностями от предыдущего камня
+    vector<Position> stones = board.getOccupiedPositions();
+    sort(stones.begin(), stones.end(), [](const Position &a, const Position &b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+    writer.writeVarint(stones.size());
+    Position previous(0, 0);
+    for (const auto &stone : stones) {
+        writer.writeSigned(stone.y - previous.y);
+        writer.writeSigned(stone.x - previous.x);
+        writer.writeByte((uint8_t)board.get(stone));
+        previous = stone;
+    }
+    
+    for (const vector<Position> *positions : {&moveHistory, &winLine}) {
+        writer.writeVarint(positions->size());
+        previous = Position(0, 0);
+        for (const auto &pos : *positions) {
+            writer.writeSigned(pos.x - previous.x);
+            writer.writeSigned(pos.y - previous.y);
+            previous = pos;
         }
-        
-        Text winText(font, winMessage, 22);
-        winText.setFillColor(winner == Cell::X ? Color::Red : Color::Blue);
-        winText.setLineSpacing(1.2f);
-        
-        FloatRect textBounds = winText.getLocalBounds();
-        winText.setPosition(Vector2f(
-            window.getSize().x / 2.0f - textBounds.size.x / 2, 
-            window.getSize().y / 2.0f - 50
-        ));
-        window.draw(winText);
-        
-        Text restartText(font, L"Нажмите Enter для новой игры\nили ESC для выхода в меню", 18);
-        restartText.setFillColor(Color::White);
-        textBounds = restartText.getLocalBounds();
-        restartText.setPosition(Vector2f(
-            window.getSize().x / 2.0f - textBounds.size.x / 2, 
-            window.getSize().y / 2.0f + 20
-        ));
-        window.draw(restartText);
     }
 }
 
-bool InfiniteTicTacToe::isGameWon() const { return gameWon; }
-bool InfiniteTicTacToe::isBotCurrentTurn() const { return isBotTurn; }
-Cell InfiniteTicTacToe::getCurrentPlayer() const { return currentPlayer; }
-pair<int, int> InfiniteTicTacToe::getScore() const { return {playerXScore, playerOScore}; }
-GameMode InfiniteTicTacToe::getGameMode() const { return mode; }
-int InfiniteTicTacToe::getTargetScore() const { return targetScore; }
-chrono::seconds InfiniteTicTacToe::getTimeLimit() const { return chrono::duration_cast<chrono::seconds>(initialTimeLimit); }
+bool InfiniteTicTacToe::loadState(const RecordSettings &settings, BinaryReader &reader) {
+    mode = settings.mode;
+    winningLength = settings.winningLength;
+    targetScore = settings.targetScore;
+    initialTimeLimit = settings.timeLimit;
+    opponentType = settings.opponent;
+    botDifficulty = settings.difficulty;
+    
+    uint8_t player, winnerCell, event, flags;
+    if (!reader.readByte(player) || !reader.readByte(winnerCell) || !reader.readByte(event) || !reader.readByte(flags)) return false;
+    currentPlayer = (Cell)player;
+    winner = (Cell)winnerCell;
+    nextEvent = (RandomEvent)event;
+    gameWon = flags & 1;
+    gameEndedByScore = flags & 2;
+    isBotTurn = flags & 4;
+    
+    int64_t scores[6];
+    for (auto &score : scores) if (!reader.readSigned(score)) return false;
+    playerXScore = (int)scores[0];
+    playerOScore = (int)scores[1];
+    playerXBaseScore = (int)scores[2];
+    playerOBaseScore = (int)scores[3];
+    playerXBonusScore = (int)scores[4];
+    playerOBonusScore = (int)scores[5];
+    
+    uint64_t timeX, timeO, rngSize;
+    if (!reader.readVarint(timeX) || !reader.readVarint(timeO) || !reader.readVarint(rngSize)) return false;
+    playerXTimeLeft = chrono::milliseconds(timeX);
+    playerOTimeLeft = chrono::milliseconds(timeO);
+    isTimerRunning = false;
+    playerWithTimerRunning = Cell::EMPTY;
+    
+    string rngText(rngSize, '\0');
+    if (!reader.readBytes(rngText.data(), rngSize)) return false;
+    stringstream rngState(rngText);
+    rngState >> rng;
+    if (rngState.fail()) return false;
+    
+    int64_t bounds[4];
+    for (auto &bound : bounds) if (!reader.readSigned(bound)) return false;
+    
+    uint64_t stoneCount;
+    if (!reader.readVarint(stoneCount)) return false;
+    board.clear();
+    Position previous(0, 0);
+    for (uint64_t i = 0; i < stoneCount; i++) {
+        int64_t dy, dx;
+        uint8_t cell;
+        if (!reader.readSigned(dy) || !reader.readSigned(dx) || !reader.readByte(cell)) return false;
+        previous = Position(previous.x + (int)dx, previous.y + (int)dy);
+        board.set(previous, (Cell)cell);
+    }
+    board.setBounds((int)bounds[0], (int)bounds[1], (int)bounds[2], (int)bounds[3]);
+    
+    for (vector<Position> *positions : {&moveHistory, &winLine}) {
+        uint64_t count;
+        if (!reader.readVarint(count)) return false;
+        positions->clear();
+        positions->reserve(count);
+        previous = Position(0, 0);
+        for (uint64_t i = 0; i < count; i++) {
+            int64_t dx, dy;
+            if (!reader.readSigned(dx) || !reader.readSigned(dy)) return false;
+            previous = Position(previous.x + (int)dx, previous.y + (int)dy);
+            positions->push_back(previous);
+        }
+    }
+    
+    if (!moveHistory.empty()) lastCheckedPos = moveHistory.back();
+    undoStack.clear();
+    redoStack.clear();
+    checkDirections.fill(true);
+    lastMoveTime = chrono::steady_clock::now();
+    
+    // Бот всегда ходит первым и играет крестиками
+    if (opponentType == OpponentType::PLAYER_VS_BOT) bot = createBot(botDifficulty, Cell::X, mode);
+    else bot.reset();
+    revision++;
+    return true;
+}
 
 void InfiniteTicTacToe::reset() {
+    stopRecording();
+    stopJournal(true);
+    journalDirectory.clear();
+    undoStack.clear();
+    redoStack.clear();
     board.clear();
     moveHistory.clear();
     moveHistory.reserve(100);
@@ -766,10 +756,8 @@ void InfiniteTicTacToe::reset() {
     winner = Cell::EMPTY;
     nextEvent = RandomEvent::NOTHING;
     lastMoveTime = chrono::steady_clock::now();
-    graphicsDirty = true;
+    revision++;
     checkDirections.fill(true);
-    cellSize = 40.0f;
-    visited.clear();
 
     if (mode == GameMode::TIMED) {
         playerXTimeLeft = initialTimeLimit;
@@ -780,12 +768,8 @@ void InfiniteTicTacToe::reset() {
     }
 
     if (opponentType == OpponentType::PLAYER_VS_BOT) {
-        if (!bot) {
-            bot = make_unique<TicTacToeBot>(botDifficulty, currentPlayer);
-        } else {
-            bot->setSymbol(currentPlayer);
-            bot->setDifficulty(botDifficulty);
-        }
+        // Движок зависит от режима, а reset с новыми настройками мог его сменить
+        bot = createBot(botDifficulty, currentPlayer, mode);
         isBotTurn = true;
     } else {
         isBotTurn = false;
@@ -805,21 +789,6 @@ void InfiniteTicTacToe::reset(GameMode newMode, int newWinningLength, int newTar
     reset();
 }
 
-void InfiniteTicTacToe::forceGraphicsUpdate() {
-    graphicsDirty = true;
-    updateGraphics();
-}
-
-void InfiniteTicTacToe::setCellSize(float size) {
-    cellSize = size;
-    graphicsDirty = true;
-}
-
-void InfiniteTicTacToe::setCenter(const Vector2f &newCenter) {
-    center = newCenter;
-    graphicsDirty = true;
-}
-
 bool InfiniteTicTacToe::isTimeUp() const {
 
     updateTimers();
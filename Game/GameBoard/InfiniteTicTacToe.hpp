@@ -1,22 +1,58 @@
 #pragma once
 
 #include "GameBoard.hpp"
-#include "AI/TicTacToeBot.hpp"
+#include "GameRecord.hpp"
+#include "GameJournal.hpp"
+#include "Scoring.hpp"
+#include "AI/BotEngine.hpp"
 #include "../GameStates.hpp"
-#include <SFML/Graphics.hpp>
+#include "Core/Trace.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <chrono>
 #include <random>
-#include <cmath>
 #include <sstream>
-#include <iomanip>
+#include <cmath>
 
 using namespace std;
-using namespace sf;
 
 
+// Все, что меняет ход, кроме самого поля: этого хватает, чтобы откатить или повторить ход
+// без пересчета счета. Генератор событий небольшой, его копия в каждом ходе дешева.
+struct TurnState {
+    Cell currentPlayer = Cell::X;
+    Cell winner = Cell::EMPTY;
+    RandomEvent nextEvent = RandomEvent::NOTHING;
+    bool isBotTurn = false;
+    bool gameWon = false;
+    bool gameEndedByScore = false;
+    array<int, 6> scores = {};
+    chrono::milliseconds timeLeftX = chrono::milliseconds(0);
+    chrono::milliseconds timeLeftO = chrono::milliseconds(0);
+    minstd_rand rng;
+    array<int, 4> bounds = {};
+    vector<Position> winLine;
+    Position lastCheckedPos;
+};
+
+// Обратимое изменение одного хода: поставленный камень, стертые событием клетки,
+// смена всех элементов и состояние до и после хода
+struct TurnDelta {
+    Position move;
+    Cell player = Cell::EMPTY;
+    vector<pair<Position, Cell>> erased;
+    bool swapped = false;
+    // Событие, разыгранное после хода; NOTHING, если его не было или ход закончил партию
+    RandomEvent event = RandomEvent::NOTHING;
+    TurnState before;
+    TurnState after;
+};
+
 class InfiniteTicTacToe {
+    friend struct BenchAccess;
+
     private:
         // Игровое состояние
         GameBoard board;
@@ -31,13 +67,9 @@ class InfiniteTicTacToe {
         mutable bool isTimerRunning;
         mutable Cell playerWithTimerRunning;
         
-        // Графика
-        float cellSize;
-        Vector2f center;
-        
         // Игровая логика
         OpponentType opponentType;
-        unique_ptr<TicTacToeBot> bot;
+        unique_ptr<BotEngine> bot;
         BotDifficulty botDifficulty;
         chrono::steady_clock::time_point lastMoveTime;
         
@@ -49,8 +81,10 @@ class InfiniteTicTacToe {
         int playerXBonusScore;
         int playerOBonusScore;
         
-        mt19937 rng;
+        minstd_rand rng;
         uniform_int_distribution<int> eventChance;
+        // Веса событий по порядку RandomEvent; бросок - от 0 до суммы весов
+        array<int, 8> eventWeights;
         vector<Position> moveHistory;
         vector<Position> winLine;
         RandomEvent nextEvent;
@@ -64,16 +98,36 @@ class InfiniteTicTacToe {
         mutable array<bool, 4> checkDirections;
         Position lastCheckedPos;
         
-        // Графический кэш
-        mutable bool graphicsDirty;
-        mutable VertexArray gridVertices;
-        mutable VertexArray xVertices;
-        mutable VertexArray oVertices;
-        mutable VertexArray highlightVertices;
+        // Счетчик изменений поля, по нему отрисовка понимает, что кэш устарел
+        uint64_t revision;
+        
+        // Отмена и повтор ходов; activeTurn собирает изменения хода, пока он выполняется
+        vector<TurnDelta> undoStack;
+        vector<TurnDelta> redoStack;
+        TurnDelta *activeTurn;
+        
+        // Запись партии на диск, если включена
+        unique_ptr<GameRecordWriter> recorder;
+        // Автосохранение для восстановления после сбоя
+        unique_ptr<GameJournal> journal;
+        // Остается после конца партии: отмена последнего хода снова включает автосохранение
+        string journalDirectory;
+        // Снимок делается каждые journalSnapshotInterval ходов или раньше, когда повтор хвоста
+        // (пересчет счета на большом поле) стал бы дольше journalReplayBudget
+        static constexpr size_t journalSnapshotInterval = 64;
+        static constexpr chrono::milliseconds journalReplayBudget = chrono::milliseconds(40);
+        chrono::steady_clock::duration journalReplayCost;
         
         // Вспомогательные методы
-        mutable unordered_map<pair<int, int>, bool, PositionHash> visited;
-        bool checkLine(const Position &start, int dx, int dy, int length, Cell player) const;
+        bool applyMove(const Position &pos);
+        void journalMove(chrono::steady_clock::duration moveCost);
+        bool writeJournalSnapshot();
+        RecordSettings getRecordSettings() const;
+        void captureTurnState(TurnState &state) const;
+        void restoreTurnState(const TurnState &state);
+        void afterHistoryChange();
+        void saveState(BinaryWriter &writer) const;
+        bool loadState(const RecordSettings &settings, BinaryReader &reader);
         vector<Position> getWinningLine(const Position &start, int dx, int dy, int length, Cell player) const;
         bool checkWin(const Position &lastMove);
         void expandBoardIfNeeded(const Position &newPos);
@@ -83,9 +137,6 @@ class InfiniteTicTacToe {
         void updateTotalScores();
         void calculateBaseScores();
         void calculateBoardScores();
-        int findMaxLineScore(const Position &startPos, Cell player);
-        int countInDirection(const Position &start, int dx, int dy, Cell player) const;
-        void updateGraphics() const;
 
         void startTimerForPlayer(Cell player) const;
         void stopTimer() const;
@@ -93,14 +144,14 @@ class InfiniteTicTacToe {
 
     public:
         InfiniteTicTacToe(GameMode mode = GameMode::CLASSIC, int winningLength = 5, int targetScore = 100,
-                          chrono::seconds timeLimit = chrono::seconds(10), Vector2f windowCenter = Vector2f(400, 300),
+                          chrono::seconds timeLimit = chrono::seconds(10),
                           OpponentType oppType = OpponentType::PLAYER_VS_PLAYER, BotDifficulty botDiff = BotDifficulty::MEDIUM);
+        ~InfiniteTicTacToe();
         
         // Основные методы
-        bool handleClick(const Vector2f &mousePos);
-        void makeBotMove();
-        void draw(RenderWindow &window) const;
-        void drawUI(RenderWindow &window, const Font &font) const;
+        // Ход текущего игрока (человека или бота), true если партия закончилась
+        bool makeMove(const Position &pos);
+        bool makeBotMove();
         
         // Геттеры
         bool isGameWon() const;
@@ -111,11 +162,47 @@ class InfiniteTicTacToe {
         int getTargetScore() const;
         chrono::seconds getTimeLimit() const;
         bool isTimeUp() const;
+        const GameBoard& getBoard() const;
+        const vector<Position>& getWinLine() const;
+        const vector<Position>& getMoveHistory() const;
+        Cell getWinner() const;
+        bool isGameEndedByScore() const;
+        int getWinningLength() const;
+        OpponentType getOpponentType() const;
+        BotDifficulty getBotDifficulty() const;
+        RandomEvent getNextEvent() const;
+        pair<int, int> getBaseScore() const;
+        pair<int, int> getBonusScore() const;
+        pair<chrono::milliseconds, chrono::milliseconds> getTimeLeft() const;
+        uint64_t getRevision() const;
+        const SearchStats* getBotStats() const;
+        // Все, что нужно движку бота сверх поля: цель, бонусы и событие после текущего хода
+        BotContext getBotContext() const;
+        
+        // Отмена и повтор хода; стоимость - размер изменений хода, а не поля
+        bool undo();
+        bool redo();
+        bool canUndo() const { return !undoStack.empty(); }
+        bool canRedo() const { return !redoStack.empty(); }
+        // Изменения последнего хода, например для потока зрителей; nullptr - ходов нет
+        const TurnDelta* getLastTurn() const { return undoStack.empty() ? nullptr : &undoStack.back(); }
+        
+        // Запись текущей партии; reset() закрывает файл
+        bool startRecording(const string &path);
+        void stopRecording();
+        
+        // Автосохранение в каталог: новая партия начинается со снимка, resumeJournal
+        // продолжает партию из снимка и хвоста журнала. false - восстанавливать нечего
+        bool startJournal(const string &directory);
+        bool resumeJournal(const string &directory);
+        void stopJournal(bool discard);
+        
+        // Настройка событий для симуляций баланса; reset() ее не сбрасывает
+        void seedEvents(uint32_t seed) { rng.seed(seed); }
+        bool setEventWeights(const array<int, 8> &weights);
+        const array<int, 8>& getEventWeights() const { return eventWeights; }
         
         // Сброс и настройка
         void reset();
         void reset(GameMode newMode, int newWinningLength, int newTargetScore, chrono::seconds newTimeLimit);
-        void forceGraphicsUpdate();
-        void setCellSize(float size);
-        void setCenter(const Vector2f &newCenter);
 };
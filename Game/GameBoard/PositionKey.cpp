@@ -0,0 +1,146 @@
+#include "PositionKey.hpp"
+#include <climits>
+
+
+static uint64_t mixCell(int x, int y, Cell cell) {
+    uint64_t z = (uint64_t)(uint32_t)x * 0x9E3779B97F4A7C15ULL ^ (uint64_t)(uint32_t)y * 0xC2B2AE3D27D4EB4FULL;
+    z += (cell == Cell::X) ? 0x165667B19E3779F9ULL : 0x27D4EB2F165667C5ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static Position applySymmetry(const Position &pos, int symmetry) {
+    int x = (symmetry & 1) ? pos.y : pos.x;
+    int y = (symmetry & 1) ? pos.x : pos.y;
+    if (symmetry & 2) x = -x;
+    if (symmetry & 4) y = -y;
+    return Position(x, y);
+}
+
+BoardTransform::BoardTransform(int symmetry, int offsetX, int offsetY):
+    symmetry(symmetry), offsetX(offsetX), offsetY(offsetY) {}
+
+Position BoardTransform::apply(const Position &pos) const {
+    Position turned = applySymmetry(pos, symmetry);
+    return Position(turned.x - offsetX, turned.y - offsetY);
+}
+
+Position BoardTransform::inverse(const Position &pos) const {
+    int x = pos.x + offsetX;
+    int y = pos.y + offsetY;
+    if (symmetry & 2) x = -x;
+    if (symmetry & 4) y = -y;
+    return (symmetry & 1) ? Position(y, x) : Position(x, y);
+}
+
+// Ключ зависит только от камней, поэтому на обоих полях одинаков
+static PositionKey keyOfStones(const vector<Position> &xStones, const vector<Position> &oStones, bool useSymmetry) {
+    PositionKey best{0, BoardTransform()};
+    bool found = false;
+    int symmetries = useSymmetry ? 8 : 1;
+
+    for (int symmetry = 0; symmetry < symmetries; symmetry++) {
+        int minX = INT_MAX, minY = INT_MAX;
+        for (const auto &pos : xStones) {
+            Position turned = applySymmetry(pos, symmetry);
+            minX = min(minX, turned.x);
+            minY = min(minY, turned.y);
+        }
+        for (const auto &pos : oStones) {
+            Position turned = applySymmetry(pos, symmetry);
+            minX = min(minX, turned.x);
+            minY = min(minY, turned.y);
+        }
+        if (minX == INT_MAX) minX = minY = 0;
+
+        // Сумма не зависит от порядка обхода хеш-таблицы, сортировка не нужна
+        uint64_t hash = 0;
+        for (const auto &pos : xStones) {
+            Position turned = applySymmetry(pos, symmetry);
+            hash += mixCell(turned.x - minX, turned.y - minY, Cell::X);
+        }
+        for (const auto &pos : oStones) {
+            Position turned = applySymmetry(pos, symmetry);
+            hash += mixCell(turned.x - minX, turned.y - minY, Cell::O);
+        }
+
+        if (!found || hash < best.hash) {
+            best = {hash, BoardTransform(symmetry, minX, minY)};
+            found = true;
+        }
+    }
+
+    return best;
+}
+
+PositionKey computePositionKey(const GameBoard &board, bool useSymmetry) {
+    return keyOfStones(board.getOccupiedPositions(Cell::X), board.getOccupiedPositions(Cell::O), useSymmetry);
+}
+
+PositionKey computePositionKey(const WorkspaceBoard &board, bool useSymmetry) {
+    return keyOfStones(board.getOccupiedPositions(Cell::X), board.getOccupiedPositions(Cell::O), useSymmetry);
+}
+
+static constexpr uint64_t KEY_MODULUS = (1ULL << 61) - 1;
+static constexpr uint64_t KEY_BASE_X = 0x0B3A5C1D2E9F4817ULL;
+static constexpr uint64_t KEY_BASE_Y = 0x1C6E2F8A937D5B41ULL;
+static constexpr uint64_t KEY_CODE_X = 0x05A17C3E9B24D6F1ULL;
+static constexpr uint64_t KEY_CODE_O = 0x13D8E6A2F75C0B39ULL;
+
+static uint64_t mulMod(uint64_t a, uint64_t b) {
+    unsigned __int128 product = (unsigned __int128)a * b;
+    uint64_t result = (uint64_t)(product & KEY_MODULUS) + (uint64_t)(product >> 61);
+    return result >= KEY_MODULUS ? result - KEY_MODULUS : result;
+}
+
+static uint64_t powMod(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    for (; exponent; exponent >>= 1) {
+        if (exponent & 1) result = mulMod(result, base);
+        base = mulMod(base, base);
+    }
+    return result;
+}
+
+// Модуль простой, обратное - степень p - 2
+static const uint64_t KEY_INVERSE_X = powMod(KEY_BASE_X, KEY_MODULUS - 2);
+static const uint64_t KEY_INVERSE_Y = powMod(KEY_BASE_Y, KEY_MODULUS - 2);
+
+static uint64_t powerOf(uint64_t base, uint64_t inverse, int64_t exponent) {
+    return exponent >= 0 ? powMod(base, (uint64_t)exponent) : powMod(inverse, (uint64_t)-exponent);
+}
+
+IncrementalKey::IncrementalKey(): sum(0), minX(0), minY(0), empty(true) {}
+
+IncrementalKey::IncrementalKey(const GameBoard &board): IncrementalKey() {
+    for (const auto &pos : board.getOccupiedPositions(Cell::X)) add(pos, Cell::X);
+    for (const auto &pos : board.getOccupiedPositions(Cell::O)) add(pos, Cell::O);
+}
+
+IncrementalKey::IncrementalKey(const WorkspaceBoard &board): IncrementalKey() {
+    for (const auto &pos : board.getOccupiedPositions(Cell::X)) add(pos, Cell::X);
+    for (const auto &pos : board.getOccupiedPositions(Cell::O)) add(pos, Cell::O);
+}
+
+void IncrementalKey::add(const Position &pos, Cell cell) {
+    uint64_t weight = mulMod(powerOf(KEY_BASE_X, KEY_INVERSE_X, pos.x), powerOf(KEY_BASE_Y, KEY_INVERSE_Y, pos.y));
+    sum += mulMod(cell == Cell::X ? KEY_CODE_X : KEY_CODE_O, weight);
+    if (sum >= KEY_MODULUS) sum -= KEY_MODULUS;
+
+    minX = empty ? pos.x : min(minX, pos.x);
+    minY = empty ? pos.y : min(minY, pos.y);
+    empty = false;
+}
+
+IncrementalKey IncrementalKey::with(const Position &pos, Cell cell) const {
+    IncrementalKey child = *this;
+    child.add(pos, cell);
+    return child;
+}
+
+PositionKey IncrementalKey::key() const {
+    uint64_t hash = mulMod(mulMod(sum, powerOf(KEY_BASE_X, KEY_INVERSE_X, -(int64_t)minX)),
+        powerOf(KEY_BASE_Y, KEY_INVERSE_Y, -(int64_t)minY));
+    return {hash, BoardTransform(0, minX, minY)};
+}
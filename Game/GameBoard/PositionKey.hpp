@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GameBoard.hpp"
+#include "WorkspaceBoard.hpp"
+#include <cstdint>
+
+using namespace std;
+
+
+// Отображение абсолютных координат в каноническую систему: симметрия, затем сдвиг
+struct BoardTransform {
+    int symmetry;
+    int offsetX, offsetY;
+
+    BoardTransform(int symmetry = 0, int offsetX = 0, int offsetY = 0);
+
+    Position apply(const Position &pos) const;
+    Position inverse(const Position &pos) const;
+};
+
+// Ключ позиции, не зависящий от сдвига (и, опционально, от 8 симметрий квадрата)
+struct PositionKey {
+    uint64_t hash;
+    BoardTransform transform;
+};
+
+PositionKey computePositionKey(const GameBoard &board, bool useSymmetry = false);
+PositionKey computePositionKey(const WorkspaceBoard &board, bool useSymmetry = false);
+
+// Ключ поиска без симметрий, обновляемый за O(1) на ход: сумма весов камней по модулю 2^61 - 1,
+// вес клетки (x, y) - код цвета, умноженный на A^x * B^y. Сдвиг позиции умножает сумму на A^dx * B^dy,
+// поэтому сумма, приведенная к углу прямоугольника камней, от сдвига не зависит.
+// Прямоугольник при снятии камня не сжимается: поиск снимает ход, возвращаясь к копии ключа родителя
+class IncrementalKey {
+    private:
+        uint64_t sum;
+        int minX, minY;
+        bool empty;
+
+    public:
+        IncrementalKey();
+        explicit IncrementalKey(const GameBoard &board);
+        explicit IncrementalKey(const WorkspaceBoard &board);
+
+        void add(const Position &pos, Cell cell);
+        IncrementalKey with(const Position &pos, Cell cell) const;
+        // Хеш в системе угла прямоугольника; сдвиг системы - в transform
+        PositionKey key() const;
+};
@@ -0,0 +1,196 @@
+#include "Scoring.hpp"
+#include <unordered_set>
+
+
+// Направления в порядке выбора: при равной длине побеждает первое
+static constexpr array<pair<int, int>, 4> LINE_DIRECTIONS = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+// Порядок обхода разметки - по строкам
+static bool byRows(const Position &a, const Position &b) {
+    return a.y != b.y ? a.y < b.y : a.x < b.x;
+}
+
+int calculateLineScore(const GameBoard &board, Cell player) {
+    LineScoreTracker tracker(player);
+    tracker.rebuild(board);
+    return tracker.getScore();
+}
+
+int eventBonus(RandomEvent event) {
+    switch (event) {
+        case RandomEvent::SCORE_PLUS_10: return 10;
+        case RandomEvent::SCORE_MINUS_10: return -10;
+        case RandomEvent::SCORE_PLUS_25: return 25;
+        case RandomEvent::SCORE_MINUS_25: return -25;
+        default: return 0;
+    }
+}
+
+LineScoreTracker::LineScoreTracker(Cell player): player(player), score(0) {}
+
+// Самая длинная линия через камень; owned говорит, чей камень на клетке
+template <typename Owned>
+static LineScoreTracker::StoneLine longestLine(const Position &stone, const Owned &owned) {
+    LineScoreTracker::StoneLine line;
+    for (int direction = 0; direction < (int)LINE_DIRECTIONS.size(); direction++) {
+        int dx = LINE_DIRECTIONS[direction].first, dy = LINE_DIRECTIONS[direction].second;
+        int length = 1;
+        for (Position pos(stone.x + dx, stone.y + dy); owned(pos); pos = Position(pos.x + dx, pos.y + dy)) length++;
+        for (Position pos(stone.x - dx, stone.y - dy); owned(pos); pos = Position(pos.x - dx, pos.y - dy)) length++;
+        if (length > line.length) {
+            line.direction = (int8_t)direction;
+            line.length = (int16_t)length;
+        }
+    }
+    return line;
+}
+
+void LineScoreTracker::rebuild(const GameBoard &board) {
+    auto owned = [&board, this](const Position &pos) { return board.get(pos) == player; };
+
+    // Порядок обхода по строкам: одна позиция дает один счет, как бы ни было построено поле
+    vector<Position> positions = board.getOccupiedPositions(player);
+    sort(positions.begin(), positions.end(), byRows);
+
+    stones.clear();
+    score = 0;
+    unordered_set<pair<int, int>, PositionHash> visited;
+    for (const Position &stone : positions) {
+        StoneLine line = longestLine(stone, owned);
+        line.start = !visited.count(stone.toPair());
+        if (line.start) {
+            int dx = LINE_DIRECTIONS[line.direction].first, dy = LINE_DIRECTIONS[line.direction].second;
+            for (Position pos = stone; owned(pos); pos = Position(pos.x + dx, pos.y + dy)) visited.insert(pos.toPair());
+            for (Position pos = stone; owned(pos); pos = Position(pos.x - dx, pos.y - dy)) visited.insert(pos.toPair());
+            score += line.length * line.length;
+        }
+        stones[stone.toPair()] = line;
+    }
+}
+
+// Камни обрабатываются по строкам, как в полном обходе: когда очередь доходит до камня, разметка
+// всех более ранних камней уже окончательная. Камень засчитывает линию, если ни один более ранний
+// засчитавший камень на его сериях не выбрал направление этой серии
+int LineScoreTracker::propagate(const GameBoard &board, const Position &cell, vector<pair<Position, StoneLine>> &changes) const {
+    auto owned = [&board, &cell, this](const Position &pos) { return pos == cell || board.get(pos) == player; };
+    auto current = [&changes, this](const Position &pos) {
+        for (const auto &change : changes) {
+            if (change.first == pos) return change.second;
+        }
+        return stones.at(pos.toPair());
+    };
+
+    // Одинокий камень: своя линия из одной клетки, накрывать некого
+    bool lonely = true;
+    for (int dx = -1; dx <= 1 && lonely; dx++) {
+        for (int dy = -1; dy <= 1 && lonely; dy++) {
+            if ((dx || dy) && board.get(Position(cell.x + dx, cell.y + dy)) == player) lonely = false;
+        }
+    }
+    if (lonely) {
+        changes.emplace_back(cell, StoneLine{0, 1, true});
+        return 1;
+    }
+
+    // Затронутых камней единицы, поэтому очередь - вектор, упорядоченный по строкам с конца
+    vector<Position> &pending = pendingScratch;
+    vector<Position> &relined = relinedScratch;
+    pending.clear();
+    auto push = [&pending](const Position &pos) {
+        auto it = lower_bound(pending.begin(), pending.end(), pos, [](const Position &a, const Position &b) { return byRows(b, a); });
+        if (it == pending.end() || !(*it == pos)) pending.insert(it, pos);
+    };
+
+    // Длина линий меняется только у камней на сериях через клетку
+    push(cell);
+    for (const auto &dir : LINE_DIRECTIONS) {
+        for (Position pos(cell.x + dir.first, cell.y + dir.second); owned(pos); pos = Position(pos.x + dir.first, pos.y + dir.second)) push(pos);
+        for (Position pos(cell.x - dir.first, cell.y - dir.second); owned(pos); pos = Position(pos.x - dir.first, pos.y - dir.second)) push(pos);
+    }
+    relined = pending;
+
+    // Камни серии, которые идут после stone: их может накрыть (или перестать накрывать) его линия
+    auto pushLater = [&](const Position &stone, int direction) {
+        int dx = LINE_DIRECTIONS[direction].first, dy = LINE_DIRECTIONS[direction].second;
+        for (Position pos(stone.x + dx, stone.y + dy); owned(pos); pos = Position(pos.x + dx, pos.y + dy)) {
+            if (byRows(stone, pos)) push(pos);
+        }
+        for (Position pos(stone.x - dx, stone.y - dy); owned(pos); pos = Position(pos.x - dx, pos.y - dy)) {
+            if (byRows(stone, pos)) push(pos);
+        }
+    };
+
+    int delta = 0;
+    while (!pending.empty()) {
+        Position stone = pending.back();
+        pending.pop_back();
+
+        bool known = !(stone == cell);
+        StoneLine old = known ? stones.at(stone.toPair()) : StoneLine();
+        bool changedRuns = find(relined.begin(), relined.end(), stone) != relined.end();
+        StoneLine line = changedRuns ? longestLine(stone, owned) : old;
+
+        line.start = true;
+        for (int direction = 0; direction < (int)LINE_DIRECTIONS.size() && line.start; direction++) {
+            int dx = LINE_DIRECTIONS[direction].first, dy = LINE_DIRECTIONS[direction].second;
+            for (int sign = -1; sign <= 1 && line.start; sign += 2) {
+                for (Position pos(stone.x + sign * dx, stone.y + sign * dy); owned(pos); pos = Position(pos.x + sign * dx, pos.y + sign * dy)) {
+                    if (!byRows(pos, stone)) continue;
+                    StoneLine earlier = current(pos);
+                    if (earlier.start && earlier.direction == direction) {
+                        line.start = false;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (known && line == old) continue;
+        changes.emplace_back(stone, line);
+        delta += (line.start ? line.length * line.length : 0) - (known && old.start ? old.length * old.length : 0);
+
+        // Соседям важно только, какую серию накрывает камень
+        bool oldCovers = known && old.start;
+        if (oldCovers != line.start || (oldCovers && old.direction != line.direction)) {
+            if (oldCovers) pushLater(stone, old.direction);
+            if (line.start) pushLater(stone, line.direction);
+        }
+    }
+    return delta;
+}
+
+int LineScoreTracker::placeDelta(const GameBoard &board, const Position &cell) const {
+    changesScratch.clear();
+    return propagate(board, cell, changesScratch);
+}
+
+void LineScoreTracker::place(const GameBoard &board, const Position &cell, UndoLog &undo) {
+    vector<pair<Position, StoneLine>> &changes = changesScratch;
+    changes.clear();
+    int delta = propagate(board, cell, changes);
+
+    undo.score = score;
+    undo.added = cell;
+    undo.previous.clear();
+    for (const auto &change : changes) {
+        auto it = stones.find(change.first.toPair());
+        if (it != stones.end()) {
+            undo.previous.emplace_back(change.first, it->second);
+            it->second = change.second;
+        } else {
+            stones.emplace(change.first.toPair(), change.second);
+        }
+    }
+    score += delta;
+}
+
+void LineScoreTracker::undo(const UndoLog &undo) {
+    stones.erase(undo.added.toPair());
+    for (const auto &entry : undo.previous) stones[entry.first.toPair()] = entry.second;
+    score = undo.score;
+}
+
+void LineScoreTracker::swapStones(LineScoreTracker &other) {
+    stones.swap(other.stones);
+    swap(score, other.score);
+}
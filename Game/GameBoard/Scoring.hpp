@@ -0,0 +1,80 @@
+#pragma once
+
+#include "GameBoard.hpp"
+#include "../GameStates.hpp"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+
+// Веса событий по порядку RandomEvent; бросок - от 0 до суммы весов
+constexpr array<int, 8> DEFAULT_EVENT_WEIGHTS = {35, 15, 15, 5, 5, 15, 6, 5};
+
+// Базовый счет игрока в режимах SCORING и RANDOM_EVENTS. Камни обходятся по строкам, каждый
+// еще не засчитанный камень засчитывает самую длинную линию через себя, линия длины L дает L * L.
+// Разметка жадная и зависит только от позиции, поэтому счет бота совпадает со счетом партии
+int calculateLineScore(const GameBoard &board, Cell player);
+
+// Итоговый счет RANDOM_EVENTS: штрафы не опускают его ниже нуля
+inline int totalScore(int baseScore, int bonusScore) { return max(0, baseScore + bonusScore); }
+
+// Сколько событие добавляет к бонусному счету сходившего; остальные события меняют поле или очередь
+int eventBonus(RandomEvent event);
+
+// Та же жадная разметка, обновляемая по одному камню. Направление и длина линии камня зависят
+// только от серий через него, а камень засчитывает линию, если его не накрыла линия более раннего
+// засчитавшего камня. Новый камень меняет линии только камней на сериях через себя, дальше
+// изменения идут лишь к тем, кого накрывали их линии. Поэтому изменение счета от хода считается
+// по сериям через клетку за время, не зависящее от размера поля
+class LineScoreTracker {
+    public:
+        // Разметка одного камня: направление и длина самой длинной линии, засчитал ли он ее
+        struct StoneLine {
+            int8_t direction = 0;
+            int16_t length = 0;
+            bool start = false;
+
+            bool operator==(const StoneLine &other) const {
+                return direction == other.direction && length == other.length && start == other.start;
+            }
+        };
+
+        // Все, что нужно для отмены place
+        struct UndoLog {
+            int score = 0;
+            Position added;
+            vector<pair<Position, StoneLine>> previous;
+        };
+
+    private:
+        Cell player;
+        unordered_map<pair<int, int>, StoneLine, PositionHash> stones;
+        int score;
+        // Рабочие буферы propagate: оценка кандидатов идет без выделений памяти
+        mutable vector<Position> pendingScratch;
+        mutable vector<Position> relinedScratch;
+        mutable vector<pair<Position, StoneLine>> changesScratch;
+
+        // Новые разметки затронутых камней, если на клетку встанет камень игрока
+        int propagate(const GameBoard &board, const Position &cell, vector<pair<Position, StoneLine>> &changes) const;
+
+    public:
+        explicit LineScoreTracker(Cell player = Cell::X);
+
+        // Полный пересчет по полю
+        void rebuild(const GameBoard &board);
+        int getScore() const { return score; }
+        Cell getPlayer() const { return player; }
+
+        // Точное изменение счета от камня игрока на пустой клетке; на поле клетка может быть
+        // еще пустой. place запоминает изменения, undo возвращает прежнюю разметку
+        int placeDelta(const GameBoard &board, const Position &cell) const;
+        void place(const GameBoard &board, const Position &cell, UndoLog &undo);
+        void undo(const UndoLog &undo);
+
+        // Смена всех камней: разметки сторон меняются местами, игроки остаются
+        void swapStones(LineScoreTracker &other);
+};
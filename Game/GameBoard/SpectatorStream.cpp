@@ -0,0 +1,126 @@
+#include "SpectatorStream.hpp"
+#include <algorithm>
+
+
+const char* sideToken(Cell side) {
+    return side == Cell::X ? "X" : (side == Cell::O ? "O" : "-");
+}
+
+const char* eventToken(RandomEvent event) {
+    switch (event) {
+        case RandomEvent::SCORE_PLUS_10: return "plus10";
+        case RandomEvent::SCORE_MINUS_10: return "minus10";
+        case RandomEvent::SCORE_PLUS_25: return "plus25";
+        case RandomEvent::SCORE_MINUS_25: return "minus25";
+        case RandomEvent::BONUS_MOVE: return "bonus";
+        case RandomEvent::SWAP_PLAYERS: return "swap";
+        case RandomEvent::CLEAR_AREA: return "clear";
+        default: return "none";
+    }
+}
+
+const char* modeToken(GameMode mode) {
+    switch (mode) {
+        case GameMode::TIMED: return "timed";
+        case GameMode::SCORING: return "scoring";
+        case GameMode::RANDOM_EVENTS: return "events";
+        default: return "classic";
+    }
+}
+
+SpectatorStream::SpectatorStream(uint64_t streamId, const InfiniteTicTacToe &game, size_t keyframeInterval):
+    streamId(streamId), keyframeInterval(max<size_t>(1, keyframeInterval)), lastScore(game.getScore()) {
+    keyframe = encodeKeyframe(game);
+}
+
+StreamFrame SpectatorStream::encodeKeyframe(const InfiniteTicTacToe &game) const {
+    const GameBoard &board = game.getBoard();
+    vector<Position> stones = board.getOccupiedPositions();
+    // Порядок по строкам: одинаковые партии дают одинаковые кадры
+    sort(stones.begin(), stones.end(), [](const Position &a, const Position &b) {
+        return a.y != b.y ? a.y < b.y : a.x < b.x;
+    });
+
+    pair<int, int> score = game.getScore();
+    Cell toMove = game.isGameWon() ? Cell::EMPTY : game.getCurrentPlayer();
+    string text = "KEY " + to_string(streamId) + " " + to_string(game.getMoveHistory().size()) + " " +
+                  modeToken(game.getGameMode()) + " " + to_string(game.getWinningLength()) + " " +
+                  to_string(game.getTargetScore()) + " " + sideToken(toMove) + " " + to_string(score.first) + " " +
+                  to_string(score.second) + " " + to_string(stones.size());
+    text.reserve(text.size() + stones.size() * 10 + 1);
+    for (const Position &stone : stones) {
+        text += " " + to_string(stone.x) + " " + to_string(stone.y) + " " + sideToken(board.get(stone));
+    }
+    text += "\n";
+    return make_shared<const string>(move(text));
+}
+
+void SpectatorStream::publish(const StreamFrame &frame) {
+    for (auto &subscriber : subscribers) subscriber.second(frame);
+}
+
+void SpectatorStream::subscribe(uint64_t subscriber, StreamSink sink) {
+    for (const StreamFrame &frame : catchUp()) sink(frame);
+    subscribers.emplace_back(subscriber, move(sink));
+}
+
+bool SpectatorStream::unsubscribe(uint64_t subscriber) {
+    auto it = find_if(subscribers.begin(), subscribers.end(), [subscriber](const pair<uint64_t, StreamSink> &entry) {
+        return entry.first == subscriber;
+    });
+    if (it == subscribers.end()) return false;
+    subscribers.erase(it);
+    return true;
+}
+
+StreamFrame SpectatorStream::publishTurn(const InfiniteTicTacToe &game) {
+    const TurnDelta *turn = game.getLastTurn();
+    if (!turn) return nullptr;
+
+    Cell toMove = game.isGameWon() ? Cell::EMPTY : game.getCurrentPlayer();
+    string text = "DELTA " + to_string(streamId) + " " + to_string(game.getMoveHistory().size()) + " " +
+                  sideToken(turn->player) + " " + to_string(turn->move.x) + " " + to_string(turn->move.y) + " " +
+                  sideToken(toMove) + " " + eventToken(game.getNextEvent());
+
+    // Событие хода разыгрывается после того, как камень поставлен; победным ходом - нет
+    if (turn->event != RandomEvent::NOTHING) text += string(" event ") + eventToken(turn->event);
+    if (!turn->erased.empty()) {
+        text += " erase " + to_string(turn->erased.size());
+        for (const auto &cell : turn->erased) text += " " + to_string(cell.first.x) + " " + to_string(cell.first.y);
+    }
+    if (turn->swapped) text += " swap";
+
+    pair<int, int> score = game.getScore();
+    if (score != lastScore) {
+        text += " score " + to_string(score.first) + " " + to_string(score.second);
+        lastScore = score;
+    }
+    text += "\n";
+
+    StreamFrame frame = make_shared<const string>(move(text));
+    publish(frame);
+
+    deltas.push_back(frame);
+    if (deltas.size() >= keyframeInterval) {
+        keyframe = encodeKeyframe(game);
+        deltas.clear();
+    }
+    return frame;
+}
+
+StreamFrame SpectatorStream::publishEnd(const InfiniteTicTacToe &game, Cell winner, const char *reason) {
+    string text = "END " + to_string(streamId) + " " + to_string(game.getMoveHistory().size()) + " " +
+                  sideToken(winner) + " " + reason + "\n";
+    ending = make_shared<const string>(move(text));
+    publish(ending);
+    return ending;
+}
+
+vector<StreamFrame> SpectatorStream::catchUp() const {
+    vector<StreamFrame> frames;
+    frames.reserve(deltas.size() + 2);
+    frames.push_back(keyframe);
+    frames.insert(frames.end(), deltas.begin(), deltas.end());
+    if (ending) frames.push_back(ending);
+    return frames;
+}
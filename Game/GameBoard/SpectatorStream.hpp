@@ -0,0 +1,56 @@
+#pragma once
+
+#include "InfiniteTicTacToe.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+
+// Кадр потока: неизменяемый буфер, общий для всех подписчиков, копий на зрителя нет
+using StreamFrame = shared_ptr<const string>;
+using StreamSink = function<void(const StreamFrame &)>;
+
+// Имена сторон и событий в текстовом протоколе
+const char* sideToken(Cell side);
+const char* eventToken(RandomEvent event);
+const char* modeToken(GameMode mode);
+
+// Поток партии для зрителей, по строке на кадр:
+//   KEY id ход режим длина цель очередь счетX счетO камней [x y сторона]...
+//   DELTA id ход сторона x y очередь|- следующее [event E] [erase N [x y]...] [swap] [score X O]
+//   END id ход X|O|- line|score|resign
+// Подписчик получает последний ключевой кадр и дельты после него, дальше - только дельты.
+// Ключевой кадр строится заново каждые keyframeInterval ходов, но рассылается лишь новым
+// подписчикам: догнать партию им стоит не больше keyframeInterval дельт.
+class SpectatorStream {
+    private:
+        uint64_t streamId;
+        size_t keyframeInterval;
+        StreamFrame keyframe;
+        vector<StreamFrame> deltas;
+        StreamFrame ending;
+        vector<pair<uint64_t, StreamSink>> subscribers;
+        pair<int, int> lastScore;
+
+        StreamFrame encodeKeyframe(const InfiniteTicTacToe &game) const;
+        void publish(const StreamFrame &frame);
+
+    public:
+        SpectatorStream(uint64_t streamId, const InfiniteTicTacToe &game, size_t keyframeInterval = 32);
+
+        // Новый подписчик сразу получает кадры, которых хватит, чтобы собрать текущее поле
+        void subscribe(uint64_t subscriber, StreamSink sink);
+        bool unsubscribe(uint64_t subscriber);
+        size_t getSubscriberCount() const { return subscribers.size(); }
+
+        // Вызывается после каждого принятого хода; изменения берутся из последнего хода партии
+        StreamFrame publishTurn(const InfiniteTicTacToe &game);
+        StreamFrame publishEnd(const InfiniteTicTacToe &game, Cell winner, const char *reason);
+
+        // Кадры для догоняющего подписчика: ключевой кадр, дельты после него и итог, если он есть
+        vector<StreamFrame> catchUp() const;
+};
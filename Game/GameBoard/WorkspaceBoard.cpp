@@ -0,0 +1,94 @@
+#include "WorkspaceBoard.hpp"
+#include <climits>
+
+
+WorkspaceBoard::WorkspaceBoard(): cells(STRIDE * STRIDE, (uint8_t)Cell::EMPTY), originX(-STRIDE / 2), originY(-STRIDE / 2),
+    overflow(false) {}
+
+bool WorkspaceBoard::load(const GameBoard &board) {
+    vector<Position> occupied = board.getOccupiedPositions();
+
+    int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+    for (const auto &pos : occupied) {
+        minX = min(minX, pos.x);
+        maxX = max(maxX, pos.x);
+        minY = min(minY, pos.y);
+        maxY = max(maxY, pos.y);
+    }
+    if (occupied.empty()) minX = maxX = minY = maxY = 0;
+    if ((long long)maxX - minX >= SIZE || (long long)maxY - minY >= SIZE) return false;
+
+    // Камни в центре окна: запас для ходов поиска одинаков со всех сторон
+    originX = minX - (SIZE - (maxX - minX + 1)) / 2 - PADDING;
+    originY = minY - (SIZE - (maxY - minY + 1)) / 2 - PADDING;
+    fill(cells.begin(), cells.end(), (uint8_t)Cell::EMPTY);
+    stones[0].clear();
+    stones[1].clear();
+    bits[0] = BitRows();
+    bits[1] = BitRows();
+    overflow = false;
+
+    for (const auto &pos : occupied) set(pos, board.get(pos));
+    return true;
+}
+
+void WorkspaceBoard::set(const Position &pos, Cell cell) {
+    if (cell == Cell::EMPTY) {
+        erase(pos);
+        return;
+    }
+    if (!insideWindow(pos)) {
+        overflow = true;
+        return;
+    }
+
+    uint8_t &slot = cells[indexOf(pos)];
+    if ((Cell)slot == cell) return;
+    if ((Cell)slot != Cell::EMPTY) erase(pos);
+    slot = (uint8_t)cell;
+    stones[cell == Cell::X ? 0 : 1].push_back(pos);
+    bits[cell == Cell::X ? 0 : 1][bitRow(pos)] |= 1ULL << bitColumn(pos);
+}
+
+void WorkspaceBoard::erase(const Position &pos) {
+    if (!insideWindow(pos)) return;
+
+    uint8_t &slot = cells[indexOf(pos)];
+    if ((Cell)slot == Cell::EMPTY) return;
+
+    // Поиск снимает камни в обратном порядке, поэтому камень почти всегда последний в списке
+    int side = (Cell)slot == Cell::X ? 0 : 1;
+    vector<Position> &list = stones[side];
+    for (size_t i = list.size(); i-- > 0;) {
+        if (list[i] == pos) {
+            list[i] = list.back();
+            list.pop_back();
+            break;
+        }
+    }
+    bits[side][bitRow(pos)] &= ~(1ULL << bitColumn(pos));
+    slot = (uint8_t)Cell::EMPTY;
+}
+
+vector<Position> WorkspaceBoard::getOccupiedPositions() const {
+    vector<Position> result;
+    result.reserve(size());
+    result.insert(result.end(), stones[0].begin(), stones[0].end());
+    result.insert(result.end(), stones[1].begin(), stones[1].end());
+    return result;
+}
+
+bool WorkspaceBoard::stoneRows(int margin, int &firstRow, int &lastRow) const {
+    firstRow = BIT_BOARD_ROWS;
+    lastRow = -1;
+    for (int row = BIT_MARGIN; row < BIT_MARGIN + SIZE; row++) {
+        if (!(bits[0][row] | bits[1][row])) continue;
+        firstRow = min(firstRow, row);
+        lastRow = row;
+    }
+    if (lastRow < 0) return false;
+
+    firstRow = max(firstRow - margin, 0);
+    lastRow = min(lastRow + margin, BIT_BOARD_ROWS - 1);
+    return true;
+}
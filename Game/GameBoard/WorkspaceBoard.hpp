@@ -0,0 +1,96 @@
+#pragma once
+
+#include "GameBoard.hpp"
+#include "Core/LineKernels.hpp"
+#include <array>
+#include <cstdint>
+
+using namespace std;
+
+
+// Плотное рабочее поле поиска: окно SIZE x SIZE вокруг камней позиции и пустая рамка PADDING.
+// Клетка - байт плоского массива, линия идет по нему постоянным шагом. Камни встают только в окно,
+// поэтому чтение в пределах PADDING от любого камня не выходит за массив. Ход за окно не
+// записывается, а помечает поле переполненным: такой поиск повторяется на разреженном GameBoard.
+// Те же камни хранятся битовыми строками квадрата 64 x 64 для ядер линий: окно в нем с отступом
+// BIT_MARGIN, поэтому окна линий до BIT_MARGIN + 1 клеток через любой камень целиком в квадрате
+class WorkspaceBoard {
+    public:
+        static constexpr int SIZE = 48;
+        static constexpr int PADDING = 24;
+        static constexpr int STRIDE = SIZE + 2 * PADDING;
+        static constexpr int BIT_MARGIN = (BIT_BOARD_ROWS - SIZE) / 2;
+
+    private:
+        vector<uint8_t> cells;
+        // Камни по игрокам (индекс 0 - крестики) для обхода без сканирования окна
+        array<vector<Position>, 2> stones;
+        array<BitRows, 2> bits;
+        // Абсолютные координаты клетки с индексом 0
+        int originX, originY;
+        bool overflow;
+
+        bool insideWindow(const Position &pos) const {
+            return (unsigned)(pos.x - originX - PADDING) < (unsigned)SIZE && (unsigned)(pos.y - originY - PADDING) < (unsigned)SIZE;
+        }
+
+    public:
+        WorkspaceBoard();
+
+        // Копия поля с камнями в центре окна; false, если камни в окно не помещаются
+        bool load(const GameBoard &board);
+        // Линии через ход читаются на расстоянии до 2 * lineLength от камней
+        static bool supportsLineLength(int lineLength) {
+            return lineLength > 0 && 2 * lineLength <= PADDING && lineLength <= BIT_MARGIN + 1;
+        }
+        bool overflowed() const { return overflow; }
+
+        Cell get(const Position &pos) const {
+            unsigned x = pos.x - originX, y = pos.y - originY;
+            return (x < (unsigned)STRIDE && y < (unsigned)STRIDE) ? (Cell)cells[y * STRIDE + x] : Cell::EMPTY;
+        }
+        void set(const Position &pos, Cell cell);
+        void erase(const Position &pos);
+        size_t size() const { return stones[0].size() + stones[1].size(); }
+
+        vector<Position> getOccupiedPositions() const;
+        const vector<Position>& getOccupiedPositions(Cell cellType) const { return stones[cellType == Cell::X ? 0 : 1]; }
+
+        // Плоский доступ: индекс клетки и шаг по направлению
+        const uint8_t* data() const { return cells.data(); }
+        int indexOf(const Position &pos) const { return (pos.y - originY) * STRIDE + (pos.x - originX); }
+        static constexpr int strideOf(int dx, int dy) { return dy * STRIDE + dx; }
+
+        // Битовые строки: бит x строки y - клетка окна (x - BIT_MARGIN, y - BIT_MARGIN)
+        const BitRows& bitRows(Cell player) const { return bits[player == Cell::X ? 0 : 1]; }
+        int bitColumn(const Position &pos) const { return pos.x - originX - PADDING + BIT_MARGIN; }
+        int bitRow(const Position &pos) const { return pos.y - originY - PADDING + BIT_MARGIN; }
+        // Строки с камнями, расширенные на margin; false, если камней нет
+        bool stoneRows(int margin, int &firstRow, int &lastRow) const;
+};
+
+// Клетки одной линии: view[i] - клетка origin + i * (dx, dy)
+template <typename Board>
+class LineView {
+    private:
+        const Board &board;
+        Position origin;
+        int dx, dy;
+
+    public:
+        LineView(const Board &board, const Position &origin, int dx, int dy): board(board), origin(origin), dx(dx), dy(dy) {}
+        Cell operator[](int i) const { return board.get(Position(origin.x + dx * i, origin.y + dy * i)); }
+};
+
+// На рабочем поле - шаг по массиву без проверок: линия не дальше PADDING от камней окна
+template <>
+class LineView<WorkspaceBoard> {
+    private:
+        const uint8_t *origin;
+        int stride;
+
+    public:
+        LineView(const WorkspaceBoard &board, const Position &origin, int dx, int dy):
+            origin(board.data() + board.indexOf(origin)), stride(WorkspaceBoard::strideOf(dx, dy)) {}
+        Cell operator[](int i) const { return (Cell)origin[stride * i]; }
+};
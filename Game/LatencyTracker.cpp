@@ -0,0 +1,100 @@
+#include "LatencyTracker.hpp"
+#include "GameBoard/Core/Trace.hpp"
+#include <algorithm>
+#include <iomanip>
+
+
+float percentileOf(vector<float> &values, float fraction) {
+    if (values.empty()) return 0;
+    size_t index = min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+LatencyTracker::LatencyTracker(): head(0), count(0), pending(false), current{}, reached(0),
+                                  acceptedClicks(0), droppedClicks(0) {}
+
+LatencyTracker::~LatencyTracker() {
+    if (!log.is_open()) return;
+
+    Summary summary = summarize();
+    log << fixed << setprecision(2)
+        << "summary: clicks " << acceptedClicks << ", dropped " << droppedClicks
+        << ", click-to-photon p50 " << summary.p50 << " p95 " << summary.p95
+        << " p99 " << summary.p99 << " max " << summary.maxMs << " ms" << endl;
+}
+
+bool LatencyTracker::openLog(const string &path) {
+    log.open(path, ios::out | ios::trunc);
+    if (log.is_open()) log << "click, handled ms, snapshot ms, graphics ms, displayed ms" << endl;
+    return log.is_open();
+}
+
+void LatencyTracker::beginClick(chrono::steady_clock::time_point inputTime) {
+    pending = true;
+    clickTime = inputTime;
+    current = Sample{};
+    reached = 0;
+    acceptedClicks++;
+    mark(Mark::HANDLED);
+}
+
+void LatencyTracker::dropClick() {
+    droppedClicks++;
+    if (log.is_open()) log << "dropped click " << droppedClicks << endl;
+}
+
+void LatencyTracker::mark(Mark mark) {
+    size_t index = static_cast<size_t>(mark);
+    if (!pending || index < reached) return;
+    // Перерисовки до прихода снимка с ходом к клику не относятся
+    if (index > static_cast<size_t>(Mark::SNAPSHOT) && reached <= static_cast<size_t>(Mark::SNAPSHOT)) return;
+
+    // Пропущенные отметки (например, графика без изменений поля) равны предыдущей
+    float ms = chrono::duration<float, milli>(chrono::steady_clock::now() - clickTime).count();
+    float previous = reached > 0 ? current[reached - 1] : 0;
+    for (size_t i = reached; i < index; i++) current[i] = previous;
+    current[index] = ms;
+    reached = index + 1;
+
+    if (mark == Mark::DISPLAYED) finishClick();
+}
+
+void LatencyTracker::finishClick() {
+    pending = false;
+    history[head] = current;
+    head = (head + 1) % HISTORY;
+    count = min(count + 1, HISTORY);
+
+    Tracer &tracer = Tracer::instance();
+    if (tracer.isEnabled()) {
+        int64_t durationUs = static_cast<int64_t>(current[MARK_COUNT - 1] * 1000.0f);
+        tracer.record({"clickToPhoton", "input", 'X', tracer.nowUs() - durationUs, durationUs, nullptr, 0});
+    }
+
+    if (log.is_open()) {
+        log << fixed << setprecision(2) << acceptedClicks;
+        for (float ms : current) log << ", " << ms;
+        log << endl;
+    }
+}
+
+LatencyTracker::Summary LatencyTracker::summarize(Mark mark) const {
+    vector<float> values;
+    values.reserve(count);
+    for (size_t i = 0; i < count; i++) values.push_back(history[i][static_cast<size_t>(mark)]);
+    if (values.empty()) return Summary{0, 0, 0, 0, 0};
+
+    float maxMs = *max_element(values.begin(), values.end());
+    float p99 = percentileOf(values, 0.99f);
+    float p95 = percentileOf(values, 0.95f);
+    float p50 = percentileOf(values, 0.50f);
+    return Summary{values.size(), p50, p95, p99, maxMs};
+}
+
+uint64_t LatencyTracker::getDroppedClicks() const { return droppedClicks; }
+
+LatencyTracker::Sample LatencyTracker::lastSample() const {
+    if (count == 0) return Sample{};
+    return history[(head + HISTORY - 1) % HISTORY];
+}
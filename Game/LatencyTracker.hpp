@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+
+// Перцентиль выборки (values переупорядочивается); общий для профилировщика кадров и задержек
+float percentileOf(vector<float> &values, float fraction);
+
+// Задержка от клика до кадра на экране (click-to-photon).
+// Клик проходит отметки: ход отправлен, пришел снимок, пересобрана графика, кадр показан.
+class LatencyTracker {
+    public:
+        enum class Mark { HANDLED, SNAPSHOT, GRAPHICS, DISPLAYED, COUNT };
+        static constexpr size_t MARK_COUNT = static_cast<size_t>(Mark::COUNT);
+        static constexpr size_t HISTORY = 128;
+
+        // Время от клика до каждой отметки, мс
+        using Sample = array<float, MARK_COUNT>;
+
+        struct Summary {
+            size_t samples;
+            float p50, p95, p99, maxMs;
+        };
+
+    private:
+        array<Sample, HISTORY> history;
+        size_t head;
+        size_t count;
+
+        bool pending;
+        chrono::steady_clock::time_point clickTime;
+        Sample current;
+        size_t reached;
+
+        uint64_t acceptedClicks;
+        uint64_t droppedClicks;
+        ofstream log;
+
+        void finishClick();
+
+    public:
+        LatencyTracker();
+        ~LatencyTracker();
+
+        bool openLog(const string &path);
+
+        // inputTime - момент, когда событие было извлечено из очереди окна
+        void beginClick(chrono::steady_clock::time_point inputTime);
+        // Клик отброшен (задержка ввода, не наш ход) и до экрана не дойдет
+        void dropClick();
+        // Отметки ставятся по порядку; DISPLAYED завершает замер, если снимок уже пришел
+        void mark(Mark mark);
+
+        Summary summarize(Mark mark = Mark::DISPLAYED) const;
+        uint64_t getDroppedClicks() const;
+        Sample lastSample() const;
+};
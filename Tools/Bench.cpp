@@ -0,0 +1,452 @@
+#include "../Game/GameBoard/InfiniteTicTacToe.hpp"
+#include "../Game/GameBoard/AI/TicTacToeBot.hpp"
+#include "../Game/GameBoard/AI/MCTSBot.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+
+using namespace std;
+
+
+// Набор микро- и макробенчмарков горячих путей ядра.
+// Использование: bench [--json файл] [--baseline файл] [--threshold %] [--filter подстрока]
+//                      [--seed N] [--min-time мс] [--repeats N]
+// Код возврата: 2 - есть регрессии сверх порога, 1 - ошибка, в том числе базовая линия, с которой нечего сравнить
+
+// Подсчет выделений памяти: заменяем глобальные operator new/delete
+static atomic<uint64_t> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1)) return ptr;
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void *ptr = malloc(size ? size : 1)) return ptr;
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+
+// Результаты складываются сюда, чтобы компилятор не выбросил измеряемый код
+static volatile int64_t benchSink;
+
+
+// Доступ к закрытым методам ядра только для бенчмарков
+struct BenchAccess {
+    static vector<Position> potentialMoves(const TicTacToeBot &bot, const GameBoard &board) {
+        return bot.getPotentialMoves(board);
+    }
+    template <typename Board>
+    static int evaluatePosition(const TicTacToeBot &bot, const Board &board, int lineLength) {
+        return bot.evaluatePosition(board, lineLength);
+    }
+    static void prepareSearch(TicTacToeBot &bot, uint32_t seed) {
+        bot.clearTranspositionTable();
+        bot.rng.seed(seed);
+    }
+
+    static void setBoard(InfiniteTicTacToe &game, const GameBoard &board) {
+        game.board = board;
+        game.winLine.clear();
+        game.lastCheckedPos = Position(INT_MAX, INT_MAX);
+    }
+    static bool checkWin(InfiniteTicTacToe &game, const Position &pos) {
+        game.winLine.clear();
+        game.gameWon = false;
+        return game.checkWin(pos);
+    }
+    static int baseScores(InfiniteTicTacToe &game) {
+        game.calculateBaseScores();
+        return game.playerXBaseScore + game.playerOBaseScore;
+    }
+};
+
+
+struct BenchSettings {
+    string jsonPath = "bench_results.json";
+    string baselinePath;
+    double threshold = 10.0;
+    string filter;
+    uint32_t seed = 12345;
+    double minTimeMs = 200.0;
+    int repeats = 5;
+    int lineLength = 5;
+};
+
+struct BenchResult {
+    string name;
+    double nsPerOp;
+    double allocsPerOp;
+    double nodesPerSec;
+    uint64_t ops;
+};
+
+// Позиции корпуса: камни ставятся рядом с уже стоящими, без готовых линий
+static bool completesLine(const GameBoard &board, const Position &move, Cell player, int lineLength) {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+    for (const auto &dir : directions) {
+        int count = 1;
+        for (int i = 1; board.get(Position(move.x + dir.first * i, move.y + dir.second * i)) == player; i++) count++;
+        for (int i = 1; board.get(Position(move.x - dir.first * i, move.y - dir.second * i)) == player; i++) count++;
+        if (count >= lineLength) return true;
+    }
+    return false;
+}
+
+static vector<GameBoard> makeCorpus(uint32_t seed, int positions, int stones, int lineLength) {
+    mt19937 rng(seed);
+    vector<GameBoard> corpus;
+    corpus.reserve(positions);
+
+    for (int p = 0; p < positions; p++) {
+        GameBoard board;
+        board.set(Position(0, 0), Cell::X);
+        Cell toMove = Cell::O;
+        vector<Position> placed = {Position(0, 0)};
+
+        while ((int)placed.size() < stones) {
+            const Position &base = placed[rng() % placed.size()];
+            Position move(base.x + (int)(rng() % 5) - 2, base.y + (int)(rng() % 5) - 2);
+            if (board.get(move) != Cell::EMPTY) continue;
+            if (completesLine(board, move, toMove, lineLength)) continue;
+
+            board.set(move, toMove);
+            placed.push_back(move);
+            toMove = (toMove == Cell::X) ? Cell::O : Cell::X;
+        }
+        corpus.push_back(board);
+    }
+    return corpus;
+}
+
+// Равномерно заполненный квадрат с заданным числом клеток
+static GameBoard makeDenseBoard(uint32_t seed, int cellCount) {
+    mt19937 rng(seed);
+    GameBoard board;
+    int side = (int)ceil(sqrt((double)cellCount));
+    for (int i = 0; i < cellCount; i++) {
+        board.set(Position(i % side - side / 2, i / side - side / 2), (rng() & 1) ? Cell::X : Cell::O);
+    }
+    return board;
+}
+
+
+class BenchRunner {
+    private:
+        BenchSettings settings;
+        vector<BenchResult> results;
+
+        static double median(vector<double> values) {
+            sort(values.begin(), values.end());
+            return values[values.size() / 2];
+        }
+
+    public:
+        explicit BenchRunner(const BenchSettings &settings): settings(settings) {}
+
+        bool selected(const string &name) const {
+            return settings.filter.empty() || name.find(settings.filter) != string::npos;
+        }
+
+        // body выполняет batch операций и возвращает число пройденных узлов поиска (0, если неприменимо)
+        void run(const string &name, int batch, const function<uint64_t()> &body) {
+            if (!selected(name)) return;
+
+            body();
+
+            vector<double> nsSamples, allocSamples, nodeSamples;
+            uint64_t totalOps = 0;
+            for (int r = 0; r < settings.repeats; r++) {
+                uint64_t ops = 0, nodes = 0;
+                uint64_t allocsBefore = allocationCount.load();
+                auto start = chrono::steady_clock::now();
+                double elapsedNs = 0;
+
+                do {
+                    nodes += body();
+                    ops += batch;
+                    elapsedNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+                } while (elapsedNs < settings.minTimeMs * 1e6);
+
+                nsSamples.push_back(elapsedNs / ops);
+                allocSamples.push_back((double)(allocationCount.load() - allocsBefore) / ops);
+                nodeSamples.push_back(nodes * 1e9 / elapsedNs);
+                totalOps += ops;
+            }
+
+            BenchResult result{name, median(nsSamples), median(allocSamples), median(nodeSamples), totalOps};
+            results.push_back(result);
+
+            printf("%-32s %14.1f ns/op %10.1f alloc/op", name.c_str(), result.nsPerOp, result.allocsPerOp);
+            if (result.nodesPerSec > 0) printf(" %12.0f nodes/s", result.nodesPerSec);
+            printf("\n");
+            fflush(stdout);
+        }
+
+        bool writeJson(const string &path) const {
+            ofstream out(path);
+            if (!out) return false;
+
+            out << "{\n  \"seed\": " << settings.seed << ",\n  \"benchmarks\": [\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                const BenchResult &r = results[i];
+                out << "    {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+                    << ", \"allocs_per_op\": " << r.allocsPerOp << ", \"nodes_per_sec\": " << r.nodesPerSec
+                    << ", \"ops\": " << r.ops << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+            }
+            out << "  ]\n}\n";
+            return (bool)out;
+        }
+
+        // Читает только собственный формат writeJson: пары name / ns_per_op
+        static map<string, double> readBaseline(const string &path) {
+            map<string, double> baseline;
+            ifstream in(path);
+            string line;
+            while (getline(in, line)) {
+                size_t namePos = line.find("\"name\": \"");
+                size_t nsPos = line.find("\"ns_per_op\": ");
+                if (namePos == string::npos || nsPos == string::npos) continue;
+
+                namePos += 9;
+                string name = line.substr(namePos, line.find('"', namePos) - namePos);
+                baseline[name] = strtod(line.c_str() + nsPos + 13, nullptr);
+            }
+            return baseline;
+        }
+
+        // Возвращает число регрессий сверх порога или -1, если сравнивать не с чем:
+        // пустой или нечитаемый файл и базовая линия без общих с прогоном замеров
+        int compareWithBaseline(const string &path) const {
+            map<string, double> baseline = readBaseline(path);
+            if (baseline.empty()) {
+                cerr << "Baseline " << path << " is missing, unreadable or has no results" << endl;
+                return -1;
+            }
+
+            int regressions = 0, compared = 0;
+            printf("\n%-32s %14s %14s %9s\n", "benchmark", "baseline", "current", "change");
+            for (const auto &r : results) {
+                auto it = baseline.find(r.name);
+                if (it == baseline.end() || it->second <= 0) continue;
+                compared++;
+
+                double change = (r.nsPerOp / it->second - 1.0) * 100.0;
+                bool regressed = change > settings.threshold;
+                if (regressed) regressions++;
+                printf("%-32s %14.1f %14.1f %+8.1f%%%s\n", r.name.c_str(), it->second, r.nsPerOp, change,
+                       regressed ? "  REGRESSION" : "");
+            }
+            if (compared == 0) {
+                cerr << "No benchmark matched an entry of baseline " << path << endl;
+                return -1;
+            }
+            return regressions;
+        }
+};
+
+
+static void benchBoard(BenchRunner &runner, const BenchSettings &settings) {
+    for (int cells : {64, 1024, 16384}) {
+        GameBoard board = makeDenseBoard(settings.seed, cells);
+        int side = (int)ceil(sqrt((double)cells));
+
+        // Половина запросов попадает в занятые клетки, половина мимо
+        mt19937 rng(settings.seed + cells);
+        vector<Position> probes(4096);
+        for (auto &probe : probes) probe = Position((int)(rng() % (2 * side)) - side, (int)(rng() % (2 * side)) - side);
+
+        runner.run("board_get/" + to_string(cells), (int)probes.size(), [&]() -> uint64_t {
+            int found = 0;
+            for (const auto &probe : probes) found += board.get(probe) != Cell::EMPTY;
+            benchSink = found;
+            return 0;
+        });
+
+        runner.run("board_set/" + to_string(cells), (int)probes.size(), [&]() -> uint64_t {
+            for (const auto &probe : probes) {
+                if (board.get(probe) != Cell::EMPTY) continue;
+                board.set(probe, Cell::X);
+                board.erase(probe);
+            }
+            return 0;
+        });
+    }
+}
+
+static void benchEvaluation(BenchRunner &runner, const BenchSettings &settings, const vector<GameBoard> &corpus) {
+    for (BotDifficulty diff : {BotDifficulty::EASY, BotDifficulty::HARD}) {
+        TicTacToeBot bot(diff, Cell::O);
+        string suffix = (diff == BotDifficulty::EASY) ? "easy" : "hard";
+
+        runner.run("getPotentialMoves/" + suffix, (int)corpus.size(), [&]() -> uint64_t {
+            size_t total = 0;
+            for (const auto &board : corpus) total += BenchAccess::potentialMoves(bot, board).size();
+            benchSink = (int64_t)total;
+            return 0;
+        });
+    }
+
+    TicTacToeBot bot(BotDifficulty::HARD, Cell::O);
+    runner.run("evaluatePosition", (int)corpus.size(), [&]() -> uint64_t {
+        int total = 0;
+        for (const auto &board : corpus) total += BenchAccess::evaluatePosition(bot, board, settings.lineLength);
+        benchSink = total;
+        return 0;
+    });
+
+    // Та же оценка на плотном рабочем поле поиска
+    vector<WorkspaceBoard> workspaces(corpus.size());
+    for (size_t i = 0; i < corpus.size(); i++) workspaces[i].load(corpus[i]);
+    runner.run("evaluatePosition/workspace", (int)workspaces.size(), [&]() -> uint64_t {
+        int total = 0;
+        for (const auto &board : workspaces) total += BenchAccess::evaluatePosition(bot, board, settings.lineLength);
+        benchSink = total;
+        return 0;
+    });
+}
+
+// Крупные позиции: разреженное поле против битовых ядер рабочего поля с каждым доступным набором инструкций
+static void benchKernels(BenchRunner &runner, const BenchSettings &settings, const vector<GameBoard> &corpus) {
+    TicTacToeBot bot(BotDifficulty::HARD, Cell::O);
+    runner.run("evaluatePosition/large", (int)corpus.size(), [&]() -> uint64_t {
+        int total = 0;
+        for (const auto &board : corpus) total += BenchAccess::evaluatePosition(bot, board, settings.lineLength);
+        benchSink = total;
+        return 0;
+    });
+
+    vector<WorkspaceBoard> workspaces(corpus.size());
+    for (size_t i = 0; i < corpus.size(); i++) workspaces[i].load(corpus[i]);
+    KernelIsa detected = getKernelIsa();
+    for (KernelIsa isa : {KernelIsa::SCALAR, KernelIsa::AVX2}) {
+        setKernelIsa(isa);
+        if (getKernelIsa() != isa) continue;
+
+        runner.run(string("evaluatePosition/large-") + kernelIsaName(isa), (int)workspaces.size(), [&]() -> uint64_t {
+            int total = 0;
+            for (const auto &board : workspaces) total += BenchAccess::evaluatePosition(bot, board, settings.lineLength);
+            benchSink = total;
+            return 0;
+        });
+    }
+    setKernelIsa(detected);
+}
+
+static void benchRules(BenchRunner &runner, const BenchSettings &settings, const vector<GameBoard> &corpus) {
+    InfiniteTicTacToe game(GameMode::SCORING, settings.lineLength, INT_MAX);
+
+    vector<vector<Position>> stones;
+    for (const auto &board : corpus) stones.push_back(board.getOccupiedPositions());
+    size_t stoneCount = 0;
+    for (const auto &list : stones) stoneCount += list.size();
+
+    runner.run("checkWin", (int)stoneCount, [&]() -> uint64_t {
+        for (size_t i = 0; i < corpus.size(); i++) {
+            BenchAccess::setBoard(game, corpus[i]);
+            for (const auto &pos : stones[i]) BenchAccess::checkWin(game, pos);
+        }
+        return 0;
+    });
+
+    runner.run("calculateBaseScores", (int)corpus.size(), [&]() -> uint64_t {
+        int total = 0;
+        for (const auto &board : corpus) {
+            BenchAccess::setBoard(game, board);
+            total += BenchAccess::baseScores(game);
+        }
+        benchSink = total;
+        return 0;
+    });
+}
+
+static void benchSearch(BenchRunner &runner, const BenchSettings &settings, const vector<GameBoard> &corpus) {
+    const pair<BotDifficulty, const char*> difficulties[] = {
+        {BotDifficulty::EASY, "easy"}, {BotDifficulty::MEDIUM, "medium"}, {BotDifficulty::HARD, "hard"}
+    };
+
+    for (const auto &[diff, label] : difficulties) {
+        TicTacToeBot bot(diff, Cell::X);
+        runner.run(string("getBestMove/") + label, (int)corpus.size(), [&, diff = diff]() -> uint64_t {
+            uint64_t nodes = 0;
+            for (size_t i = 0; i < corpus.size(); i++) {
+                Cell toMove = (corpus[i].size() % 2 == 0) ? Cell::X : Cell::O;
+                bot.setSymbol(toMove);
+                BenchAccess::prepareSearch(bot, settings.seed + (uint32_t)i);
+                bot.getBestMove(corpus[i], settings.lineLength);
+                nodes += bot.getSearchStats().nodes;
+            }
+            return nodes;
+        });
+    }
+
+    // MCTS ограничен по времени, поэтому сравнивать имеет смысл nodes/s (итерации), а не ns/op
+    runner.run("getBestMove/expert", 1, [&]() -> uint64_t {
+        uint64_t nodes = 0;
+        const GameBoard &board = corpus[0];
+        MCTSBot bot(BotDifficulty::EXPERT, (board.size() % 2 == 0) ? Cell::X : Cell::O);
+        bot.setThreadCount(1);
+        bot.setTimeBudget(chrono::milliseconds(100));
+        bot.getBestMove(board, settings.lineLength);
+        nodes += bot.getSearchStats().nodes;
+        return nodes;
+    });
+}
+
+int main(int argc, char *argv[]) {
+    BenchSettings settings;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--json" && hasValue) settings.jsonPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) settings.baselinePath = argv[++i];
+        else if (arg == "--threshold" && hasValue) settings.threshold = atof(argv[++i]);
+        else if (arg == "--filter" && hasValue) settings.filter = argv[++i];
+        else if (arg == "--seed" && hasValue) settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--min-time" && hasValue) settings.minTimeMs = atof(argv[++i]);
+        else if (arg == "--repeats" && hasValue) settings.repeats = max(1, atoi(argv[++i]));
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    vector<GameBoard> smallCorpus = makeCorpus(settings.seed, 64, 12, settings.lineLength);
+    vector<GameBoard> largeCorpus = makeCorpus(settings.seed + 1, 16, 60, settings.lineLength);
+    vector<GameBoard> searchCorpus = makeCorpus(settings.seed + 2, 8, 16, settings.lineLength);
+
+    BenchRunner runner(settings);
+    benchBoard(runner, settings);
+    benchEvaluation(runner, settings, smallCorpus);
+    benchKernels(runner, settings, largeCorpus);
+    benchRules(runner, settings, largeCorpus);
+    benchSearch(runner, settings, searchCorpus);
+
+    if (!runner.writeJson(settings.jsonPath)) {
+        cerr << "Failed to write " << settings.jsonPath << endl;
+        return 1;
+    }
+
+    if (!settings.baselinePath.empty()) {
+        int regressions = runner.compareWithBaseline(settings.baselinePath);
+        if (regressions < 0) return 1;
+        if (regressions > 0) {
+            cerr << regressions << " benchmark(s) regressed by more than " << settings.threshold << "%" << endl;
+            return 2;
+        }
+    }
+    return 0;
+}
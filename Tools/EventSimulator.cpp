@@ -0,0 +1,500 @@
+#include "../Game/GameBoard/InfiniteTicTacToe.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+
+// Пакетная симуляция партий RANDOM_EVENTS и SCORING для подбора баланса, без SFML.
+// Использование: simulate [--mode events|scoring|both] [--games N] [--threads N] [--seed N]
+//                         [--x ПОЛИТИКА] [--o ПОЛИТИКА] [--length N] [--target N] [--max-moves N]
+//                         [--weights nothing,+10,-10,+25,-25,bonus,swap,clear] [--opening-plies N]
+//                         [--step N] [--json файл]
+// ПОЛИТИКА: random | greedy | bot[:easy|medium|hard|expert]
+// Первые opening-plies ходов случайные для всех политик, иначе жадные партии совпадали бы.
+// Зерно партии выводится из seed и ее номера, поэтому для random и greedy итоги не зависят от числа
+// потоков. Политики bot:* так не воспроизводятся: боты берут зерно от часов, средние и сильные уровни
+// ограничены временем, а бот потока хранит таблицы между партиями. Заодно это бенчмарк правил:
+// на ход приходится полный пересчет счета в InfiniteTicTacToe.
+
+enum class PolicyKind { RANDOM, GREEDY, BOT };
+
+struct PolicySpec {
+    string text = "greedy";
+    PolicyKind kind = PolicyKind::GREEDY;
+    BotDifficulty difficulty = BotDifficulty::MEDIUM;
+};
+
+struct SimulationSettings {
+    vector<GameMode> modes = {GameMode::RANDOM_EVENTS};
+    uint64_t games = 10000;
+    int threads = 0;
+    uint32_t seed = 1;
+    PolicySpec x, o;
+    int lineLength = 5;
+    int targetScore = 100;
+    int maxMoves = 400;
+    int openingPlies = 4;
+    int step = 10;
+    array<int, 8> weights = DEFAULT_EVENT_WEIGHTS;
+    string jsonPath;
+};
+
+// Итоги одного потока; после симуляции складываются в общий
+struct SimulationStats {
+    uint64_t games = 0;
+    uint64_t xWins = 0, oWins = 0, unfinished = 0;
+    uint64_t byScore = 0, byLine = 0;
+    uint64_t moves = 0;
+    array<uint64_t, 8> events = {};
+    // Длина партии: гистограмма по числу ходов
+    vector<uint64_t> lengths;
+    // Отрыв победителя по очкам в конце партии
+    vector<int> margins;
+    // Траектории по номеру хода: партий в игре, суммы счета X, O, разности и ее квадрата
+    vector<uint64_t> alive;
+    vector<double> sumX, sumO, sumDiff, sumDiffSquared;
+
+    explicit SimulationStats(int maxMoves):
+        lengths(maxMoves + 1), alive(maxMoves + 1), sumX(maxMoves + 1), sumO(maxMoves + 1),
+        sumDiff(maxMoves + 1), sumDiffSquared(maxMoves + 1) {}
+
+    void merge(const SimulationStats &other) {
+        games += other.games;
+        xWins += other.xWins;
+        oWins += other.oWins;
+        unfinished += other.unfinished;
+        byScore += other.byScore;
+        byLine += other.byLine;
+        moves += other.moves;
+        for (size_t i = 0; i < events.size(); i++) events[i] += other.events[i];
+        margins.insert(margins.end(), other.margins.begin(), other.margins.end());
+        for (size_t i = 0; i < lengths.size(); i++) {
+            lengths[i] += other.lengths[i];
+            alive[i] += other.alive[i];
+            sumX[i] += other.sumX[i];
+            sumO[i] += other.sumO[i];
+            sumDiff[i] += other.sumDiff[i];
+            sumDiffSquared[i] += other.sumDiffSquared[i];
+        }
+    }
+};
+
+static const char* const EVENT_NAMES[8] = {"nothing", "+10", "-10", "+25", "-25", "bonus", "swap", "clear"};
+
+static bool parseDifficulty(const string &name, BotDifficulty &difficulty) {
+    if (name == "easy") difficulty = BotDifficulty::EASY;
+    else if (name == "medium") difficulty = BotDifficulty::MEDIUM;
+    else if (name == "hard") difficulty = BotDifficulty::HARD;
+    else if (name == "expert") difficulty = BotDifficulty::EXPERT;
+    else return false;
+    return true;
+}
+
+static bool parsePolicy(const string &text, PolicySpec &policy) {
+    policy.text = text;
+    if (text == "random") policy.kind = PolicyKind::RANDOM;
+    else if (text == "greedy") policy.kind = PolicyKind::GREEDY;
+    else if (text == "bot") policy.kind = PolicyKind::BOT;
+    else if (text.rfind("bot:", 0) == 0) {
+        policy.kind = PolicyKind::BOT;
+        return parseDifficulty(text.substr(4), policy.difficulty);
+    } else return false;
+    return true;
+}
+
+static bool parseWeights(const string &text, array<int, 8> &weights) {
+    stringstream stream(text);
+    string item;
+    size_t count = 0;
+    while (getline(stream, item, ',')) {
+        if (count == weights.size()) return false;
+        weights[count++] = atoi(item.c_str());
+    }
+    int total = 0;
+    for (int weight : weights) {
+        if (weight < 0) return false;
+        total += weight;
+    }
+    return count == weights.size() && total > 0;
+}
+
+// Соседние зерна дают у minstd_rand похожие первые броски: перемешиваем splitmix64
+static uint64_t mixSeed(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static const char* modeName(GameMode mode) {
+    return mode == GameMode::SCORING ? "scoring" : "events";
+}
+
+// Ходы политик. Политика видит только поле и историю, как и игрок
+class PolicyPlayer {
+    private:
+        const SimulationSettings &settings;
+        minstd_rand rng;
+        unique_ptr<BotEngine> bots[2];
+
+        static int runLength(const GameBoard &board, const Position &cell, int dx, int dy, Cell player);
+        bool findEmptyNear(const InfiniteTicTacToe &game, Position &move);
+        Position randomMove(const InfiniteTicTacToe &game);
+        Position greedyMove(const InfiniteTicTacToe &game);
+
+    public:
+        explicit PolicyPlayer(const SimulationSettings &settings): settings(settings) {}
+        void seed(uint32_t value) { rng.seed(value); }
+        Position chooseMove(const InfiniteTicTacToe &game, bool opening);
+};
+
+int PolicyPlayer::runLength(const GameBoard &board, const Position &cell, int dx, int dy, Cell player) {
+    int length = 0;
+    for (Position current(cell.x + dx, cell.y + dy); board.get(current) == player; current = Position(current.x + dx, current.y + dy)) {
+        length++;
+    }
+    return length;
+}
+
+// Случайная свободная клетка рядом со случайным ходом из истории
+bool PolicyPlayer::findEmptyNear(const InfiniteTicTacToe &game, Position &move) {
+    const vector<Position> &history = game.getMoveHistory();
+    const GameBoard &board = game.getBoard();
+    if (history.empty()) {
+        move = Position(0, 0);
+        return true;
+    }
+
+    uniform_int_distribution<size_t> pick(0, history.size() - 1);
+    uniform_int_distribution<int> offset(-2, 2);
+    for (int attempt = 0; attempt < 32; attempt++) {
+        const Position &base = history[pick(rng)];
+        move = Position(base.x + offset(rng), base.y + offset(rng));
+        if (board.get(move) == Cell::EMPTY) return true;
+    }
+    return false;
+}
+
+Position PolicyPlayer::randomMove(const InfiniteTicTacToe &game) {
+    Position move;
+    if (findEmptyNear(game, move)) return move;
+
+    // Окрестность истории занята: спираль от последнего хода
+    const GameBoard &board = game.getBoard();
+    Position center = game.getMoveHistory().back();
+    for (int radius = 1;; radius++) {
+        for (int dy = -radius; dy <= radius; dy++) {
+            for (int dx = -radius; dx <= radius; dx++) {
+                Position cell(center.x + dx, center.y + dy);
+                if (board.get(cell) == Cell::EMPTY) return cell;
+            }
+        }
+    }
+}
+
+// Жадно: самая длинная своя линия через клетку, вдвое дешевле - самая длинная чужая.
+// Кандидаты - соседи последних ходов, их мало, и ход остается дешевым
+Position PolicyPlayer::greedyMove(const InfiniteTicTacToe &game) {
+    constexpr int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+    const vector<Position> &history = game.getMoveHistory();
+    const GameBoard &board = game.getBoard();
+    if (history.empty()) return Position(0, 0);
+
+    Cell own = game.getCurrentPlayer();
+    Cell opponent = own == Cell::X ? Cell::O : Cell::X;
+    Position best = history.back();
+    int bestValue = -1;
+    int ties = 0;
+
+    size_t first = history.size() > 12 ? history.size() - 12 : 0;
+    for (size_t i = first; i < history.size(); i++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                Position cell(history[i].x + dx, history[i].y + dy);
+                if (board.get(cell) != Cell::EMPTY) continue;
+
+                int ownLine = 0, opponentLine = 0;
+                for (const auto &direction : directions) {
+                    int ddx = direction[0], ddy = direction[1];
+                    ownLine = max(ownLine, 1 + runLength(board, cell, ddx, ddy, own) + runLength(board, cell, -ddx, -ddy, own));
+                    opponentLine = max(opponentLine, 1 + runLength(board, cell, ddx, ddy, opponent) +
+                                                     runLength(board, cell, -ddx, -ddy, opponent));
+                }
+                int value = 2 * ownLine * ownLine + opponentLine * opponentLine;
+                if (value > bestValue) {
+                    bestValue = value;
+                    best = cell;
+                    ties = 1;
+                } else if (value == bestValue && uniform_int_distribution<int>(0, ties++)(rng) == 0) {
+                    best = cell;
+                }
+            }
+        }
+    }
+    if (bestValue < 0) return randomMove(game);
+    return best;
+}
+
+Position PolicyPlayer::chooseMove(const InfiniteTicTacToe &game, bool opening) {
+    if (opening) return randomMove(game);
+    Cell side = game.getCurrentPlayer();
+    const PolicySpec &policy = side == Cell::X ? settings.x : settings.o;
+    switch (policy.kind) {
+        case PolicyKind::RANDOM:
+            return randomMove(game);
+        case PolicyKind::GREEDY:
+            return greedyMove(game);
+        case PolicyKind::BOT: {
+            // Бот на сторону: символ задается при создании, setSymbol очищал бы таблицы каждый ход
+            unique_ptr<BotEngine> &bot = bots[side == Cell::X ? 0 : 1];
+            if (!bot) bot = createBot(policy.difficulty, side, game.getGameMode());
+            bot->setContext(game.getBotContext());
+            return bot->getBestMove(game.getBoard(), settings.lineLength);
+        }
+    }
+    return randomMove(game);
+}
+
+static void playGame(InfiniteTicTacToe &game, PolicyPlayer &player, uint64_t seed, const SimulationSettings &settings,
+                     SimulationStats &stats) {
+    game.reset();
+    game.seedEvents((uint32_t)seed);
+    player.seed((uint32_t)(seed >> 32));
+
+    int moves = 0;
+    while (!game.isGameWon() && moves < settings.maxMoves) {
+        Cell side = game.getCurrentPlayer();
+        size_t before = game.getMoveHistory().size();
+        game.makeMove(player.chooseMove(game, moves < settings.openingPlies));
+        // Политика не должна ходить в занятую клетку; на всякий случай не зацикливаемся
+        if (game.getMoveHistory().size() == before) break;
+
+        moves++;
+        // Событие бросается при передаче хода; после бонусного хода и победы броска нет
+        if (game.getGameMode() == GameMode::RANDOM_EVENTS && !game.isGameWon() && game.getCurrentPlayer() != side) {
+            stats.events[(int)game.getNextEvent()]++;
+        }
+        pair<int, int> score = game.getScore();
+        double diff = score.first - score.second;
+        stats.alive[moves]++;
+        stats.sumX[moves] += score.first;
+        stats.sumO[moves] += score.second;
+        stats.sumDiff[moves] += diff;
+        stats.sumDiffSquared[moves] += diff * diff;
+    }
+
+    stats.games++;
+    stats.moves += moves;
+    stats.lengths[moves]++;
+    if (!game.isGameWon()) {
+        stats.unfinished++;
+        return;
+    }
+
+    Cell winner = game.getWinner();
+    pair<int, int> score = game.getScore();
+    if (winner == Cell::X) stats.xWins++;
+    else stats.oWins++;
+    if (game.isGameEndedByScore()) stats.byScore++;
+    else stats.byLine++;
+    stats.margins.push_back(winner == Cell::X ? score.first - score.second : score.second - score.first);
+}
+
+static uint64_t lengthPercentile(const SimulationStats &stats, double fraction) {
+    uint64_t target = (uint64_t)ceil(fraction * stats.games), seen = 0;
+    for (size_t length = 0; length < stats.lengths.size(); length++) {
+        seen += stats.lengths[length];
+        if (seen >= target && seen > 0) return length;
+    }
+    return stats.lengths.size() - 1;
+}
+
+static int marginPercentile(vector<int> &margins, double fraction) {
+    if (margins.empty()) return 0;
+    size_t index = min(margins.size() - 1, (size_t)(fraction * (margins.size() - 1) + 0.5));
+    nth_element(margins.begin(), margins.begin() + index, margins.end());
+    return margins[index];
+}
+
+static void printReport(GameMode mode, const SimulationSettings &settings, SimulationStats &stats, double seconds) {
+    double games = max<uint64_t>(1, stats.games);
+    double xRate = stats.xWins / games;
+    // 95% интервал доли побед X
+    double margin95 = 1.96 * sqrt(xRate * (1 - xRate) / games);
+
+    cout << fixed << setprecision(1);
+    cout << "\n== " << modeName(mode) << ": X " << settings.x.text << " vs O " << settings.o.text << ", length "
+         << settings.lineLength << ", target " << settings.targetScore << "\n";
+    cout << "Games " << stats.games << " in " << setprecision(2) << seconds << " s: " << setprecision(0) << stats.games / seconds
+         << " games/s, " << stats.moves / seconds << " moves/s\n";
+    cout << setprecision(1) << "Winners: X " << 100 * xRate << "% (+-" << 100 * margin95 << "), O " << 100 * stats.oWins / games
+         << "%, unfinished " << 100 * stats.unfinished / games << "%; by score " << 100 * stats.byScore / games
+         << "%, by line " << 100 * stats.byLine / games << "%\n";
+    cout << "Length: mean " << stats.moves / games << ", p10 " << lengthPercentile(stats, 0.1) << ", p50 "
+         << lengthPercentile(stats, 0.5) << ", p90 " << lengthPercentile(stats, 0.9) << ", p99 " << lengthPercentile(stats, 0.99) << "\n";
+
+    double marginSum = 0;
+    for (int value : stats.margins) marginSum += value;
+    cout << "Winner margin: mean " << marginSum / max<size_t>(1, stats.margins.size()) << ", p10 "
+         << marginPercentile(stats.margins, 0.1) << ", p50 " << marginPercentile(stats.margins, 0.5) << ", p90 "
+         << marginPercentile(stats.margins, 0.9) << "\n";
+
+    if (mode == GameMode::RANDOM_EVENTS) {
+        uint64_t totalEvents = 0;
+        for (uint64_t count : stats.events) totalEvents += count;
+        cout << "Events rolled:";
+        for (size_t i = 0; i < stats.events.size(); i++) {
+            cout << " " << EVENT_NAMES[i] << " " << 100.0 * stats.events[i] / max<uint64_t>(1, totalEvents) << "%";
+        }
+        cout << "\n";
+    }
+
+    cout << "Trajectory: move  alive%  meanX  meanO  mean(X-O)  sd(X-O)\n";
+    for (int move = settings.step; move <= settings.maxMoves; move += settings.step) {
+        if (stats.alive[move] == 0) break;
+        double alive = stats.alive[move];
+        double meanDiff = stats.sumDiff[move] / alive;
+        double sd = sqrt(max(0.0, stats.sumDiffSquared[move] / alive - meanDiff * meanDiff));
+        cout << setw(16) << move << setw(8) << 100 * alive / games << setw(7) << stats.sumX[move] / alive
+             << setw(7) << stats.sumO[move] / alive << setw(11) << meanDiff << setw(9) << sd << "\n";
+    }
+}
+
+static void writeJsonMode(ostream &out, GameMode mode, const SimulationSettings &settings, SimulationStats &stats, double seconds) {
+    out << "    {\"mode\": \"" << modeName(mode) << "\", \"games\": " << stats.games << ", \"seconds\": " << seconds
+        << ", \"x_wins\": " << stats.xWins << ", \"o_wins\": " << stats.oWins << ", \"unfinished\": " << stats.unfinished
+        << ", \"by_score\": " << stats.byScore << ", \"by_line\": " << stats.byLine << ",\n";
+
+    out << "     \"events\": [";
+    for (size_t i = 0; i < stats.events.size(); i++) out << (i ? ", " : "") << stats.events[i];
+    out << "],\n     \"length_histogram\": [";
+    for (size_t i = 0; i < stats.lengths.size(); i++) out << (i ? ", " : "") << stats.lengths[i];
+
+    // Отрыв - гистограмма по 5 очков, отрицательный отрыв бывает после штрафных событий
+    map<int, uint64_t> marginBins;
+    for (int value : stats.margins) marginBins[(int)floor(value / 5.0) * 5]++;
+    out << "],\n     \"margin_histogram\": {";
+    bool firstBin = true;
+    for (auto &[bin, count] : marginBins) {
+        out << (firstBin ? "" : ", ") << "\"" << bin << "\": " << count;
+        firstBin = false;
+    }
+
+    out << "},\n     \"trajectory\": [";
+    bool firstPoint = true;
+    for (int move = 1; move <= settings.maxMoves && stats.alive[move] > 0; move++) {
+        double alive = stats.alive[move];
+        double meanDiff = stats.sumDiff[move] / alive;
+        out << (firstPoint ? "" : ",") << "\n       {\"move\": " << move << ", \"alive\": " << stats.alive[move]
+            << ", \"mean_x\": " << stats.sumX[move] / alive << ", \"mean_o\": " << stats.sumO[move] / alive
+            << ", \"mean_diff\": " << meanDiff << ", \"sd_diff\": "
+            << sqrt(max(0.0, stats.sumDiffSquared[move] / alive - meanDiff * meanDiff)) << "}";
+        firstPoint = false;
+    }
+    out << "]}";
+}
+
+int main(int argc, char *argv[]) {
+    SimulationSettings settings;
+    settings.x.text = settings.o.text = "greedy";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--mode" && hasValue) {
+            string mode = argv[++i];
+            if (mode == "events") settings.modes = {GameMode::RANDOM_EVENTS};
+            else if (mode == "scoring") settings.modes = {GameMode::SCORING};
+            else if (mode == "both") settings.modes = {GameMode::RANDOM_EVENTS, GameMode::SCORING};
+            else {
+                cerr << "Unknown mode: " << mode << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--games" && hasValue) settings.games = max(1ULL, strtoull(argv[++i], nullptr, 10));
+        else if (arg == "--threads" && hasValue) settings.threads = max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--length" && hasValue) settings.lineLength = max(3, atoi(argv[++i]));
+        else if (arg == "--target" && hasValue) settings.targetScore = max(1, atoi(argv[++i]));
+        else if (arg == "--max-moves" && hasValue) settings.maxMoves = max(1, atoi(argv[++i]));
+        else if (arg == "--opening-plies" && hasValue) settings.openingPlies = max(0, atoi(argv[++i]));
+        else if (arg == "--step" && hasValue) settings.step = max(1, atoi(argv[++i]));
+        else if (arg == "--json" && hasValue) settings.jsonPath = argv[++i];
+        else if ((arg == "--x" || arg == "--o") && hasValue) {
+            if (!parsePolicy(argv[++i], arg == "--x" ? settings.x : settings.o)) {
+                cerr << "Bad policy " << argv[i] << ", expected random|greedy|bot[:level]" << endl;
+                return 1;
+            }
+        }
+        else if (arg == "--weights" && hasValue) {
+            if (!parseWeights(argv[++i], settings.weights)) {
+                cerr << "Expected 8 non-negative weights: nothing,+10,-10,+25,-25,bonus,swap,clear" << endl;
+                return 1;
+            }
+        }
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    int threadCount = settings.threads > 0 ? settings.threads : max(1u, thread::hardware_concurrency());
+    ofstream json;
+    if (!settings.jsonPath.empty()) {
+        json.open(settings.jsonPath);
+        if (!json) {
+            cerr << "Failed to write " << settings.jsonPath << endl;
+            return 1;
+        }
+        json << "{\n  \"seed\": " << settings.seed << ", \"x\": \"" << settings.x.text << "\", \"o\": \"" << settings.o.text
+             << "\", \"length\": " << settings.lineLength << ", \"target\": " << settings.targetScore << ", \"weights\": [";
+        for (size_t i = 0; i < settings.weights.size(); i++) json << (i ? ", " : "") << settings.weights[i];
+        json << "],\n  \"modes\": [\n";
+    }
+
+    for (size_t modeIndex = 0; modeIndex < settings.modes.size(); modeIndex++) {
+        GameMode mode = settings.modes[modeIndex];
+        vector<SimulationStats> threadStats(threadCount, SimulationStats(settings.maxMoves));
+        atomic<uint64_t> nextGame(0);
+        const uint64_t chunk = 64;
+
+        auto worker = [&](int index) {
+            // Один объект партии на поток: reset() дешевле, чем новая партия с нуля
+            InfiniteTicTacToe game(mode, settings.lineLength, settings.targetScore);
+            game.setEventWeights(settings.weights);
+            PolicyPlayer player(settings);
+            for (uint64_t start = nextGame.fetch_add(chunk); start < settings.games; start = nextGame.fetch_add(chunk)) {
+                uint64_t end = min(settings.games, start + chunk);
+                for (uint64_t gameIndex = start; gameIndex < end; gameIndex++) {
+                    playGame(game, player, mixSeed(((uint64_t)settings.seed << 32) + gameIndex), settings, threadStats[index]);
+                }
+            }
+        };
+
+        auto started = chrono::steady_clock::now();
+        vector<thread> threads;
+        for (int i = 0; i < threadCount; i++) threads.emplace_back(worker, i);
+        for (auto &t : threads) t.join();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+        SimulationStats total(settings.maxMoves);
+        for (auto &stats : threadStats) total.merge(stats);
+        printReport(mode, settings, total, seconds);
+        if (json.is_open()) {
+            writeJsonMode(json, mode, settings, total, seconds);
+            json << (modeIndex + 1 < settings.modes.size() ? ",\n" : "\n");
+        }
+    }
+
+    if (json.is_open()) json << "  ]\n}\n";
+    return 0;
+}
@@ -0,0 +1,234 @@
+#include "../Game/GameBoard/AI/TicTacToeBot.hpp"
+#include "../Game/GameBoard/AI/OpeningBook.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+
+// Движок для оболочек Gomocup/piskvork: построчный протокол через stdin/stdout.
+// Использование: pbrain-tictactoe [--level easy|medium|hard] [--length N] [--book файл]
+// Поле протокола - квадрат size x size с началом в углу; внутри бота центр поля совпадает с (0, 0).
+
+struct EngineSettings {
+    BotDifficulty difficulty = BotDifficulty::HARD;
+    int lineLength = 5;
+    string bookPath;
+};
+
+class GomocupEngine {
+    private:
+        EngineSettings settings;
+        unique_ptr<TicTacToeBot> bot;
+        GameBoard board;
+        int width, height;
+
+        // Ограничения времени из INFO, мс; 0 - не задано
+        long long timeoutTurn;
+        long long timeoutMatch;
+        long long timeLeft;
+
+        // Свои камни - крестики, камни соперника - нолики, кто бы ни ходил первым
+        static constexpr Cell OWN = Cell::X;
+        static constexpr Cell OPPONENT = Cell::O;
+
+        Position toInternal(int x, int y) const { return Position(x - width / 2, y - height / 2); }
+        int toProtocolX(const Position &pos) const { return pos.x + width / 2; }
+        int toProtocolY(const Position &pos) const { return pos.y + height / 2; }
+
+        bool parseMove(const string &text, Position &move) const;
+        bool isInside(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
+        void newGame(int newWidth, int newHeight);
+        chrono::milliseconds moveBudget() const;
+        void think();
+        void handleInfo(const string &key, const string &value);
+        void readBoard();
+
+    public:
+        explicit GomocupEngine(const EngineSettings &settings);
+        void run();
+};
+
+GomocupEngine::GomocupEngine(const EngineSettings &settings):
+    settings(settings), width(0), height(0), timeoutTurn(0), timeoutMatch(0), timeLeft(0) {}
+
+bool GomocupEngine::parseMove(const string &text, Position &move) const {
+    int x, y;
+    if (sscanf(text.c_str(), "%d,%d", &x, &y) != 2 || !isInside(x, y)) return false;
+    move = toInternal(x, y);
+    return true;
+}
+
+void GomocupEngine::newGame(int newWidth, int newHeight) {
+    width = newWidth;
+    height = newHeight;
+    board = GameBoard();
+    bot = make_unique<TicTacToeBot>(settings.difficulty, OWN);
+
+    Position low = toInternal(0, 0);
+    Position high = toInternal(width - 1, height - 1);
+    bot->setPlayingArea(low.x, low.y, high.x, high.y);
+}
+
+// Запас на ввод-вывод и проверку ходов; на матч - доля оставшегося времени
+chrono::milliseconds GomocupEngine::moveBudget() const {
+    const long long safetyMs = 30;
+    const long long expectedMoves = 20;
+
+    long long budget = 0;
+    if (timeoutTurn > 0) budget = timeoutTurn;
+    long long remaining = timeLeft > 0 ? timeLeft : timeoutMatch;
+    if (remaining > 0) {
+        long long share = remaining / expectedMoves;
+        budget = budget > 0 ? min(budget, share) : share;
+    }
+    if (budget <= 0) return chrono::milliseconds(0);
+    return chrono::milliseconds(max(1LL, budget - max(safetyMs, budget / 10)));
+}
+
+void GomocupEngine::think() {
+    chrono::milliseconds budget = moveBudget();
+    if (budget.count() > 0) {
+        bot->setTimeBudget(budget);
+        bot->setSearchDepth(64);
+    }
+
+    Position move = bot->getBestMove(board, settings.lineLength);
+
+    // Поиск вернул занятую клетку или вышел за поле: любая свободная клетка лучше проигрыша по ошибке
+    bool valid = board.get(move) == Cell::EMPTY && isInside(toProtocolX(move), toProtocolY(move));
+    for (int i = 0; !valid && i < width * height; i++) {
+        move = toInternal(i % width, i / width);
+        valid = board.get(move) == Cell::EMPTY;
+    }
+
+    board.set(move, OWN);
+    const SearchStats &stats = bot->getSearchStats();
+    cout << "DEBUG depth " << stats.depthReached << " nodes " << stats.nodes << " ms " << (int)stats.totalMs << "\n";
+    cout << toProtocolX(move) << "," << toProtocolY(move) << endl;
+}
+
+void GomocupEngine::handleInfo(const string &key, const string &value) {
+    if (key == "timeout_turn") timeoutTurn = atoll(value.c_str());
+    else if (key == "timeout_match") timeoutMatch = atoll(value.c_str());
+    else if (key == "time_left") timeLeft = atoll(value.c_str());
+    else if (key == "rule" && atoi(value.c_str()) != 0) {
+        // Как в основной игре, побеждает линия не короче lineLength; точная пятерка и ренджу не поддерживаются
+        cout << "MESSAGE rule " << value << " is not supported, playing freestyle" << endl;
+    }
+}
+
+// BOARD: строки "x,y,кто" до DONE; 1 - свой камень, 2 - соперника
+void GomocupEngine::readBoard() {
+    board = GameBoard();
+    string line;
+    while (getline(cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line == "DONE") break;
+
+        int x, y, who;
+        if (sscanf(line.c_str(), "%d,%d,%d", &x, &y, &who) != 3 || !isInside(x, y)) continue;
+        if (who == 1) board.set(toInternal(x, y), OWN);
+        else if (who == 2) board.set(toInternal(x, y), OPPONENT);
+    }
+    think();
+}
+
+void GomocupEngine::run() {
+    string line;
+    while (getline(cin, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        stringstream stream(line);
+        string command, argument;
+        stream >> command;
+        getline(stream >> ws, argument);
+        for (auto &c : command) c = toupper((unsigned char)c);
+
+        if (command == "START") {
+            int size = atoi(argument.c_str());
+            if (size < settings.lineLength) {
+                cout << "ERROR unsupported size " << argument << endl;
+                continue;
+            }
+            newGame(size, size);
+            cout << "OK" << endl;
+        } else if (command == "RECTSTART") {
+            int w = 0, h = 0;
+            if (sscanf(argument.c_str(), "%d,%d", &w, &h) != 2 || max(w, h) < settings.lineLength) {
+                cout << "ERROR unsupported size " << argument << endl;
+                continue;
+            }
+            newGame(w, h);
+            cout << "OK" << endl;
+        } else if (command == "RESTART") {
+            newGame(width, height);
+            cout << "OK" << endl;
+        } else if (!bot && command != "INFO" && command != "ABOUT" && command != "END") {
+            cout << "ERROR no START received" << endl;
+        } else if (command == "BEGIN") {
+            think();
+        } else if (command == "TURN") {
+            Position move;
+            if (!parseMove(argument, move) || board.get(move) != Cell::EMPTY) {
+                cout << "ERROR invalid move " << argument << endl;
+                continue;
+            }
+            board.set(move, OPPONENT);
+            think();
+        } else if (command == "BOARD") {
+            readBoard();
+        } else if (command == "TAKEBACK") {
+            Position move;
+            if (!parseMove(argument, move)) {
+                cout << "ERROR invalid move " << argument << endl;
+                continue;
+            }
+            board.erase(move);
+            cout << "OK" << endl;
+        } else if (command == "INFO") {
+            stringstream info(argument);
+            string key, value;
+            info >> key >> value;
+            handleInfo(key, value);
+        } else if (command == "ABOUT") {
+            cout << "name=\"InfiniteTicTacToe\", version=\"1.0\", author=\"InfiniteTicTacToe\", country=\"RU\"" << endl;
+        } else if (command == "END") {
+            break;
+        } else {
+            cout << "UNKNOWN " << command << endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    EngineSettings settings;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--level" && hasValue) {
+            string level = argv[++i];
+            if (level == "easy") settings.difficulty = BotDifficulty::EASY;
+            else if (level == "medium") settings.difficulty = BotDifficulty::MEDIUM;
+            else settings.difficulty = BotDifficulty::HARD;
+        }
+        else if (arg == "--length" && hasValue) settings.lineLength = max(3, atoi(argv[++i]));
+        else if (arg == "--book" && hasValue) settings.bookPath = argv[++i];
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (!settings.bookPath.empty() && !OpeningBook::shared().load(settings.bookPath)) {
+        cerr << "Failed to load " << settings.bookPath << endl;
+        return 1;
+    }
+
+    GomocupEngine engine(settings);
+    engine.run();
+    return 0;
+}
@@ -0,0 +1,486 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+
+// Нагрузка для match-server на одной машине: клиенты играют случайными ходами, не дожидаясь
+// ответа по одной партии, пока ходят в других (ходы идут конвейером).
+// Использование: loadgen [--host адрес] [--port N] [--unix путь] [--clients N] [--games N]
+//                        [--seconds N] [--mode classic|scoring|events] [--length N] [--target N]
+//                        [--bot easy|medium|hard|expert|none] [--max-moves N] [--seed N] [--spectators N]
+// --games - одновременных партий на клиента. Без бота клиент играет за обе стороны.
+// Задержка - от отправки MOVE до MOVED этого хода.
+// --spectators - соединений-зрителей на клиента, каждое смотрит все его партии: зритель собирает
+// поле из кадров и считает ошибкой пропуск хода или камень на занятой клетке.
+
+struct LoadSettings {
+    string host = "127.0.0.1";
+    int port = 7878;
+    string unixPath;
+    int clients = 4;
+    int games = 16;
+    int seconds = 10;
+    string mode = "classic";
+    int length = 5;
+    int target = 100;
+    string bot = "none";
+    int maxMoves = 150;
+    uint32_t seed = 1;
+    int spectators = 0;
+};
+
+struct LoadResult {
+    uint64_t gamesStarted = 0;
+    uint64_t gamesWon = 0;
+    uint64_t gamesAbandoned = 0;
+    uint64_t moves = 0;
+    uint64_t botMoves = 0;
+    uint64_t errors = 0;
+    vector<double> latencyUs;
+
+    uint64_t keyframes = 0;
+    uint64_t keyframeBytes = 0;
+    uint64_t deltas = 0;
+    uint64_t deltaBytes = 0;
+    uint64_t streamErrors = 0;
+};
+
+// Партия глазами клиента: свои сведения о поле нужны только чтобы реже попадать в занятые клетки
+struct ClientGame {
+    unordered_set<uint64_t> stones;
+    int moves = 0;
+    bool ready = false;
+    bool waiting = false;
+    chrono::steady_clock::time_point sentAt;
+};
+
+// Без ядра игры: координаты клиенту нужны только как пара чисел
+struct Position {
+    int x, y;
+};
+
+static uint64_t stoneKey(int x, int y) { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+// Поле глазами зрителя, собранное из KEY и DELTA
+struct SpectatorView {
+    unordered_map<uint64_t, char> cells;
+    uint64_t moveCount = 0;
+};
+
+static int connectToServer(const LoadSettings &settings) {
+    if (!settings.unixPath.empty()) {
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (settings.unixPath.size() >= sizeof(address.sun_path)) return -1;
+        strcpy(address.sun_path, settings.unixPath.c_str());
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)settings.port);
+    if (inet_pton(AF_INET, settings.host.c_str(), &address.sin_addr) != 1) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) == 0) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+static bool sendAll(int fd, const string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t written = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        sent += (size_t)written;
+    }
+    return true;
+}
+
+class SpectatorClient {
+    private:
+        LoadResult &result;
+        int fd;
+        string input;
+        unordered_map<uint64_t, SpectatorView> views;
+
+        void handleLine(const string &line);
+        void applyKeyframe(istringstream &stream, uint64_t id);
+        void applyDelta(istringstream &stream, uint64_t id);
+
+    public:
+        SpectatorClient(LoadResult &result, int fd): result(result), fd(fd) {}
+        ~SpectatorClient() { if (fd >= 0) close(fd); }
+        SpectatorClient(const SpectatorClient &) = delete;
+        SpectatorClient& operator=(const SpectatorClient &) = delete;
+
+        int descriptor() const { return fd; }
+        bool watch(uint64_t id) { return sendAll(fd, "WATCH " + to_string(id) + "\n"); }
+        bool receive();
+};
+
+void SpectatorClient::applyKeyframe(istringstream &stream, uint64_t id) {
+    SpectatorView &view = views[id];
+    string mode, toMove;
+    int length, target, scoreX, scoreO;
+    size_t stones;
+    stream >> view.moveCount >> mode >> length >> target >> toMove >> scoreX >> scoreO >> stones;
+    view.cells.clear();
+    for (size_t i = 0; i < stones; i++) {
+        int x, y;
+        string side;
+        stream >> x >> y >> side;
+        view.cells[stoneKey(x, y)] = side[0];
+    }
+}
+
+void SpectatorClient::applyDelta(istringstream &stream, uint64_t id) {
+    auto it = views.find(id);
+    if (it == views.end()) {
+        result.streamErrors++;
+        return;
+    }
+    SpectatorView &view = it->second;
+    uint64_t moveCount;
+    int x, y;
+    string side, toMove, nextEvent;
+    stream >> moveCount >> side >> x >> y >> toMove >> nextEvent;
+    if (moveCount != view.moveCount + 1 || !view.cells.emplace(stoneKey(x, y), side[0]).second) result.streamErrors++;
+    view.moveCount = moveCount;
+
+    // Необязательные части идут в порядке розыгрыша: камень, стирание, смена сторон
+    string tag;
+    while (stream >> tag) {
+        if (tag == "event") stream >> tag;
+        else if (tag == "erase") {
+            size_t count;
+            stream >> count;
+            for (size_t i = 0; i < count; i++) {
+                stream >> x >> y;
+                if (!view.cells.erase(stoneKey(x, y))) result.streamErrors++;
+            }
+        } else if (tag == "swap") {
+            for (auto &cell : view.cells) cell.second = cell.second == 'X' ? 'O' : 'X';
+        } else if (tag == "score") {
+            int scoreX, scoreO;
+            stream >> scoreX >> scoreO;
+        }
+    }
+}
+
+void SpectatorClient::handleLine(const string &line) {
+    istringstream stream(line);
+    string verb;
+    uint64_t id = 0;
+    stream >> verb >> id;
+    if (verb == "KEY") {
+        result.keyframes++;
+        result.keyframeBytes += line.size() + 1;
+        applyKeyframe(stream, id);
+    } else if (verb == "DELTA") {
+        result.deltas++;
+        result.deltaBytes += line.size() + 1;
+        applyDelta(stream, id);
+    } else if (verb == "END") {
+        views.erase(id);
+    }
+}
+
+// Читает все, что пришло; false - сервер закрыл соединение
+bool SpectatorClient::receive() {
+    char buffer[65536];
+    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) return false;
+    input.append(buffer, (size_t)received);
+
+    size_t start = 0;
+    for (size_t end = input.find('\n'); end != string::npos; end = input.find('\n', start)) {
+        handleLine(input.substr(start, end - start));
+        start = end + 1;
+    }
+    input.erase(0, start);
+    return true;
+}
+
+class LoadClient {
+    private:
+        const LoadSettings &settings;
+        LoadResult &result;
+        mt19937 rng;
+        int fd;
+        bool playsBothSides;
+        unordered_map<uint64_t, ClientGame> games;
+        vector<unique_ptr<SpectatorClient>> spectators;
+        string input;
+        string output;
+        bool draining;
+
+        void requestGame();
+        Position chooseMove(const ClientGame &game);
+        void handleLine(const string &line);
+        void sendMoves();
+
+    public:
+        LoadClient(const LoadSettings &settings, LoadResult &result, uint32_t seed);
+        bool run();
+};
+
+LoadClient::LoadClient(const LoadSettings &settings, LoadResult &result, uint32_t seed):
+    settings(settings), result(result), rng(seed), fd(-1), playsBothSides(settings.bot == "none"), draining(false) {}
+
+void LoadClient::requestGame() {
+    output += "NEW " + settings.mode + " " + to_string(settings.length) + " " + to_string(settings.target) + " " +
+              (playsBothSides ? string("local") : "bot " + settings.bot) + "\n";
+    result.gamesStarted++;
+}
+
+// Случайная клетка в круге, который растет с числом камней: партии не расползаются по всему полю
+Position LoadClient::chooseMove(const ClientGame &game) {
+    int radius = 2 + (int)sqrt((double)game.stones.size());
+    uniform_int_distribution<int> coordinate(-radius, radius);
+    Position move = {0, 0};
+    for (int attempt = 0; attempt < 64; attempt++) {
+        move = {coordinate(rng), coordinate(rng)};
+        if (!game.stones.count(stoneKey(move.x, move.y))) break;
+    }
+    return move;
+}
+
+void LoadClient::handleLine(const string &line) {
+    istringstream stream(line);
+    string verb;
+    uint64_t id = 0;
+    stream >> verb >> id;
+
+    if (verb == "GAME") {
+        ClientGame &game = games[id];
+        game.ready = true;
+        for (auto &spectator : spectators) spectator->watch(id);
+    } else if (verb == "MOVED") {
+        auto it = games.find(id);
+        if (it == games.end()) return;
+        ClientGame &game = it->second;
+        int x, y;
+        string side, event, nextEvent, toMove;
+        stream >> x >> y >> side >> event >> nextEvent >> toMove;
+        game.stones.insert(stoneKey(x, y));
+        game.moves++;
+
+        bool ownMove = playsBothSides || side == "X";
+        if (ownMove && game.waiting) {
+            game.waiting = false;
+            result.latencyUs.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - game.sentAt).count());
+            result.moves++;
+        } else if (!ownMove) {
+            result.botMoves++;
+        }
+        game.ready = !game.waiting && toMove != "-" && (playsBothSides || toMove == "X");
+    } else if (verb == "WIN") {
+        // Брошенную партию клиент уже забыл и заменил
+        if (!games.erase(id)) return;
+        result.gamesWon++;
+        if (!draining) requestGame();
+    } else if (verb == "ERROR") {
+        string text;
+        getline(stream, text);
+        auto it = games.find(id);
+        // Клетку мог освободить или занять ход, о котором клиент еще не знает
+        if (it != games.end() && text == " occupied") {
+            it->second.waiting = false;
+            it->second.ready = true;
+            return;
+        }
+        result.errors++;
+        if (result.errors <= 5) cerr << "server: " << line << endl;
+    }
+}
+
+void LoadClient::sendMoves() {
+    auto now = chrono::steady_clock::now();
+    for (auto it = games.begin(); it != games.end();) {
+        ClientGame &game = it->second;
+        if (!game.ready) {
+            ++it;
+            continue;
+        }
+        // Долгие партии бросаем, чтобы нагрузка оставалась похожей на начало партий
+        if (game.moves >= settings.maxMoves) {
+            output += "LEAVE " + to_string(it->first) + "\n";
+            result.gamesAbandoned++;
+            it = games.erase(it);
+            if (!draining) requestGame();
+            continue;
+        }
+        Position move = chooseMove(game);
+        output += "MOVE " + to_string(it->first) + " " + to_string(move.x) + " " + to_string(move.y) + "\n";
+        game.ready = false;
+        game.waiting = true;
+        game.sentAt = now;
+        ++it;
+    }
+}
+
+bool LoadClient::run() {
+    fd = connectToServer(settings);
+    if (fd < 0) return false;
+    for (int i = 0; i < settings.spectators; i++) {
+        int spectatorFd = connectToServer(settings);
+        if (spectatorFd < 0) return false;
+        spectators.push_back(make_unique<SpectatorClient>(result, spectatorFd));
+    }
+
+    for (int i = 0; i < settings.games; i++) requestGame();
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(settings.seconds);
+
+    char buffer[65536];
+    while (true) {
+        if (!output.empty()) {
+            if (!sendAll(fd, output)) break;
+            output.clear();
+        }
+        if (!draining && chrono::steady_clock::now() >= deadline) {
+            draining = true;
+            output += "QUIT\n";
+            continue;
+        }
+
+        vector<pollfd> descriptors = {{fd, POLLIN, 0}};
+        for (auto &spectator : spectators) descriptors.push_back({spectator->descriptor(), POLLIN, 0});
+        if (poll(descriptors.data(), descriptors.size(), 100) <= 0) continue;
+        for (size_t i = 1; i < descriptors.size(); i++) {
+            if (descriptors[i].revents && !spectators[i - 1]->receive()) result.streamErrors++;
+        }
+        if (!(descriptors[0].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) break;
+        input.append(buffer, (size_t)received);
+
+        size_t start = 0;
+        bool finished = false;
+        for (size_t end = input.find('\n'); end != string::npos; end = input.find('\n', start)) {
+            string line = input.substr(start, end - start);
+            start = end + 1;
+            if (line == "BYE") finished = true;
+            else handleLine(line);
+        }
+        input.erase(0, start);
+        if (finished) break;
+        if (!draining) sendMoves();
+    }
+
+    close(fd);
+    return true;
+}
+
+static double percentile(vector<double> &values, double fraction) {
+    if (values.empty()) return 0;
+    size_t index = min(values.size() - 1, (size_t)(fraction * (values.size() - 1) + 0.5));
+    nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char *argv[]) {
+    LoadSettings settings;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--host" && hasValue) settings.host = argv[++i];
+        else if (arg == "--port" && hasValue) settings.port = atoi(argv[++i]);
+        else if (arg == "--unix" && hasValue) settings.unixPath = argv[++i];
+        else if (arg == "--clients" && hasValue) settings.clients = max(1, atoi(argv[++i]));
+        else if (arg == "--games" && hasValue) settings.games = max(1, atoi(argv[++i]));
+        else if (arg == "--seconds" && hasValue) settings.seconds = max(1, atoi(argv[++i]));
+        else if (arg == "--mode" && hasValue) settings.mode = argv[++i];
+        else if (arg == "--length" && hasValue) settings.length = max(3, atoi(argv[++i]));
+        else if (arg == "--target" && hasValue) settings.target = max(1, atoi(argv[++i]));
+        else if (arg == "--bot" && hasValue) settings.bot = argv[++i];
+        else if (arg == "--max-moves" && hasValue) settings.maxMoves = max(1, atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--spectators" && hasValue) settings.spectators = max(0, atoi(argv[++i]));
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    vector<LoadResult> results(settings.clients);
+    atomic<int> failed(0);
+    vector<thread> clients;
+    auto started = chrono::steady_clock::now();
+    for (int i = 0; i < settings.clients; i++) {
+        clients.emplace_back([&, i] {
+            LoadClient client(settings, results[i], settings.seed + i);
+            if (!client.run()) failed++;
+        });
+    }
+    for (auto &client : clients) client.join();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+
+    if (failed.load() == settings.clients) {
+        cerr << "Could not connect to the server" << endl;
+        return 1;
+    }
+
+    LoadResult total;
+    for (auto &result : results) {
+        total.gamesStarted += result.gamesStarted;
+        total.gamesWon += result.gamesWon;
+        total.gamesAbandoned += result.gamesAbandoned;
+        total.moves += result.moves;
+        total.botMoves += result.botMoves;
+        total.errors += result.errors;
+        total.latencyUs.insert(total.latencyUs.end(), result.latencyUs.begin(), result.latencyUs.end());
+        total.keyframes += result.keyframes;
+        total.keyframeBytes += result.keyframeBytes;
+        total.deltas += result.deltas;
+        total.deltaBytes += result.deltaBytes;
+        total.streamErrors += result.streamErrors;
+    }
+
+    double maxLatency = total.latencyUs.empty() ? 0 : *max_element(total.latencyUs.begin(), total.latencyUs.end());
+    cout << fixed << setprecision(1);
+    cout << "Clients: " << settings.clients - failed.load() << " x " << settings.games << " games, " << elapsed << " s\n";
+    cout << "Games: started " << total.gamesStarted << ", won " << total.gamesWon << ", abandoned " << total.gamesAbandoned << "\n";
+    cout << "Moves: " << total.moves << " (" << setprecision(0) << total.moves / elapsed << "/s)";
+    if (total.botMoves) cout << ", bot moves " << total.botMoves << " (" << total.botMoves / elapsed << "/s)";
+    cout << ", errors " << total.errors << "\n";
+    cout << setprecision(3) << "Move latency ms: p50 " << percentile(total.latencyUs, 0.50) / 1000
+         << "  p95 " << percentile(total.latencyUs, 0.95) / 1000 << "  p99 " << percentile(total.latencyUs, 0.99) / 1000
+         << "  max " << maxLatency / 1000 << "\n";
+    if (settings.spectators > 0) {
+        cout << setprecision(0) << "Spectator frames: " << total.deltas << " deltas (" << total.deltas / elapsed << "/s, avg "
+             << (double)total.deltaBytes / max<uint64_t>(1, total.deltas) << " B), " << total.keyframes << " keyframes (avg "
+             << (double)total.keyframeBytes / max<uint64_t>(1, total.keyframes) << " B), stream errors " << total.streamErrors << "\n";
+    }
+    return total.errors == 0 && total.streamErrors == 0 ? 0 : 2;
+}
@@ -0,0 +1,851 @@
+#include "../Game/GameBoard/SpectatorStream.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+using namespace std;
+
+
+// Сервер партий для локальной сети: тысячи партий в одном процессе, без SFML. Только Linux (epoll).
+// Использование: match-server [--port N] [--bind адрес] [--unix путь] [--workers N] [--bot-threads N] [--max-games N]
+// Протокол построчный, клиент -> сервер:
+//   NEW classic|scoring|events ДЛИНА ЦЕЛЬ local|remote|bot [easy|medium|hard|expert]
+//   JOIN id | MOVE id x y | STATE id | LEAVE id | WATCH id | UNWATCH id | PING | STATS | QUIT
+// Сервер -> клиент:
+//   GAME id X|O|XO            - партия создана или к ней присоединились, стороны этого клиента
+//   JOINED id                 - к удаленной партии присоединился соперник
+//   MOVED id x y сторона событие следующее очередь|- счетX счетO
+//   WIN id X|O|- line|score|resign
+//   STATE id режим длина цель очередь ходов счетX счетO камней [x y сторона]...
+//   ERROR id текст | PONG | STATS ... | BYE
+//   KEY, DELTA, END           - кадры для зрителей (WATCH), формат в SpectatorStream.hpp
+// Поток ввода-вывода один, на epoll. Партии разделены между рабочими потоками по id: у каждого
+// своя очередь заданий, и состояние партии никогда не трогают два потока. Ходы ботов считает
+// отдельный пул, чтобы долгий поиск не задерживал ни сеть, ни чужие партии.
+
+struct ServerSettings {
+    int port = 7878;
+    string bindAddress = "127.0.0.1";
+    string unixPath;
+    int workers = 0;
+    int botThreads = 0;
+    size_t maxGames = 100000;
+};
+
+// Очередь заданий потока; stop() выбрасывает невыполненные
+class JobQueue {
+    private:
+        mutex lock;
+        condition_variable ready;
+        deque<function<void()>> jobs;
+        bool stopped = false;
+
+    public:
+        void push(function<void()> job) {
+            {
+                lock_guard<mutex> guard(lock);
+                if (stopped) return;
+                jobs.push_back(move(job));
+            }
+            ready.notify_one();
+        }
+
+        bool pop(function<void()> &job) {
+            unique_lock<mutex> guard(lock);
+            ready.wait(guard, [this] { return stopped || !jobs.empty(); });
+            if (stopped) return false;
+            job = move(jobs.front());
+            jobs.pop_front();
+            return true;
+        }
+
+        void stop() {
+            {
+                lock_guard<mutex> guard(lock);
+                stopped = true;
+                jobs.clear();
+            }
+            ready.notify_all();
+        }
+
+        size_t size() {
+            lock_guard<mutex> guard(lock);
+            return jobs.size();
+        }
+};
+
+// Партия на сервере. Сама игра - без бота: за ход бота отвечает пул, а не объект партии,
+// поэтому на партию не заводится своя таблица транспозиций
+struct ServerGame {
+    unique_ptr<InfiniteTicTacToe> game;
+    uint64_t players[2] = {0, 0};
+    bool local = false;
+    bool remote = false;
+    bool botOpponent = false;
+    BotDifficulty difficulty = BotDifficulty::MEDIUM;
+    bool botThinking = false;
+    // Заводится с первым зрителем
+    unique_ptr<SpectatorStream> spectators;
+};
+
+// Рабочий поток владеет своими партиями целиком
+struct Shard {
+    JobQueue queue;
+    unordered_map<uint64_t, ServerGame> games;
+    thread worker;
+};
+
+// Соединение живет только в потоке ввода-вывода. Исходящие сообщения - общие неизменяемые
+// буферы: одно и то же сообщение обоим игрокам уходит без копирования
+struct Connection {
+    int fd = -1;
+    string input;
+    deque<shared_ptr<const string>> output;
+    size_t outputOffset = 0;
+    size_t queuedBytes = 0;
+    bool writable = true;
+    bool closing = false;
+};
+
+struct Outgoing {
+    uint64_t connection;
+    shared_ptr<const string> data;
+    bool close;
+};
+
+static constexpr size_t MAX_LINE = 4096;
+// Клиент, который не читает ответы, не должен съесть память сервера
+static constexpr size_t MAX_QUEUED_BYTES = 8 << 20;
+
+static int cellIndex(Cell side) { return side == Cell::X ? 0 : 1; }
+static bool parseMode(const string &name, GameMode &mode) {
+    if (name == "classic") mode = GameMode::CLASSIC;
+    else if (name == "scoring") mode = GameMode::SCORING;
+    else if (name == "events") mode = GameMode::RANDOM_EVENTS;
+    else return false;
+    return true;
+}
+
+static bool parseDifficulty(const string &name, BotDifficulty &difficulty) {
+    if (name == "easy") difficulty = BotDifficulty::EASY;
+    else if (name == "medium") difficulty = BotDifficulty::MEDIUM;
+    else if (name == "hard") difficulty = BotDifficulty::HARD;
+    else if (name == "expert") difficulty = BotDifficulty::EXPERT;
+    else return false;
+    return true;
+}
+
+static volatile sig_atomic_t stopRequested = 0;
+static int wakeDescriptor = -1;
+
+static void handleSignal(int) {
+    stopRequested = 1;
+    uint64_t one = 1;
+    if (write(wakeDescriptor, &one, sizeof(one)) < 0) {}
+}
+
+class MatchServer {
+    private:
+        ServerSettings settings;
+        int epollDescriptor;
+        int tcpListener;
+        int unixListener;
+        int wakeEvent;
+
+        // Идентификаторы epoll: служебные дескрипторы ниже FIRST_CONNECTION
+        static constexpr uint64_t TCP_LISTENER = 1;
+        static constexpr uint64_t UNIX_LISTENER = 2;
+        static constexpr uint64_t WAKE_EVENT = 3;
+        static constexpr uint64_t FIRST_CONNECTION = 16;
+
+        unordered_map<uint64_t, Connection> connections;
+        uint64_t nextConnection;
+        uint64_t nextGame;
+
+        // Ответы рабочих потоков ждут здесь, поток ввода-вывода будит eventfd
+        mutex outboxLock;
+        vector<Outgoing> outbox;
+
+        vector<unique_ptr<Shard>> shards;
+        JobQueue botQueue;
+        vector<thread> botWorkers;
+
+        atomic<uint64_t> activeGames;
+        atomic<uint64_t> finishedGames;
+        atomic<uint64_t> appliedMoves;
+        atomic<uint64_t> botMoves;
+        atomic<uint64_t> sentFrames;
+
+        // Поток ввода-вывода
+        bool listenTcp();
+        bool listenUnix();
+        void watch(int fd, uint64_t id, uint32_t events, int operation);
+        void acceptConnections(int listener);
+        void readConnection(uint64_t id);
+        void handleLine(uint64_t id, const string &line);
+        void deliverOutbox();
+        void enqueue(uint64_t id, Connection &connection, shared_ptr<const string> data);
+        void flush(uint64_t id);
+        void closeConnection(uint64_t id);
+
+        // Рабочие потоки
+        Shard& shardFor(uint64_t gameId) { return *shards[gameId % shards.size()]; }
+        void post(Outgoing message);
+        void send(uint64_t connection, string text, bool close = false);
+        void sendToPlayers(const ServerGame &entry, const shared_ptr<const string> &data);
+        void sendFrame(uint64_t connection, const StreamFrame &frame);
+        void watchGame(uint64_t connection, uint64_t gameId, ServerGame &entry);
+        void createGame(Shard &shard, uint64_t connection, uint64_t gameId, const string &line);
+        void handleGameCommand(Shard &shard, uint64_t connection, const string &verb, uint64_t gameId, const string &line);
+        bool playMove(Shard &shard, uint64_t gameId, ServerGame &entry, const Position &position);
+        void finishGame(Shard &shard, uint64_t gameId, ServerGame &entry, Cell winner, const char *reason);
+        void scheduleBot(Shard &shard, uint64_t gameId, ServerGame &entry);
+        void dropConnection(Shard &shard, uint64_t connection);
+        string describeState(uint64_t gameId, const ServerGame &entry) const;
+
+    public:
+        explicit MatchServer(const ServerSettings &settings);
+        ~MatchServer();
+        bool start();
+        void run();
+};
+
+MatchServer::MatchServer(const ServerSettings &settings):
+    settings(settings), epollDescriptor(-1), tcpListener(-1), unixListener(-1), wakeEvent(-1),
+    nextConnection(FIRST_CONNECTION), nextGame(1), activeGames(0), finishedGames(0), appliedMoves(0), botMoves(0), sentFrames(0) {}
+
+MatchServer::~MatchServer() {
+    botQueue.stop();
+    for (auto &worker : botWorkers) worker.join();
+    for (auto &shard : shards) {
+        shard->queue.stop();
+        if (shard->worker.joinable()) shard->worker.join();
+    }
+
+    for (auto &[id, connection] : connections) ::close(connection.fd);
+    if (tcpListener >= 0) ::close(tcpListener);
+    if (unixListener >= 0) {
+        ::close(unixListener);
+        unlink(settings.unixPath.c_str());
+    }
+    if (wakeEvent >= 0) ::close(wakeEvent);
+    if (epollDescriptor >= 0) ::close(epollDescriptor);
+}
+
+bool MatchServer::listenTcp() {
+    tcpListener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (tcpListener < 0) return false;
+    int one = 1;
+    setsockopt(tcpListener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)settings.port);
+    if (inet_pton(AF_INET, settings.bindAddress.c_str(), &address.sin_addr) != 1) return false;
+    if (bind(tcpListener, (sockaddr*)&address, sizeof(address)) < 0 || listen(tcpListener, SOMAXCONN) < 0) return false;
+    watch(tcpListener, TCP_LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+    return true;
+}
+
+bool MatchServer::listenUnix() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (settings.unixPath.size() >= sizeof(address.sun_path)) return false;
+    strcpy(address.sun_path, settings.unixPath.c_str());
+
+    unixListener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (unixListener < 0) return false;
+    // Сокет от прошлого запуска мешает bind
+    unlink(settings.unixPath.c_str());
+    if (bind(unixListener, (sockaddr*)&address, sizeof(address)) < 0 || listen(unixListener, SOMAXCONN) < 0) return false;
+    watch(unixListener, UNIX_LISTENER, EPOLLIN, EPOLL_CTL_ADD);
+    return true;
+}
+
+void MatchServer::watch(int fd, uint64_t id, uint32_t events, int operation) {
+    epoll_event event = {};
+    event.events = events;
+    event.data.u64 = id;
+    epoll_ctl(epollDescriptor, operation, fd, &event);
+}
+
+bool MatchServer::start() {
+    epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    wakeEvent = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollDescriptor < 0 || wakeEvent < 0) return false;
+    watch(wakeEvent, WAKE_EVENT, EPOLLIN, EPOLL_CTL_ADD);
+
+    if (!listenTcp()) {
+        cerr << "Failed to listen on " << settings.bindAddress << ":" << settings.port << ": " << strerror(errno) << endl;
+        return false;
+    }
+    if (!settings.unixPath.empty() && !listenUnix()) {
+        cerr << "Failed to listen on " << settings.unixPath << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    unsigned cores = max(1u, thread::hardware_concurrency());
+    int workerCount = settings.workers > 0 ? settings.workers : max(1u, cores / 2);
+    int botCount = settings.botThreads > 0 ? settings.botThreads : cores;
+
+    for (int i = 0; i < workerCount; i++) {
+        shards.push_back(make_unique<Shard>());
+        Shard *shard = shards.back().get();
+        shard->worker = thread([shard] {
+            function<void()> job;
+            while (shard->queue.pop(job)) job();
+        });
+    }
+    for (int i = 0; i < botCount; i++) {
+        botWorkers.emplace_back([this] {
+            function<void()> job;
+            while (botQueue.pop(job)) job();
+        });
+    }
+
+    cout << "Listening on " << settings.bindAddress << ":" << settings.port;
+    if (!settings.unixPath.empty()) cout << " and " << settings.unixPath;
+    cout << ", " << workerCount << " game workers, " << botCount << " bot threads" << endl;
+    return true;
+}
+
+void MatchServer::run() {
+    wakeDescriptor = wakeEvent;
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+    signal(SIGPIPE, SIG_IGN);
+
+    epoll_event events[256];
+    while (!stopRequested) {
+        int count = epoll_wait(epollDescriptor, events, 256, -1);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; i++) {
+            uint64_t id = events[i].data.u64;
+            if (id == TCP_LISTENER) acceptConnections(tcpListener);
+            else if (id == UNIX_LISTENER) acceptConnections(unixListener);
+            else if (id == WAKE_EVENT) {
+                uint64_t counter;
+                while (read(wakeEvent, &counter, sizeof(counter)) > 0) {}
+                deliverOutbox();
+            } else {
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    closeConnection(id);
+                    continue;
+                }
+                if (events[i].events & EPOLLOUT) {
+                    auto it = connections.find(id);
+                    if (it != connections.end()) it->second.writable = true;
+                    flush(id);
+                }
+                if (events[i].events & EPOLLIN) readConnection(id);
+            }
+        }
+    }
+    cout << "Stopping, " << activeGames.load() << " games in progress dropped" << endl;
+}
+
+void MatchServer::acceptConnections(int listener) {
+    while (true) {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        int one = 1;
+        if (listener == tcpListener) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        uint64_t id = nextConnection++;
+        connections[id].fd = fd;
+        watch(fd, id, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+    }
+}
+
+void MatchServer::readConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection &connection = it->second;
+
+    char buffer[16384];
+    while (true) {
+        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            closeConnection(id);
+            return;
+        }
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (connection.closing) continue;
+        connection.input.append(buffer, (size_t)received);
+
+        size_t start = 0;
+        for (size_t end = connection.input.find('\n'); end != string::npos; end = connection.input.find('\n', start)) {
+            size_t length = end - start;
+            if (length > 0 && connection.input[end - 1] == '\r') length--;
+            handleLine(id, connection.input.substr(start, length));
+            start = end + 1;
+            // Ответ мог закрыть соединение
+            if (connections.find(id) == connections.end()) return;
+        }
+        connection.input.erase(0, start);
+        if (connection.input.size() > MAX_LINE) {
+            enqueue(id, connection, make_shared<const string>("ERROR 0 line too long\n"));
+            connection.closing = true;
+            flush(id);
+            return;
+        }
+    }
+}
+
+void MatchServer::handleLine(uint64_t id, const string &line) {
+    Connection &connection = connections[id];
+    istringstream stream(line);
+    string verb;
+    stream >> verb;
+    if (verb.empty()) return;
+
+    if (verb == "PING") {
+        enqueue(id, connection, make_shared<const string>("PONG\n"));
+    } else if (verb == "QUIT") {
+        enqueue(id, connection, make_shared<const string>("BYE\n"));
+        connection.closing = true;
+    } else if (verb == "STATS") {
+        size_t botQueued = botQueue.size();
+        string text = "STATS connections " + to_string(connections.size()) + " games " + to_string(activeGames.load()) +
+                      " finished " + to_string(finishedGames.load()) + " moves " + to_string(appliedMoves.load()) +
+                      " botmoves " + to_string(botMoves.load()) + " botqueue " + to_string(botQueued) +
+                      " frames " + to_string(sentFrames.load()) + "\n";
+        enqueue(id, connection, make_shared<const string>(move(text)));
+    } else if (verb == "NEW") {
+        if (activeGames.load() >= settings.maxGames) {
+            enqueue(id, connection, make_shared<const string>("ERROR 0 server full\n"));
+        } else {
+            // id выдает только этот поток, рабочий поток узнает его вместе с заданием
+            uint64_t gameId = nextGame++;
+            Shard &shard = shardFor(gameId);
+            shard.queue.push([this, &shard, id, gameId, line] { createGame(shard, id, gameId, line); });
+        }
+    } else if (verb == "JOIN" || verb == "MOVE" || verb == "STATE" || verb == "LEAVE" ||
+               verb == "WATCH" || verb == "UNWATCH") {
+        uint64_t gameId = 0;
+        if (!(stream >> gameId) || gameId == 0) {
+            enqueue(id, connection, make_shared<const string>("ERROR 0 expected game id\n"));
+        } else {
+            Shard &shard = shardFor(gameId);
+            shard.queue.push([this, &shard, id, verb, gameId, line] { handleGameCommand(shard, id, verb, gameId, line); });
+        }
+    } else {
+        enqueue(id, connection, make_shared<const string>("ERROR 0 unknown command " + verb + "\n"));
+    }
+    flush(id);
+}
+
+void MatchServer::deliverOutbox() {
+    vector<Outgoing> batch;
+    {
+        lock_guard<mutex> guard(outboxLock);
+        batch.swap(outbox);
+    }
+
+    vector<uint64_t> touched;
+    for (auto &message : batch) {
+        auto it = connections.find(message.connection);
+        // Соединение уже закрыто: ответ никому не нужен
+        if (it == connections.end()) continue;
+        if (it->second.output.empty()) touched.push_back(message.connection);
+        enqueue(message.connection, it->second, move(message.data));
+        if (message.close) it->second.closing = true;
+    }
+    for (uint64_t id : touched) flush(id);
+}
+
+void MatchServer::enqueue(uint64_t id, Connection &connection, shared_ptr<const string> data) {
+    if (connection.closing) return;
+    connection.queuedBytes += data->size();
+    connection.output.push_back(move(data));
+    if (connection.queuedBytes > MAX_QUEUED_BYTES) {
+        cerr << "Connection " << id << " is not reading, dropping it" << endl;
+        connection.output.clear();
+        connection.queuedBytes = 0;
+        connection.closing = true;
+    }
+}
+
+// Пишет одним writev столько буферов, сколько примет сокет
+void MatchServer::flush(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection &connection = it->second;
+
+    while (connection.writable && !connection.output.empty()) {
+        iovec vectors[64];
+        int count = 0;
+        for (auto buffer = connection.output.begin(); buffer != connection.output.end() && count < 64; ++buffer, ++count) {
+            size_t skip = count == 0 ? connection.outputOffset : 0;
+            vectors[count].iov_base = (void*)((*buffer)->data() + skip);
+            vectors[count].iov_len = (*buffer)->size() - skip;
+        }
+
+        ssize_t written = writev(connection.fd, vectors, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                connection.writable = false;
+                watch(connection.fd, id, EPOLLIN | EPOLLOUT | EPOLLRDHUP, EPOLL_CTL_MOD);
+                return;
+            }
+            closeConnection(id);
+            return;
+        }
+
+        size_t remaining = (size_t)written;
+        connection.queuedBytes -= remaining;
+        while (remaining > 0) {
+            size_t left = connection.output.front()->size() - connection.outputOffset;
+            if (remaining < left) {
+                connection.outputOffset += remaining;
+                break;
+            }
+            remaining -= left;
+            connection.output.pop_front();
+            connection.outputOffset = 0;
+        }
+    }
+
+    if (connection.output.empty()) {
+        if (connection.closing) {
+            closeConnection(id);
+            return;
+        }
+        if (!connection.writable) {
+            connection.writable = true;
+            watch(connection.fd, id, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_MOD);
+        }
+    }
+}
+
+void MatchServer::closeConnection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    ::close(it->second.fd);
+    connections.erase(it);
+
+    // Партии этого клиента могут быть в любом рабочем потоке
+    for (auto &shard : shards) {
+        Shard *target = shard.get();
+        target->queue.push([this, target, id] { dropConnection(*target, id); });
+    }
+}
+
+void MatchServer::send(uint64_t connection, string text, bool close) {
+    post(Outgoing{connection, make_shared<const string>(move(text)), close});
+}
+
+// Кадр зрителя уходит в очередь соединения тем же буфером, что и остальным зрителям
+void MatchServer::sendFrame(uint64_t connection, const StreamFrame &frame) {
+    sentFrames++;
+    post(Outgoing{connection, frame, false});
+}
+
+void MatchServer::post(Outgoing message) {
+    bool wasEmpty;
+    {
+        lock_guard<mutex> guard(outboxLock);
+        wasEmpty = outbox.empty();
+        outbox.push_back(move(message));
+    }
+    // Поток ввода-вывода разбирает ящик целиком, будить его нужно только для первого письма
+    if (wasEmpty) {
+        uint64_t one = 1;
+        if (write(wakeEvent, &one, sizeof(one)) < 0) {}
+    }
+}
+
+void MatchServer::sendToPlayers(const ServerGame &entry, const shared_ptr<const string> &data) {
+    bool wasEmpty;
+    {
+        lock_guard<mutex> guard(outboxLock);
+        wasEmpty = outbox.empty();
+        for (int side = 0; side < 2; side++) {
+            if (entry.players[side] == 0 || (side == 1 && entry.players[1] == entry.players[0])) continue;
+            outbox.push_back(Outgoing{entry.players[side], data, false});
+        }
+    }
+    if (wasEmpty) {
+        uint64_t one = 1;
+        if (write(wakeEvent, &one, sizeof(one)) < 0) {}
+    }
+}
+
+void MatchServer::createGame(Shard &shard, uint64_t connection, uint64_t gameId, const string &line) {
+    istringstream stream(line);
+    string verb, modeText, opponentText, levelText;
+    int length = 0, target = 0;
+    stream >> verb >> modeText >> length >> target >> opponentText >> levelText;
+
+    GameMode mode;
+    ServerGame entry;
+    if (!parseMode(modeText, mode)) {
+        send(connection, "ERROR 0 unknown mode, expected classic|scoring|events\n");
+        return;
+    }
+    if (length < 3 || length > 10 || target < 1 || target > 1000000) {
+        send(connection, "ERROR 0 bad length or target\n");
+        return;
+    }
+    if (opponentText == "local") entry.local = true;
+    else if (opponentText == "remote") entry.remote = true;
+    else if (opponentText == "bot") entry.botOpponent = true;
+    else {
+        send(connection, "ERROR 0 unknown opponent, expected local|remote|bot\n");
+        return;
+    }
+    if (entry.botOpponent && !levelText.empty() && !parseDifficulty(levelText, entry.difficulty)) {
+        send(connection, "ERROR 0 unknown bot level\n");
+        return;
+    }
+
+    // Часы на сервере не идут: партия на время требует клиента с часами, здесь ее нет
+    entry.game = make_unique<InfiniteTicTacToe>(mode, length, target);
+    entry.players[0] = connection;
+    if (entry.local) entry.players[1] = connection;
+
+    const char *sides = entry.local ? "XO" : "X";
+    shard.games.emplace(gameId, move(entry));
+    activeGames++;
+    send(connection, "GAME " + to_string(gameId) + " " + sides + "\n");
+}
+
+void MatchServer::handleGameCommand(Shard &shard, uint64_t connection, const string &verb, uint64_t gameId, const string &line) {
+    string prefix = "ERROR " + to_string(gameId) + " ";
+    auto it = shard.games.find(gameId);
+    if (it == shard.games.end()) {
+        send(connection, prefix + "no such game\n");
+        return;
+    }
+    ServerGame &entry = it->second;
+
+    if (verb == "STATE") {
+        send(connection, describeState(gameId, entry));
+        return;
+    }
+
+    if (verb == "WATCH") {
+        watchGame(connection, gameId, entry);
+        return;
+    }
+    if (verb == "UNWATCH") {
+        if (!entry.spectators || !entry.spectators->unsubscribe(connection)) send(connection, prefix + "not watching\n");
+        return;
+    }
+
+    if (verb == "JOIN") {
+        if (!entry.remote || entry.players[1] != 0) send(connection, prefix + "game is not open\n");
+        else if (entry.players[0] == connection) send(connection, prefix + "already playing\n");
+        else {
+            entry.players[1] = connection;
+            send(connection, "GAME " + to_string(gameId) + " O\n");
+            send(entry.players[0], "JOINED " + to_string(gameId) + "\n");
+        }
+        return;
+    }
+
+    bool isPlayer = entry.players[0] == connection || entry.players[1] == connection;
+    if (!isPlayer) {
+        send(connection, prefix + "not a player\n");
+        return;
+    }
+
+    if (verb == "LEAVE") {
+        // Сдается тот, кто ушел; в локальной партии победителя нет
+        Cell winner = Cell::EMPTY;
+        if (!entry.local) winner = entry.players[0] == connection ? Cell::O : Cell::X;
+        finishGame(shard, gameId, entry, winner, "resign");
+        return;
+    }
+
+    // MOVE id x y
+    istringstream stream(line);
+    string skipVerb;
+    uint64_t skipId;
+    int x, y;
+    if (!(stream >> skipVerb >> skipId >> x >> y)) {
+        send(connection, prefix + "expected MOVE id x y\n");
+        return;
+    }
+
+    Cell side = entry.game->getCurrentPlayer();
+    if (entry.botThinking || entry.players[cellIndex(side)] != connection) {
+        send(connection, prefix + "not your turn\n");
+        return;
+    }
+    if (!playMove(shard, gameId, entry, Position(x, y))) send(connection, prefix + "occupied\n");
+}
+
+// false - клетка занята. Партия после хода могла закончиться и исчезнуть из shard.games
+bool MatchServer::playMove(Shard &shard, uint64_t gameId, ServerGame &entry, const Position &position) {
+    InfiniteTicTacToe &game = *entry.game;
+    Cell side = game.getCurrentPlayer();
+    RandomEvent event = game.getNextEvent();
+    size_t movesBefore = game.getMoveHistory().size();
+
+    game.makeMove(position);
+    if (game.getMoveHistory().size() == movesBefore) return false;
+    appliedMoves++;
+
+    // После победного хода очереди нет: клиент не пошлет ход, не дочитав WIN
+    Cell toMove = game.isGameWon() ? Cell::EMPTY : game.getCurrentPlayer();
+    pair<int, int> score = game.getScore();
+    string text = "MOVED " + to_string(gameId) + " " + to_string(position.x) + " " + to_string(position.y) + " " + sideToken(side) +
+                  " " + eventToken(event) + " " + eventToken(game.getNextEvent()) + " " + sideToken(toMove) +
+                  " " + to_string(score.first) + " " + to_string(score.second) + "\n";
+    sendToPlayers(entry, make_shared<const string>(move(text)));
+    if (entry.spectators) entry.spectators->publishTurn(game);
+
+    if (game.isGameWon()) finishGame(shard, gameId, entry, game.getWinner(), game.isGameEndedByScore() ? "score" : "line");
+    else if (entry.botOpponent && game.getCurrentPlayer() == Cell::O) scheduleBot(shard, gameId, entry);
+    return true;
+}
+
+void MatchServer::finishGame(Shard &shard, uint64_t gameId, ServerGame &entry, Cell winner, const char *reason) {
+    string text = "WIN " + to_string(gameId) + " " + sideToken(winner) + " " + reason + "\n";
+    sendToPlayers(entry, make_shared<const string>(move(text)));
+    if (entry.spectators) entry.spectators->publishEnd(*entry.game, winner, reason);
+    shard.games.erase(gameId);
+    activeGames--;
+    finishedGames++;
+}
+
+// Зритель получает ключевой кадр и дельты после него, дальше - каждую дельту; поток партии
+// заводится с первым зрителем, партии без зрителей кадров не строят
+void MatchServer::watchGame(uint64_t connection, uint64_t gameId, ServerGame &entry) {
+    if (!entry.spectators) entry.spectators = make_unique<SpectatorStream>(gameId, *entry.game);
+    entry.spectators->unsubscribe(connection);
+    entry.spectators->subscribe(connection, [this, connection](const StreamFrame &frame) { sendFrame(connection, frame); });
+}
+
+// Боту уходит копия поля: партия остается во владении рабочего потока, пока идет поиск
+void MatchServer::scheduleBot(Shard &shard, uint64_t gameId, ServerGame &entry) {
+    entry.botThinking = true;
+    BotDifficulty difficulty = entry.difficulty;
+    int length = entry.game->getWinningLength();
+    size_t moveNumber = entry.game->getMoveHistory().size();
+
+    BotContext context = entry.game->getBotContext();
+    context.gameId = gameId;
+
+    botQueue.push([this, &shard, gameId, difficulty, length, moveNumber, context, board = entry.game->getBoard()] {
+        // Свой бот на поток, режим и уровень; бот сервера всегда играет ноликами, поэтому символ
+        // задается при создании: setSymbol очищает таблицу транспозиций (и дерево MCTS), а так
+        // таблица переживает ходы разных партий. Дерево MCTS сбрасывается по gameId при смене партии
+        thread_local unique_ptr<BotEngine> bots[4][4];
+        unique_ptr<BotEngine> &bot = bots[(int)context.mode][(int)difficulty];
+        if (!bot) bot = createBot(difficulty, Cell::O, context.mode);
+        bot->setContext(context);
+        Position best = bot->getBestMove(board, length);
+
+        shard.queue.push([this, &shard, gameId, moveNumber, best] {
+            auto it = shard.games.find(gameId);
+            // Партию бросили, пока бот думал
+            if (it == shard.games.end() || it->second.game->getMoveHistory().size() != moveNumber) return;
+            ServerGame &entry = it->second;
+            entry.botThinking = false;
+            botMoves++;
+            if (playMove(shard, gameId, entry, best)) return;
+
+            // Поиск вернул занятую клетку: лучше любая свободная рядом, чем зависшая партия
+            const GameBoard &board = entry.game->getBoard();
+            Position fallback = best;
+            for (int radius = 1; board.get(fallback) != Cell::EMPTY; radius++) {
+                for (int dy = -radius; dy <= radius && board.get(fallback) != Cell::EMPTY; dy++) {
+                    for (int dx = -radius; dx <= radius && board.get(fallback) != Cell::EMPTY; dx++) {
+                        fallback = Position(best.x + dx, best.y + dy);
+                    }
+                }
+            }
+            playMove(shard, gameId, entry, fallback);
+        });
+    });
+}
+
+void MatchServer::dropConnection(Shard &shard, uint64_t connection) {
+    for (auto it = shard.games.begin(); it != shard.games.end();) {
+        ServerGame &entry = it->second;
+        bool isPlayer = entry.players[0] == connection || entry.players[1] == connection;
+        if (!isPlayer) {
+            if (entry.spectators) entry.spectators->unsubscribe(connection);
+            ++it;
+            continue;
+        }
+        // Соперник в удаленной партии узнает, что выиграл
+        Cell winner = Cell::EMPTY;
+        if (entry.remote) {
+            if (entry.players[0] == connection) entry.players[0] = 0;
+            else entry.players[1] = 0;
+            winner = entry.players[0] != 0 ? Cell::X : (entry.players[1] != 0 ? Cell::O : Cell::EMPTY);
+            string text = "WIN " + to_string(it->first) + " " + sideToken(winner) + " resign\n";
+            sendToPlayers(entry, make_shared<const string>(move(text)));
+        }
+        if (entry.spectators) entry.spectators->publishEnd(*entry.game, winner, "resign");
+        it = shard.games.erase(it);
+        activeGames--;
+        finishedGames++;
+    }
+}
+
+string MatchServer::describeState(uint64_t gameId, const ServerGame &entry) const {
+    const InfiniteTicTacToe &game = *entry.game;
+    pair<int, int> score = game.getScore();
+    vector<Position> stones = game.getBoard().getOccupiedPositions();
+
+    ostringstream text;
+    text << "STATE " << gameId << " " << modeToken(game.getGameMode()) << " " << game.getWinningLength() << " "
+         << game.getTargetScore() << " " << sideToken(game.getCurrentPlayer()) << " " << game.getMoveHistory().size() << " "
+         << score.first << " " << score.second << " " << stones.size();
+    for (const Position &stone : stones) text << " " << stone.x << " " << stone.y << " " << sideToken(game.getBoard().get(stone));
+    text << "\n";
+    return text.str();
+}
+
+int main(int argc, char *argv[]) {
+    ServerSettings settings;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) settings.port = atoi(argv[++i]);
+        else if (arg == "--bind" && hasValue) settings.bindAddress = argv[++i];
+        else if (arg == "--unix" && hasValue) settings.unixPath = argv[++i];
+        else if (arg == "--workers" && hasValue) settings.workers = max(1, atoi(argv[++i]));
+        else if (arg == "--bot-threads" && hasValue) settings.botThreads = max(1, atoi(argv[++i]));
+        else if (arg == "--max-games" && hasValue) settings.maxGames = (size_t)max(1, atoi(argv[++i]));
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    MatchServer server(settings);
+    if (!server.start()) return 1;
+    server.run();
+    return 0;
+}
@@ -0,0 +1,172 @@
+#include "../Game/GameBoard/AI/TicTacToeBot.hpp"
+#include "../Game/GameBoard/AI/OpeningBook.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+
+// Построитель дебютной книги: самоигра HARD против HARD со случайными первыми ходами.
+// Использование: book_builder [партий] [файл] [длина линии] [ходов в книге] [seed]
+
+struct BookMove {
+    uint64_t key;
+    int x, y;
+
+    bool operator<(const BookMove &other) const {
+        if (key != other.key) return key < other.key;
+        if (x != other.x) return x < other.x;
+        return y < other.y;
+    }
+};
+
+struct BuilderSettings {
+    int games = 100;
+    string output = "opening_book.bin";
+    int lineLength = 5;
+    int bookPlies = 10;
+    int randomPlies = 2;
+    int maxMoves = 80;
+    uint32_t seed = 1;
+};
+
+static bool isWinningMove(const GameBoard &board, const Position &move, Cell player, int lineLength) {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+    for (const auto &dir : directions) {
+        int count = 1;
+        for (int i = 1; board.get(Position(move.x + dir.first * i, move.y + dir.second * i)) == player; i++) count++;
+        for (int i = 1; board.get(Position(move.x - dir.first * i, move.y - dir.second * i)) == player; i++) count++;
+        if (count >= lineLength) return true;
+    }
+
+    return false;
+}
+
+static void playGame(int gameIndex, const BuilderSettings &settings, map<BookMove, uint32_t> &weights, mutex &weightsMutex) {
+    mt19937 rng(settings.seed * 7919u + gameIndex);
+    GameBoard board;
+    Cell toMove = Cell::X;
+
+    TicTacToeBot botX(BotDifficulty::HARD, Cell::X);
+    TicTacToeBot botO(BotDifficulty::HARD, Cell::O);
+
+    struct Record { BookMove move; Cell player; };
+    vector<Record> records;
+    Cell winner = Cell::EMPTY;
+
+    for (int ply = 0; ply < settings.maxMoves; ply++) {
+        Position move;
+
+        if (ply == 0) {
+            move = Position(0, 0);
+        } else if (ply < settings.randomPlies) {
+            auto occupied = board.getOccupiedPositions();
+            do {
+                const Position &base = occupied[rng() % occupied.size()];
+                move = Position(base.x + (int)(rng() % 5) - 2, base.y + (int)(rng() % 5) - 2);
+            } while (board.get(move) != Cell::EMPTY);
+        } else {
+            TicTacToeBot &bot = (toMove == Cell::X) ? botX : botO;
+            move = bot.getBestMove(board, settings.lineLength);
+
+            if (ply < settings.bookPlies) {
+                PositionKey key = OpeningBook::makeKey(board, toMove);
+                Position canonical = key.transform.apply(move);
+                records.push_back({{key.hash, canonical.x, canonical.y}, toMove});
+            }
+        }
+
+        board.set(move, toMove);
+        if (isWinningMove(board, move, toMove, settings.lineLength)) {
+            winner = toMove;
+            break;
+        }
+        toMove = (toMove == Cell::X) ? Cell::O : Cell::X;
+    }
+
+    // Вес хода: 2 за победу сходившего, 1 за ничью
+    lock_guard<mutex> guard(weightsMutex);
+    for (const auto &record : records) {
+        uint32_t gain = (winner == Cell::EMPTY) ? 1 : (winner == record.player ? 2 : 0);
+        weights[record.move] += gain;
+    }
+}
+
+static bool writeBook(const BuilderSettings &settings, const map<BookMove, uint32_t> &weights) {
+    const size_t maxMovesPerPosition = 4;
+
+    vector<BookEntry> entries;
+    auto it = weights.begin();
+    while (it != weights.end()) {
+        uint64_t key = it->first.key;
+        vector<pair<uint32_t, BookMove>> moves;
+        for (; it != weights.end() && it->first.key == key; ++it) {
+            if (it->second > 0) moves.emplace_back(it->second, it->first);
+        }
+
+        sort(moves.begin(), moves.end(), [](const pair<uint32_t, BookMove> &a, const pair<uint32_t, BookMove> &b) {
+            return a.first > b.first;
+        });
+        if (moves.size() > maxMovesPerPosition) moves.resize(maxMovesPerPosition);
+
+        for (const auto &move : moves) {
+            BookEntry entry{};
+            entry.key = key;
+            entry.moveX = (int16_t)move.second.x;
+            entry.moveY = (int16_t)move.second.y;
+            entry.weight = (uint16_t)min<uint32_t>(move.first, 65535);
+            entries.push_back(entry);
+        }
+    }
+
+    BookHeader header{};
+    copy(begin(OpeningBook::MAGIC), end(OpeningBook::MAGIC), header.magic);
+    header.version = OpeningBook::VERSION;
+    header.lineLength = settings.lineLength;
+    header.entryCount = entries.size();
+
+    FILE *file = fopen(settings.output.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (!entries.empty()) ok = ok && fwrite(entries.data(), sizeof(BookEntry), entries.size(), file) == entries.size();
+    ok = (fclose(file) == 0) && ok;
+
+    cout << "Positions: " << weights.size() << ", entries: " << entries.size() << " -> " << settings.output << endl;
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    BuilderSettings settings;
+    if (argc > 1) settings.games = atoi(argv[1]);
+    if (argc > 2) settings.output = argv[2];
+    if (argc > 3) settings.lineLength = atoi(argv[3]);
+    if (argc > 4) settings.bookPlies = atoi(argv[4]);
+    if (argc > 5) settings.seed = (uint32_t)strtoul(argv[5], nullptr, 10);
+
+    map<BookMove, uint32_t> weights;
+    mutex weightsMutex;
+    atomic<int> nextGame(0);
+
+    auto worker = [&]() {
+        for (int game = nextGame++; game < settings.games; game = nextGame++) {
+            playGame(game, settings, weights, weightsMutex);
+        }
+    };
+
+    int threadCount = max(1u, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) threads.emplace_back(worker);
+    for (auto &t : threads) t.join();
+
+    if (!writeBook(settings, weights)) {
+        cerr << "Failed to write " << settings.output << endl;
+        return 1;
+    }
+    return 0;
+}
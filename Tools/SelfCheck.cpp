@@ -0,0 +1,514 @@
+#include "../Game/GameBoard/InfiniteTicTacToe.hpp"
+#include "../Game/GameBoard/PositionKey.hpp"
+#include "../Game/GameBoard/AI/TicTacToeBot.hpp"
+#include "../Game/GameBoard/Core/LineKernels.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+
+// Самопроверка детерминированных путей ядра против эталонных реализаций, без SFML:
+// инкрементальные ключи позиций - против пересчета и сдвигов, ядра AVX2 - против скалярных, оценка на
+// рабочем поле - против GameBoard, LineScoreTracker - против полного подсчета, запись партии,
+// журнал после сбоя и отмена с повтором - против той же партии, сыгранной заново.
+// Использование: selfcheck [--seed N] [--cases N]
+// Код возврата: 1, если хоть одна проверка не прошла.
+
+// Доступ к оценке и ключу таблицы транспозиций бота
+struct SelfCheckAccess {
+    template <typename Board>
+    static int evaluatePosition(const TicTacToeBot &bot, const Board &board, int lineLength) {
+        return bot.evaluatePosition(board, lineLength);
+    }
+    static uint64_t transpositionKey(const TicTacToeBot &bot, const PositionKey &key, Cell player) {
+        return bot.transpositionKey(key, player);
+    }
+};
+
+class CheckRunner {
+    private:
+        string name;
+        uint64_t cases;
+        uint64_t failures;
+        string firstFailure;
+        int failedChecks;
+
+    public:
+        CheckRunner(): cases(0), failures(0), failedChecks(0) {}
+
+        void begin(const string &checkName) {
+            name = checkName;
+            cases = failures = 0;
+            firstFailure.clear();
+        }
+
+        void expect(bool ok, const string &what) {
+            cases++;
+            if (ok) return;
+            if (failures++ == 0) firstFailure = what;
+        }
+
+        void end(const string &note = "") {
+            if (failures == 0) {
+                printf("%-28s ok      %8llu cases%s\n", name.c_str(), (unsigned long long)cases, note.c_str());
+                return;
+            }
+            failedChecks++;
+            printf("%-28s FAILED  %8llu of %llu cases, first: %s\n", name.c_str(), (unsigned long long)failures,
+                   (unsigned long long)cases, firstFailure.c_str());
+        }
+
+        int getFailedChecks() const { return failedChecks; }
+};
+
+struct SelfCheckSettings {
+    uint32_t seed = 1;
+    int cases = 200;
+};
+
+static Cell opposite(Cell cell) {
+    return cell == Cell::X ? Cell::O : Cell::X;
+}
+
+static string describe(const Position &pos) {
+    return "(" + to_string(pos.x) + ", " + to_string(pos.y) + ")";
+}
+
+// Пустая клетка рядом со случайным камнем; на пустом поле - центр
+static Position randomMove(const GameBoard &board, mt19937 &rng) {
+    vector<Position> occupied = board.getOccupiedPositions();
+    if (occupied.empty()) return Position(0, 0);
+    while (true) {
+        const Position &stone = occupied[rng() % occupied.size()];
+        Position move(stone.x + (int)(rng() % 5) - 2, stone.y + (int)(rng() % 5) - 2);
+        if (board.get(move) == Cell::EMPTY) return move;
+    }
+}
+
+static GameBoard randomBoard(mt19937 &rng, int stones, int spread) {
+    GameBoard board;
+    for (int i = 0; i < stones; i++) {
+        Position pos((int)(rng() % spread) - spread / 2, (int)(rng() % spread) - spread / 2);
+        if (board.get(pos) == Cell::EMPTY) board.set(pos, i % 2 == 0 ? Cell::X : Cell::O);
+    }
+    return board;
+}
+
+static GameBoard transformed(const GameBoard &board, const BoardTransform &transform) {
+    GameBoard result;
+    for (const auto &pos : board.getOccupiedPositions()) result.set(transform.inverse(pos), board.get(pos));
+    return result;
+}
+
+static bool sameStones(const GameBoard &a, const GameBoard &b) {
+    if (a.size() != b.size()) return false;
+    for (const auto &pos : a.getOccupiedPositions()) {
+        if (a.get(pos) != b.get(pos)) return false;
+    }
+    return true;
+}
+
+// Все наблюдаемое состояние партии без часов: поле, история, очередь, событие и счет
+static string describeGame(const InfiniteTicTacToe &game) {
+    vector<pair<pair<int, int>, Cell>> stones;
+    const GameBoard &board = game.getBoard();
+    for (const auto &pos : board.getOccupiedPositions()) stones.emplace_back(pos.toPair(), board.get(pos));
+    sort(stones.begin(), stones.end());
+
+    ostringstream text;
+    for (const auto &[pos, cell] : stones) text << pos.first << "," << pos.second << "," << (int)cell << ";";
+    text << " moves " << game.getMoveHistory().size() << " player " << (int)game.getCurrentPlayer()
+         << " event " << (int)game.getNextEvent() << " score " << game.getScore().first << "/" << game.getScore().second
+         << " bonus " << game.getBonusScore().first << "/" << game.getBonusScore().second
+         << " won " << game.isGameWon() << " winner " << (int)game.getWinner();
+    return text.str();
+}
+
+static void checkPositionKeys(CheckRunner &runner, const SelfCheckSettings &settings) {
+    mt19937 rng(settings.seed);
+
+    runner.begin("incremental key");
+    for (int c = 0; c < settings.cases * 10; c++) {
+        GameBoard board;
+        IncrementalKey key;
+        int stones = 1 + rng() % 40;
+        for (int i = 0; i < stones; i++) {
+            Position move = randomMove(board, rng);
+            Cell cell = i % 2 == 0 ? Cell::X : Cell::O;
+            board.set(move, cell);
+            key = key.with(move, cell);
+        }
+
+        PositionKey updated = key.key();
+        runner.expect(updated.hash == IncrementalKey(board).key().hash, "incremental key differs from rebuilt");
+        WorkspaceBoard workspace;
+        if (workspace.load(board)) runner.expect(updated.hash == IncrementalKey(workspace).key().hash, "workspace key differs");
+
+        // Сдвиг не меняет ключ, а система ключа переводит ходы между сдвигами
+        BoardTransform shift(0, (int)(rng() % 2001) - 1000, (int)(rng() % 2001) - 1000);
+        PositionKey shifted = IncrementalKey(transformed(board, shift)).key();
+        runner.expect(shifted.hash == updated.hash, "key depends on translation");
+        Position probe = randomMove(board, rng);
+        runner.expect(shifted.transform.inverse(updated.transform.apply(probe)) == shift.inverse(probe), "key frame maps moves wrongly");
+
+        GameBoard other = board;
+        other.set(randomMove(board, rng), stones % 2 == 0 ? Cell::X : Cell::O);
+        runner.expect(IncrementalKey(other).key().hash != updated.hash, "different positions share a key");
+    }
+    runner.end();
+
+    // Ключ дебютной книги: сдвиг и любая из 8 симметрий дают тот же ключ, и ход переводится вместе с позицией
+    runner.begin("canonical book key");
+    for (int c = 0; c < settings.cases * 5; c++) {
+        GameBoard board = randomBoard(rng, 2 + rng() % 12, 9);
+        BoardTransform image(rng() % 8, (int)(rng() % 201) - 100, (int)(rng() % 201) - 100);
+        GameBoard imageBoard = transformed(board, image);
+        runner.expect(computePositionKey(board, true).hash == computePositionKey(imageBoard, true).hash, "symmetric positions differ");
+
+        Position move = randomMove(board, rng);
+        board.set(move, Cell::X);
+        imageBoard.set(image.inverse(move), Cell::X);
+        runner.expect(computePositionKey(board, true).hash == computePositionKey(imageBoard, true).hash, "move is not carried by the symmetry");
+    }
+    runner.end();
+
+    // Таблица транспозиций делит записи между сдвигами, поэтому оценка от сдвига не зависит;
+    // на ограниченном поле ходы зависят от границ, и сдвиг входит в ключ
+    runner.begin("transposition soundness");
+    TicTacToeBot bot(BotDifficulty::HARD, Cell::O), boundedBot(BotDifficulty::HARD, Cell::O);
+    boundedBot.setPlayingArea(-1000, -1000, 1000, 1000);
+    for (int c = 0; c < settings.cases * 5; c++) {
+        GameBoard board = randomBoard(rng, 1 + rng() % 40, 9 + rng() % 12);
+        BoardTransform shift(0, (int)(rng() % 401) - 200, (int)(rng() % 401) - 200);
+        if (shift.offsetX == 0 && shift.offsetY == 0) continue;
+        GameBoard shifted = transformed(board, shift);
+        int lineLength = 4 + rng() % 3;
+
+        int reference = SelfCheckAccess::evaluatePosition(bot, board, lineLength);
+        runner.expect(SelfCheckAccess::evaluatePosition(bot, shifted, lineLength) == reference, "evaluation depends on translation");
+        WorkspaceBoard workspace;
+        if (workspace.load(shifted)) {
+            runner.expect(SelfCheckAccess::evaluatePosition(bot, workspace, lineLength) == reference, "workspace evaluation depends on translation");
+        }
+
+        PositionKey key = IncrementalKey(board).key(), shiftedKey = IncrementalKey(shifted).key();
+        runner.expect(SelfCheckAccess::transpositionKey(bot, key, Cell::X) == SelfCheckAccess::transpositionKey(bot, shiftedKey, Cell::X),
+                      "shifted positions do not share an entry");
+        runner.expect(SelfCheckAccess::transpositionKey(bot, key, Cell::X) != SelfCheckAccess::transpositionKey(bot, key, Cell::O),
+                      "side to move is not in the key");
+        runner.expect(SelfCheckAccess::transpositionKey(boundedBot, key, Cell::X) != SelfCheckAccess::transpositionKey(boundedBot, shiftedKey, Cell::X),
+                      "bounded area shares an entry between shifts");
+    }
+    runner.end();
+}
+
+static BitRows randomRows(mt19937 &rng, int density) {
+    BitRows rows;
+    for (int row = 0; row < BIT_BOARD_ROWS; row++) {
+        uint64_t bits = ~0ULL;
+        for (int i = 0; i < density; i++) bits &= rng() | (uint64_t)rng() << 32;
+        rows[row] = bits;
+    }
+    return rows;
+}
+
+static bool sameRows(const BitRows &a, const BitRows &b) {
+    return equal(begin(a.padded), end(a.padded), begin(b.padded));
+}
+
+static void checkKernels(CheckRunner &runner, const SelfCheckSettings &settings) {
+    mt19937 rng(settings.seed + 1);
+    KernelIsa detected = getKernelIsa();
+    setKernelIsa(KernelIsa::AVX2);
+    bool hasAvx2 = getKernelIsa() == KernelIsa::AVX2;
+    constexpr int directions[4][2] = {{1, 0}, {0, 1}, {1, 1}, {1, -1}};
+
+    runner.begin("line kernels avx2/scalar");
+    for (int c = 0; hasAvx2 && c < settings.cases * 20; c++) {
+        BitRows own = randomRows(rng, 1 + rng() % 3);
+        BitRows blockers = randomRows(rng, 2 + rng() % 3);
+        for (int row = 0; row < BIT_BOARD_ROWS; row++) blockers[row] &= ~own[row];
+
+        int length = 2 + rng() % (MAX_KERNEL_LINE - 1);
+        int firstRow = rng() % BIT_BOARD_ROWS;
+        int lastRow = firstRow + rng() % (BIT_BOARD_ROWS - firstRow);
+        const int *dir = directions[rng() % 4];
+        int count = 1 + rng() % length;
+
+        bool lines[2];
+        static WindowTable windows[2];
+        BitRows masks[2], threats[2];
+        for (int isa = 0; isa < 2; isa++) {
+            setKernelIsa(isa == 0 ? KernelIsa::SCALAR : KernelIsa::AVX2);
+            lines[isa] = hasLine(own, length, firstRow, lastRow);
+            fill(&windows[isa][0][0], &windows[isa][0][0] + sizeof(WindowTable) / sizeof(uint64_t), 0x5A5A5A5A5A5A5A5AULL);
+            countWindows(own, blockers, length, dir[0], dir[1], count, firstRow, lastRow, windows[isa]);
+            windowMask(own, blockers, length, count, dir[0], dir[1], firstRow, lastRow, masks[isa]);
+            threatCells(own, blockers, length, firstRow, lastRow, threats[isa]);
+        }
+
+        string where = " (length " + to_string(length) + ", rows " + to_string(firstRow) + ".." + to_string(lastRow) + ")";
+        runner.expect(lines[0] == lines[1], "hasLine" + where);
+        runner.expect(equal(&windows[0][0][0], &windows[0][0][0] + sizeof(WindowTable) / sizeof(uint64_t), &windows[1][0][0]),
+                      "countWindows" + where);
+        runner.expect(sameRows(masks[0], masks[1]), "windowMask" + where);
+        runner.expect(sameRows(threats[0], threats[1]), "threatCells" + where);
+    }
+    runner.end(hasAvx2 ? "" : ", skipped: no AVX2");
+
+    // Оценка по битовым строкам рабочего поля против обхода линий на GameBoard, на обоих наборах ядер
+    runner.begin("evaluation workspace/board");
+    TicTacToeBot bot(BotDifficulty::HARD, Cell::O);
+    for (int c = 0; c < settings.cases * 5; c++) {
+        GameBoard board = randomBoard(rng, 1 + rng() % 60, 9 + rng() % 20);
+        int lineLength = 3 + rng() % 4;
+        WorkspaceBoard workspace;
+        if (!workspace.load(board) || !WorkspaceBoard::supportsLineLength(lineLength)) continue;
+
+        int reference = SelfCheckAccess::evaluatePosition(bot, board, lineLength);
+        for (KernelIsa isa : {KernelIsa::SCALAR, KernelIsa::AVX2}) {
+            setKernelIsa(isa);
+            int score = SelfCheckAccess::evaluatePosition(bot, workspace, lineLength);
+            runner.expect(score == reference, string(kernelIsaName(getKernelIsa())) + " evaluation " + to_string(score) +
+                          " vs " + to_string(reference));
+        }
+    }
+    runner.end();
+    setKernelIsa(detected);
+}
+
+static void checkLineScores(CheckRunner &runner, const SelfCheckSettings &settings) {
+    mt19937 rng(settings.seed + 2);
+
+    runner.begin("line score tracker");
+    for (int c = 0; c < settings.cases; c++) {
+        GameBoard board;
+        LineScoreTracker trackers[2] = {LineScoreTracker(Cell::X), LineScoreTracker(Cell::O)};
+        vector<pair<Position, LineScoreTracker::UndoLog>> placed;
+
+        for (int step = 0; step < 80; step++) {
+            // Изредка снимаем несколько последних камней, как отмена в поиске
+            if (!placed.empty() && rng() % 6 == 0) {
+                for (int undo = 1 + rng() % 3; undo > 0 && !placed.empty(); undo--) {
+                    auto &[pos, log] = placed.back();
+                    trackers[board.get(pos) == Cell::X ? 0 : 1].undo(log);
+                    board.erase(pos);
+                    placed.pop_back();
+                }
+            } else {
+                Cell player = rng() % 2 ? Cell::X : Cell::O;
+                LineScoreTracker &tracker = trackers[player == Cell::X ? 0 : 1];
+                Position move = randomMove(board, rng);
+                int before = tracker.getScore();
+                int delta = tracker.placeDelta(board, move);
+
+                placed.emplace_back(move, LineScoreTracker::UndoLog());
+                tracker.place(board, move, placed.back().second);
+                board.set(move, player);
+                runner.expect(tracker.getScore() - before == delta, "placeDelta differs from place at " + describe(move));
+            }
+            if (rng() % 20 == 0) {
+                for (const auto &pos : board.getOccupiedPositions()) board.set(pos, opposite(board.get(pos)));
+                trackers[0].swapStones(trackers[1]);
+                placed.clear();
+            }
+
+            for (int side = 0; side < 2; side++) {
+                Cell player = side == 0 ? Cell::X : Cell::O;
+                runner.expect(trackers[side].getScore() == calculateLineScore(board, player),
+                              "tracker " + to_string(trackers[side].getScore()) + " vs full " + to_string(calculateLineScore(board, player)));
+            }
+        }
+    }
+    runner.end();
+}
+
+// Партия с событиями из зерна: одинаковые ходы и зерно дают одинаковую партию
+static unique_ptr<InfiniteTicTacToe> makeGame(GameMode mode, uint32_t seed) {
+    auto game = make_unique<InfiniteTicTacToe>(mode, 4, 100000, chrono::seconds(60));
+    game->seedEvents(seed);
+    return game;
+}
+
+static void checkUndoRedo(CheckRunner &runner, const SelfCheckSettings &settings) {
+    mt19937 rng(settings.seed + 3);
+
+    runner.begin("undo/redo vs replay");
+    for (int c = 0; c < max(1, settings.cases / 10); c++) {
+        GameMode mode = c % 2 == 0 ? GameMode::RANDOM_EVENTS : GameMode::SCORING;
+        uint32_t seed = rng();
+        auto game = makeGame(mode, seed);
+
+        vector<string> states = {describeGame(*game)};
+        for (int ply = 0; ply < 60 && !game->isGameWon(); ply++) {
+            game->makeMove(randomMove(game->getBoard(), rng));
+            states.push_back(describeGame(*game));
+        }
+        vector<Position> moves = game->getMoveHistory();
+
+        for (size_t k = states.size() - 1; k-- > 0;) {
+            runner.expect(game->undo() && describeGame(*game) == states[k], "undo to move " + to_string(k));
+        }
+        for (size_t k = 1; k < states.size(); k++) {
+            runner.expect(game->redo() && describeGame(*game) == states[k], "redo to move " + to_string(k));
+        }
+
+        auto replay = makeGame(mode, seed);
+        for (size_t k = 0; k < moves.size(); k++) {
+            replay->makeMove(moves[k]);
+            runner.expect(describeGame(*replay) == states[k + 1], "replay at move " + to_string(k + 1));
+        }
+    }
+    runner.end();
+}
+
+static void checkRecord(CheckRunner &runner, const SelfCheckSettings &settings, const filesystem::path &directory) {
+    mt19937 rng(settings.seed + 4);
+    string path = (directory / "record.tttr").string();
+    string interrupted = (directory / "interrupted.tttr").string();
+
+    runner.begin("record round-trip");
+    for (int c = 0; c < max(1, settings.cases / 20); c++) {
+        auto game = makeGame(GameMode::RANDOM_EVENTS, rng());
+        if (!game->startRecording(path)) {
+            runner.expect(false, "cannot write " + path);
+            break;
+        }
+
+        vector<GameBoard> boards = {game->getBoard()};
+        vector<pair<int, int>> bonuses = {game->getBonusScore()};
+        for (int ply = 0; ply < 150 && !game->isGameWon(); ply++) {
+            game->makeMove(randomMove(game->getBoard(), rng));
+            boards.push_back(game->getBoard());
+            bonuses.push_back(game->getBonusScore());
+            // Файл прерванной партии: без оглавления, читается проходом по записям
+            if (ply == 100) filesystem::copy_file(path, interrupted, filesystem::copy_options::overwrite_existing);
+        }
+        game->stopRecording();
+
+        for (const string &file : {path, interrupted}) {
+            GameRecordReader reader;
+            if (!reader.open(file)) {
+                runner.expect(false, "cannot read " + file);
+                continue;
+            }
+            for (size_t k = 0; k <= reader.getMoveCount(); k++) {
+                ReplayState state;
+                bool ok = reader.seek(k, state) && state.moveCount == k && k < boards.size() &&
+                          sameStones(state.board, boards[k]) && state.bonusScore == bonuses[k];
+                runner.expect(ok, filesystem::path(file).filename().string() + " at move " + to_string(k));
+            }
+        }
+    }
+    runner.end();
+}
+
+static void copyDirectory(const filesystem::path &from, const filesystem::path &to) {
+    filesystem::remove_all(to);
+    filesystem::copy(from, to);
+}
+
+static void checkJournal(CheckRunner &runner, const SelfCheckSettings &settings, const filesystem::path &directory) {
+    mt19937 rng(settings.seed + 5);
+    filesystem::path live = directory / "journal";
+    filesystem::path crashed = directory / "crashed";
+
+    // Сбой в любой момент партии: копия каталога - то, что осталось бы на диске после падения процесса
+    runner.begin("journal crash recovery");
+    for (int c = 0; c < max(1, settings.cases / 20); c++) {
+        auto game = makeGame(GameMode::RANDOM_EVENTS, rng());
+        if (!game->startJournal(live.string())) {
+            runner.expect(false, "cannot write " + live.string());
+            break;
+        }
+
+        for (int ply = 0; ply < 200 && !game->isGameWon(); ply++) {
+            if (game->canUndo() && rng() % 8 == 0) game->undo();
+            else game->makeMove(randomMove(game->getBoard(), rng));
+            if (rng() % 10 != 0) continue;
+
+            copyDirectory(live, crashed);
+            InfiniteTicTacToe restored(GameMode::RANDOM_EVENTS, 4, 100000, chrono::seconds(60));
+            bool ok = restored.resumeJournal(crashed.string()) && describeGame(restored) == describeGame(*game);
+            // Генератор событий восстановлен вместе с полем: следующие ходы дают те же события
+            for (int next = 0; ok && next < 3 && !game->isGameWon(); next++) {
+                Position move = randomMove(game->getBoard(), rng);
+                game->makeMove(move);
+                restored.makeMove(move);
+                ok = describeGame(restored) == describeGame(*game);
+            }
+            runner.expect(ok, "resume at move " + to_string(game->getMoveHistory().size()));
+            restored.stopJournal(true);
+        }
+        game->stopJournal(true);
+    }
+    runner.end();
+
+    // Сбой между заменой снимка и новым журналом: старый журнал не повторяется поверх снимка
+    runner.begin("journal snapshot window");
+    for (int c = 0; c < max(1, settings.cases / 20); c++) {
+        filesystem::remove_all(live);
+        GameJournal journal;
+        RecordSettings recordSettings;
+        BinaryWriter state;
+        state.writeFixed32(rng());
+        uint64_t base = 1 + rng() % 50, extra = 2 + rng() % 10, rollback = 1 + rng() % extra;
+        bool ok = journal.open(live.string()) && journal.writeSnapshot(recordSettings, base, state);
+        for (uint64_t n = 1; ok && n <= extra; n++) {
+            JournalEntry entry;
+            entry.moveCount = base + n;
+            entry.move = Position((int)n, 0);
+            journal.append(entry);
+        }
+        journal.sync();
+        filesystem::copy_file(live / "journal.bin", directory / "stale.bin", filesystem::copy_options::overwrite_existing);
+        ok = ok && journal.writeSnapshot(recordSettings, base + extra - rollback, state);
+        journal.close();
+        filesystem::copy_file(directory / "stale.bin", live / "journal.bin", filesystem::copy_options::overwrite_existing);
+
+        JournalContents contents;
+        ok = ok && GameJournal::load(live.string(), contents);
+        runner.expect(ok && contents.snapshotMoves == base + extra - rollback && contents.tail.empty(), "stale journal replayed");
+    }
+    runner.end();
+}
+
+int main(int argc, char *argv[]) {
+    SelfCheckSettings settings;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue) settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--cases" && hasValue) settings.cases = max(1, atoi(argv[++i]));
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    filesystem::path directory = filesystem::temp_directory_path() / ("tictactoe-selfcheck-" + to_string(settings.seed));
+    filesystem::remove_all(directory);
+    filesystem::create_directories(directory);
+
+    CheckRunner runner;
+    checkPositionKeys(runner, settings);
+    checkKernels(runner, settings);
+    checkLineScores(runner, settings);
+    checkUndoRedo(runner, settings);
+    checkRecord(runner, settings, directory);
+    checkJournal(runner, settings, directory);
+
+    filesystem::remove_all(directory);
+    if (runner.getFailedChecks() > 0) {
+        cerr << runner.getFailedChecks() << " check(s) failed" << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,313 @@
+#include "../Game/GameBoard/AI/TicTacToeBot.hpp"
+#include "../Game/GameBoard/AI/MCTSBot.hpp"
+#include "../Game/GameBoard/AI/OpeningBook.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace std;
+
+
+// Турнир между двумя конфигурациями бота на ядре игры, без SFML.
+// Использование: tournament --a СПЕЦ --b СПЕЦ [--games N] [--length N] [--seed N]
+//                           [--opening-plies N] [--max-moves N] [--threads N] [--book файл]
+// СПЕЦ: уровень[,engine=pvs|mcts][,depth=N][,time=мс][,threads=N][,rave=0|1], например hard,time=200.
+// Партии идут парами с одним дебютом и сменой цвета; дебют не длиннее 49 ходов и не решает партию.
+
+struct EngineSpec {
+    string text;
+    BotDifficulty difficulty = BotDifficulty::MEDIUM;
+    bool mcts = false;
+    int depth = 0;
+    int timeMs = 0;
+    int threads = 1;
+    bool rave = true;
+};
+
+struct TournamentSettings {
+    EngineSpec a, b;
+    int games = 100;
+    int lineLength = 5;
+    int openingPlies = 4;
+    int maxMoves = 200;
+    int threads = 0;
+    uint32_t seed = 1;
+    string bookPath;
+};
+
+// Итоги с точки зрения движка A; время и узлы - отдельно по движкам
+struct TournamentResult {
+    int wins = 0, draws = 0, losses = 0;
+    uint64_t moves[2] = {0, 0};
+    uint64_t nodes[2] = {0, 0};
+    double moveMs[2] = {0, 0};
+    double searchMs[2] = {0, 0};
+};
+
+static bool parseDifficulty(const string &name, BotDifficulty &difficulty) {
+    if (name == "easy") difficulty = BotDifficulty::EASY;
+    else if (name == "medium") difficulty = BotDifficulty::MEDIUM;
+    else if (name == "hard") difficulty = BotDifficulty::HARD;
+    else if (name == "expert") difficulty = BotDifficulty::EXPERT;
+    else return false;
+    return true;
+}
+
+static bool parseSpec(const string &text, EngineSpec &spec) {
+    spec = EngineSpec();
+    spec.text = text;
+
+    stringstream stream(text);
+    string token;
+    if (!getline(stream, token, ',') || !parseDifficulty(token, spec.difficulty)) return false;
+    spec.mcts = spec.difficulty == BotDifficulty::EXPERT;
+
+    while (getline(stream, token, ',')) {
+        size_t eq = token.find('=');
+        if (eq == string::npos) return false;
+        string key = token.substr(0, eq);
+        string value = token.substr(eq + 1);
+
+        if (key == "engine" && (value == "pvs" || value == "mcts")) spec.mcts = value == "mcts";
+        else if (key == "depth") spec.depth = atoi(value.c_str());
+        else if (key == "time") spec.timeMs = atoi(value.c_str());
+        else if (key == "threads") spec.threads = max(1, atoi(value.c_str()));
+        else if (key == "rave") spec.rave = value != "0";
+        else return false;
+    }
+    return true;
+}
+
+// MCTS по умолчанию однопоточный: параллельность дают одновременные партии
+static unique_ptr<BotEngine> createEngine(const EngineSpec &spec, Cell symbol) {
+    if (spec.mcts) {
+        auto bot = make_unique<MCTSBot>(spec.difficulty, symbol);
+        bot->setThreadCount(spec.threads);
+        bot->setRave(spec.rave);
+        if (spec.timeMs > 0) bot->setTimeBudget(chrono::milliseconds(spec.timeMs));
+        return bot;
+    }
+
+    auto bot = make_unique<TicTacToeBot>(spec.difficulty, symbol);
+    if (spec.timeMs > 0) {
+        // При ограничении времени глубину останавливают часы
+        bot->setTimeBudget(chrono::milliseconds(spec.timeMs));
+        bot->setSearchDepth(spec.depth > 0 ? spec.depth : 64);
+    } else if (spec.depth > 0) {
+        bot->setSearchDepth(spec.depth);
+    }
+    return bot;
+}
+
+static bool isWinningMove(const GameBoard &board, const Position &move, Cell player, int lineLength) {
+    constexpr array<pair<int, int>, 4> directions = {{ {1, 0}, {0, 1}, {1, 1}, {1, -1} }};
+
+    for (const auto &dir : directions) {
+        int count = 1;
+        for (int i = 1; board.get(Position(move.x + dir.first * i, move.y + dir.second * i)) == player; i++) count++;
+        for (int i = 1; board.get(Position(move.x - dir.first * i, move.y - dir.second * i)) == player; i++) count++;
+        if (count >= lineLength) return true;
+    }
+
+    return false;
+}
+
+// Дебют ставится в квадрат (2 * OPENING_RADIUS + 1)^2 у центра
+static constexpr int OPENING_RADIUS = 3;
+static constexpr int MAX_OPENING_PLIES = (2 * OPENING_RADIUS + 1) * (2 * OPENING_RADIUS + 1);
+
+// Победный ход для player найдется только рядом с квадратом дебюта
+static bool hasImmediateWin(const GameBoard &board, Cell player, int lineLength) {
+    int reach = OPENING_RADIUS + lineLength - 1;
+    for (int y = -reach; y <= reach; y++) {
+        for (int x = -reach; x <= reach; x++) {
+            Position cell(x, y);
+            if (board.get(cell) == Cell::EMPTY && isWinningMove(board, cell, player, lineLength)) return true;
+        }
+    }
+    return false;
+}
+
+// Случайный дебют у центра; одинаков для обеих партий пары. Ход, который выигрывает
+// или оставляет сопернику победу в один ход, перевыбирается: счет партии решают движки.
+// Если подходящих клеток не осталось, дебют короче запрошенного
+static vector<Position> makeOpening(uint32_t seed, int plies, int lineLength) {
+    mt19937 rng(seed);
+    GameBoard board;
+    vector<Position> opening;
+
+    vector<Position> cells;
+    for (int y = -OPENING_RADIUS; y <= OPENING_RADIUS; y++) {
+        for (int x = -OPENING_RADIUS; x <= OPENING_RADIUS; x++) cells.emplace_back(x, y);
+    }
+
+    for (int ply = 0; ply < plies; ply++) {
+        Cell player = (ply % 2 == 0) ? Cell::X : Cell::O;
+        Cell opponent = (player == Cell::X) ? Cell::O : Cell::X;
+        shuffle(cells.begin(), cells.end(), rng);
+
+        bool placed = false;
+        for (const auto &move : cells) {
+            if (board.get(move) != Cell::EMPTY || isWinningMove(board, move, player, lineLength)) continue;
+            board.set(move, player);
+            if (!hasImmediateWin(board, opponent, lineLength)) {
+                opening.push_back(move);
+                placed = true;
+                break;
+            }
+            board.erase(move);
+        }
+        if (!placed) break;
+    }
+    return opening;
+}
+
+// Возвращает победителя: 0 - движок A, 1 - движок B, -1 - ничья
+static int playGame(int gameIndex, const TournamentSettings &settings, TournamentResult &result, mutex &resultMutex) {
+    // В четных партиях A играет крестиками
+    int xEngine = gameIndex % 2;
+    const EngineSpec *specs[2] = {&settings.a, &settings.b};
+    unique_ptr<BotEngine> bots[2] = {
+        createEngine(*specs[xEngine], Cell::X),
+        createEngine(*specs[1 - xEngine], Cell::O)
+    };
+
+    TournamentResult local;
+    GameBoard board;
+    vector<Position> opening = makeOpening(settings.seed * 7919u + gameIndex / 2, settings.openingPlies, settings.lineLength);
+    int winner = -1;
+
+    for (int ply = 0; ply < settings.maxMoves; ply++) {
+        Cell toMove = (ply % 2 == 0) ? Cell::X : Cell::O;
+        int side = ply % 2;
+        int engine = side == 0 ? xEngine : 1 - xEngine;
+
+        Position move;
+        if (ply < (int)opening.size()) {
+            move = opening[ply];
+        } else {
+            auto start = chrono::steady_clock::now();
+            move = bots[side]->getBestMove(board, settings.lineLength);
+            const SearchStats &stats = bots[side]->getSearchStats();
+            local.moves[engine]++;
+            local.moveMs[engine] += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            local.nodes[engine] += stats.nodes;
+            local.searchMs[engine] += stats.searchMs;
+            if (board.get(move) != Cell::EMPTY) {
+                // Недопустимый ход - поражение
+                winner = 1 - engine;
+                break;
+            }
+        }
+
+        board.set(move, toMove);
+        if (isWinningMove(board, move, toMove, settings.lineLength)) {
+            winner = engine;
+            break;
+        }
+    }
+
+    lock_guard<mutex> guard(resultMutex);
+    if (winner == 0) result.wins++;
+    else if (winner == 1) result.losses++;
+    else result.draws++;
+    for (int engine = 0; engine < 2; engine++) {
+        result.moves[engine] += local.moves[engine];
+        result.nodes[engine] += local.nodes[engine];
+        result.moveMs[engine] += local.moveMs[engine];
+        result.searchMs[engine] += local.searchMs[engine];
+    }
+    return winner;
+}
+
+static double scoreToElo(double score) {
+    score = min(max(score, 1e-4), 1.0 - 1e-4);
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static void printReport(const TournamentSettings &settings, const TournamentResult &result) {
+    int games = result.wins + result.draws + result.losses;
+    double score = (result.wins + 0.5 * result.draws) / max(1, games);
+
+    // 95% интервал по выборочной дисперсии очков за партию
+    double variance = (result.wins * pow(1.0 - score, 2) + result.draws * pow(0.5 - score, 2) +
+                       result.losses * pow(score, 2)) / max(1, games);
+    double margin = 1.96 * sqrt(variance / max(1, games));
+    double elo = scoreToElo(score);
+    double eloLow = scoreToElo(score - margin);
+    double eloHigh = scoreToElo(score + margin);
+
+    cout << fixed << setprecision(1);
+    cout << "A: " << settings.a.text << "\nB: " << settings.b.text << "\n";
+    cout << "Games: " << games << "  A wins/draws/losses: " << result.wins << " / " << result.draws << " / " << result.losses
+         << "  score " << setprecision(3) << score << "\n";
+    cout << setprecision(1) << "Elo(A - B): " << elo << "  95% [" << eloLow << ", " << eloHigh << "]\n";
+
+    const char *names[2] = {"A", "B"};
+    for (int engine = 0; engine < 2; engine++) {
+        double avgMs = result.moves[engine] ? result.moveMs[engine] / result.moves[engine] : 0;
+        double nodesPerSecond = result.searchMs[engine] > 0 ? result.nodes[engine] / (result.searchMs[engine] / 1000.0) : 0;
+        cout << names[engine] << ": moves " << result.moves[engine] << ", avg move " << setprecision(2) << avgMs
+             << " ms, nodes/s " << setprecision(0) << nodesPerSecond << setprecision(1) << "\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    TournamentSettings settings;
+    string specA = "hard", specB = "medium";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--a" && hasValue) specA = argv[++i];
+        else if (arg == "--b" && hasValue) specB = argv[++i];
+        else if (arg == "--games" && hasValue) settings.games = max(1, atoi(argv[++i]));
+        else if (arg == "--length" && hasValue) settings.lineLength = max(3, atoi(argv[++i]));
+        else if (arg == "--seed" && hasValue) settings.seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--opening-plies" && hasValue) settings.openingPlies = min(max(0, atoi(argv[++i])), MAX_OPENING_PLIES);
+        else if (arg == "--max-moves" && hasValue) settings.maxMoves = max(1, atoi(argv[++i]));
+        else if (arg == "--threads" && hasValue) settings.threads = max(1, atoi(argv[++i]));
+        else if (arg == "--book" && hasValue) settings.bookPath = argv[++i];
+        else {
+            cerr << "Unknown argument: " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (!parseSpec(specA, settings.a) || !parseSpec(specB, settings.b)) {
+        cerr << "Bad engine spec, expected level[,engine=pvs|mcts][,depth=N][,time=ms][,threads=N][,rave=0|1]" << endl;
+        return 1;
+    }
+    if (!settings.bookPath.empty() && !OpeningBook::shared().load(settings.bookPath)) {
+        cerr << "Failed to load " << settings.bookPath << endl;
+        return 1;
+    }
+
+    TournamentResult result;
+    mutex resultMutex;
+    atomic<int> nextGame(0);
+    atomic<int> finished(0);
+
+    auto worker = [&]() {
+        for (int game = nextGame++; game < settings.games; game = nextGame++) {
+            int winner = playGame(game, settings, result, resultMutex);
+            int done = ++finished;
+            lock_guard<mutex> guard(resultMutex);
+            cerr << "\rgame " << done << "/" << settings.games << " " << (winner == 0 ? "A" : (winner == 1 ? "B" : "=")) << flush;
+        }
+    };
+
+    int threadCount = settings.threads > 0 ? settings.threads : max(1u, thread::hardware_concurrency());
+    vector<thread> threads;
+    for (int i = 0; i < threadCount; i++) threads.emplace_back(worker);
+    for (auto &t : threads) t.join();
+    cerr << endl;
+
+    printReport(settings, result);
+    return 0;
+}
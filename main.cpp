@@ -1,7 +1,31 @@
 #include "Game/Game.hpp"
+#include <cstring>
 
-int main() {
-    Game game;
-    game.run();
+int main(int argc, char *argv[]) {
+    const char *latencyLog = nullptr;
+    const char *replayPath = nullptr;
+    
+    // --trace [файл]: запись трассировки Chrome/Perfetto, сохраняется при выходе
+    // --latency-log [файл]: задержка клик -> экран по каждому клику и сводка при выходе
+    // --replay файл: просмотр записи партии из records/
+    for (int i = 1; i < argc; i++) {
+        bool hasPath = i + 1 < argc && argv[i + 1][0] != '-';
+        if (strcmp(argv[i], "--trace") == 0) {
+            Tracer::instance().start(hasPath ? argv[++i] : "trace.json");
+        } else if (strcmp(argv[i], "--latency-log") == 0) {
+            latencyLog = hasPath ? argv[++i] : "latency.log";
+        } else if (strcmp(argv[i], "--replay") == 0 && hasPath) {
+            replayPath = argv[++i];
+        }
+    }
+    
+    {
+        Game game;
+        if (latencyLog && !game.openLatencyLog(latencyLog)) cerr << "Failed to open " << latencyLog << endl;
+        if (replayPath && !game.openReplay(replayPath)) cerr << "Failed to open " << replayPath << endl;
+        game.run();
+    }
+    
+    if (!Tracer::instance().stop()) cerr << "Failed to write trace" << endl;
     return 0;
 }